@@ -2,6 +2,8 @@
 #define __ZCM_ARENA_H__
 
 #include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "common.h"
@@ -14,9 +16,17 @@ struct arena_block {
   alignas (max_align_t) uint8_t data[];
 };
 
+// malloc() only promises max_align_t, so a large allocation that needs more
+// is made with room to slide data up to align, and raw is what to free.
 struct arena_large_alloc {
   struct arena_large_alloc *prev;
   void *data;
+  void *raw;
+  size_t align;
+#ifdef ARENA_STATS
+  // so records still pack into whole max_align_t units
+  alignas (max_align_t) size_t size;
+#endif
 };
 
 #define ARENA_CONTEXT_DEFINITION \
@@ -33,16 +43,72 @@ struct arena_frame {
   struct arena_frame *prev;
 };
 
+// Recorded by arena_defer() in the arena itself, newest first. frame is the
+// frame that was on top when it was recorded, or NULL for none.
+struct arena_deferred {
+  struct arena_deferred *prev;
+  struct arena_frame *frame;
+  void (*fn)(void *);
+  void *arg;
+};
+
+// Chunks handed back with arena_free_sized() are kept on one list per size
+// class, ARENA_SIZE_CLASS bytes apart, and reused by allocations that fit.
+#define ARENA_SIZE_CLASS alignof (max_align_t)
+#define ARENA_SIZE_CLASSES 16
+
+struct arena_spares {
+  struct arena_block *blocks;
+  size_t size;
+  size_t limit;
+};
+
+// Kept up to date as the arena goes when ARENA_STATS is defined, which has to
+// be the same for the library and everything using it.
+struct arena_counters {
+  size_t used;
+  size_t padding;
+  size_t peak;
+};
+
 typedef struct arena {
   UNIFY_OBJECT_DEF(struct arena_context context, ARENA_CONTEXT_DEFINITION)
   uint8_t *end;
+  uint8_t *last;
   struct arena_frame *frame;
+  void *free_lists[ARENA_SIZE_CLASSES];
+  struct arena_spares spares;
+  uint8_t *reserved;
+  struct arena_deferred *deferred;
+#ifdef ARENA_STATS
+  struct arena_counters counters;
+#endif
 } arena;
 
 #define ARENA_DEFAULT_SIZE (64 * 1024)
+
+// Blocks that arena_pop() and arena_clear() let go of are kept for the next
+// time the arena grows, up to this many bytes of them, so a loop that pushes
+// and pops a frame stops going to malloc once it has warmed up.
+#define ARENA_DEFAULT_SPARE_LIMIT (16 * ARENA_DEFAULT_SIZE)
 #define ARENA_MINIMUM_SIZE (64 * sizeof (struct arena_large_alloc))
 
 FLYAPI arena *arena_new(size_t size);
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ARENA_HAS_MMAP 1
+#endif
+
+#define ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Reserves `reserve` bytes of address space for the arena's first block and
+// commits pages as the arena reaches them, 64K at a time, or a huge page at a
+// time when the reservation is at least ARENA_HUGE_PAGE_SIZE, in which case
+// it's also marked for transparent huge pages where the OS has them.
+// arena_pop() and arena_clear() give pages more than ARENA_DEFAULT_SIZE past
+// the new top back to the OS. Past the reservation, the arena grows the
+// usual way. Without mmap, this is just arena_new().
+FLYAPI arena *arena_new_mapped(size_t reserve);
 FLYAPI void arena_del(arena *a);
 
 __attribute__((alloc_size(2)))
@@ -58,20 +124,143 @@ __attribute__((alloc_size(2, 3)))
 FLYAPI void *arena_calloc_aligned(
     arena *a, size_t num, size_t size, size_t align);
 
+// The newest allocation grows or shrinks in place while the block has room,
+// and large allocations go through realloc(), keeping their alignment.
+// Anything else is copied to a
+// new allocation and the old one is freed as by arena_free_sized(). On
+// failure, NULL is returned and ptr is left as it was.
+__attribute__((alloc_size(4)))
+FLYAPI void *arena_realloc(
+    arena *a, void *ptr, size_t old_size, size_t new_size);
+
 #define arena_alloc_type(a, T) \
   (T *) arena_alloc_aligned((a), sizeof (T), alignof (T))
 
 #define arena_calloc_type(a, n, T) \
-  (T *) arena_calloc_type((a), (n), sizeof (T), alignof (T))
+  (T *) arena_calloc_aligned((a), (n), sizeof (T), alignof (T))
 
+// Gives memory back early. The most recent allocation is rolled back and
+// large allocations go straight back to malloc. Anything else is only reused
+// if its size is known: arena_free_sized() files it by size class for later
+// allocations, but arena_free() has to leave it until the arena is cleared.
+// So does arena_free_sized() with a chunk that isn't aligned for max_align_t.
+// arena_pop() and arena_clear() forget the size class lists.
 FLYAPI void arena_free(arena *a, void *ptr);
+FLYAPI void arena_free_sized(arena *a, void *ptr, size_t size);
 
 FLYAPI void arena_clear(arena *a);
 
+// Both free spare blocks past the new limit right away. Blocks an arena
+// can't keep, including all of its spares when it's deleted, go to a pool
+// shared by every arena, which keeps nothing until given a limit.
+FLYAPI void arena_set_spare_limit(arena *a, size_t bytes);
+FLYAPI void arena_set_global_spare_limit(size_t bytes);
+
 FLYAPI void arena_push(arena *a);
 FLYAPI void arena_pop(arena *a);
 FLYAPI void arena_commit(arena *a);
 
+// Calls fn(arg) when the frame on top goes, before its memory does, so arg
+// can live in the arena too: on arena_pop(), or on arena_clear() or
+// arena_del() if there's no frame. Calls run newest first, and a frame that's
+// committed hands its calls on to the one below it.
+FLYAPI void arena_defer(arena *a, void (*fn)(void *), void *arg);
+
+// Runs the statement after it in a frame of its own, popped at the end:
+//   ARENA_SCOPE(a) { ... }
+// Where ARENA_HAS_SCOPE_CLEANUP is defined, leaving early with break, return
+// or goto pops it too, before the caller sees anything returned from it.
+// Elsewhere nothing can, so the statement must not leave early. If the frame
+// can't be pushed, the statement doesn't run and fly_status says why.
+FLYAPI inline arena *arena_scope_begin(arena *a) {
+  arena_push(a);
+
+  return fly_status == FLY_OK ? a : NULL;
+}
+
+FLYAPI inline void arena_scope_end(arena **scope) {
+  if (*scope) {
+    arena_pop(*scope);
+    *scope = NULL;
+  }
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ARENA_HAS_SCOPE_CLEANUP 1
+#define ARENA_SCOPE_CLEANUP __attribute__((cleanup(arena_scope_end)))
+#else
+#define ARENA_SCOPE_CLEANUP
+#endif
+
+#define ARENA_SCOPE(a) \
+  for (arena *arena_scope_ ARENA_SCOPE_CLEANUP = arena_scope_begin(a); \
+       arena_scope_; \
+       arena_scope_end(&arena_scope_))
+
+// Used bytes count everything below the top of the current block, including
+// whatever was left at the end of earlier blocks, plus large allocations.
+// Reserved bytes are those of every block, spares included, plus large
+// allocations. Without ARENA_STATS, the sizes of large allocations aren't
+// kept, so they're left out, and padding and peak are 0. Padding is the
+// total skipped to align allocations since the arena was made, and peak is
+// the most used has been at once.
+struct arena_stats {
+  size_t used;
+  size_t reserved;
+  size_t blocks;
+  size_t large_allocs;
+  size_t large_bytes;
+  size_t padding;
+  size_t peak;
+  size_t frames;
+};
+
+FLYAPI void arena_stats(arena *a, struct arena_stats *out);
+
+// An array in an arena that grows by doubling. While it's the arena's newest
+// allocation it grows in place; otherwise it moves to the top of the arena
+// and the old copy is freed as by arena_free_sized(). It goes when the frame
+// it was started in is popped.
+typedef struct arena_vec {
+  arena *arena;
+  void *items;
+  size_t size;
+  size_t capacity;
+  size_t item_size;
+  size_t align;
+} arena_vec;
+
+#define ARENA_VEC_MIN_CAPACITY 8
+
+__attribute__((artificial))
+FLYAPI inline void arena_vec_init(
+    arena_vec *v, arena *a, size_t item_size, size_t align) {
+  *v = (arena_vec) {
+    .arena = a, .item_size = item_size ? item_size : 1, .align = align
+  };
+}
+
+#define arena_vec_init_type(v, a, T) \
+  arena_vec_init((v), (a), sizeof (T), alignof (T))
+
+// Fails with FLY_E_TOO_BIG if capacity items don't fit in a size_t.
+FLYAPI bool arena_vec_reserve(arena_vec *v, size_t capacity);
+
+// Both return the first new item, uninitialized, or NULL if it couldn't grow,
+// in which case the vector is left as it was.
+FLYAPI void *arena_vec_push(arena_vec *v);
+FLYAPI void *arena_vec_push_array(arena_vec *v, size_t n, const void *items);
+
+#define arena_vec_push_type(v, T) ((T *) arena_vec_push(v))
+#define arena_vec_at(v, T, i) (((T *) (v)->items)[i])
+
+// The calling thread's own arena, made on first use and kept, blocks and
+// all, until the thread exits or calls arena_local_del(). Push a frame on it
+// for scratch space and pop it when done, rather than clearing it, since
+// callers further up the stack may have frames of their own.
+FLYAPI arena *arena_local(void);
+FLYAPI void arena_local_del(void);
+
 #include "unjargon.h"
 
 #endif
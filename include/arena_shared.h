@@ -0,0 +1,53 @@
+#ifndef __ZCM_ARENA_SHARED_H__
+#define __ZCM_ARENA_SHARED_H__
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common.h"
+
+// Kept apart from arena.h since it needs C11 threads and atomics, which C++
+// includers and some C compilers don't have. ARENA_HAS_SHARED says whether
+// it's there.
+#if !defined(__STDC_NO_THREADS__) && !defined(__cplusplus)
+#include <stdatomic.h>
+#include <threads.h>
+
+#include "jargon.h"
+
+#define ARENA_HAS_SHARED 1
+
+struct arena_shared_block {
+  struct arena_shared_block *prev;
+  size_t size;
+  atomic_size_t used;
+  alignas (max_align_t) uint8_t data[];
+};
+
+// An arena any number of threads can allocate from at once. Each allocation
+// is one atomic add on the current block; the lock is only taken to put in a
+// new block when that one runs out, or for requests too big to share one.
+// There's no freeing short of arena_shared_clear(), and clearing or deleting
+// must not race with allocations.
+typedef struct arena_shared {
+  struct arena_shared_block *_Atomic block;
+  mtx_t lock;
+} arena_shared;
+
+FLYAPI arena_shared *arena_shared_new(size_t size);
+FLYAPI void arena_shared_del(arena_shared *a);
+
+__attribute__((alloc_size(2)))
+FLYAPI void *arena_shared_alloc(arena_shared *a, size_t size);
+
+__attribute__((alloc_size(2)))
+FLYAPI void *arena_shared_alloc_aligned(
+    arena_shared *a, size_t size, size_t align);
+
+FLYAPI void arena_shared_clear(arena_shared *a);
+
+#include "unjargon.h"
+#endif
+
+#endif
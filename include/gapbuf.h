@@ -0,0 +1,34 @@
+#ifndef __ZCM_GAPBUF_H__
+#define __ZCM_GAPBUF_H__
+
+#include <stddef.h>
+
+#include "common.h"
+#include "list.h"
+
+#include "jargon.h"
+
+// An array list with a movable hole in it. Items [0, gap) sit at the front of
+// the buffer and the rest sit flush against its end, so an insert or remove
+// only moves the items between the last edit and this one. Clustered edits,
+// like typing into a text buffer, cost O(distance) instead of O(size).
+//
+// The fields up to items match arlist, so the arlist growth code applies.
+// Operations that need the items in order close the gap by moving it to the
+// end first, which is free when the last edit was an append.
+typedef struct gapbuf {
+  UNIFY_OBJECT_DEF(list _list,
+    struct listkind *kind;
+    size_t size;
+    rng64 rng;
+  )
+  size_t capacity;
+  void **items;
+  size_t gap;
+} gapbuf;
+
+extern FLYAPI listkind *LISTKIND_GAP;
+
+#include "unjargon.h"
+
+#endif
@@ -0,0 +1,212 @@
+// Re-includable introsort template. Define INTROSORT_NAME, INTROSORT_TYPE and
+// INTROSORT_LESS(a, b) before including this header to generate
+//
+//   static void INTROSORT_NAME(INTROSORT_TYPE *items, size_t n);
+//   static void INTROSORT_NAME_select(
+//       INTROSORT_TYPE *items, size_t n, size_t nth);
+//
+// The second is an introselect: it only moves items[nth] into its sorted
+// position, with nothing greater before it and nothing less after it.
+//
+// INTROSORT_LESS is expanded inline, so comparisons are not indirect calls. If
+// INTROSORT_CONTEXT is also defined, the generated functions take a trailing
+// `INTROSORT_CONTEXT ctx` argument that INTROSORT_LESS may refer to. All of
+// the parameters are undefined again at the end of this header.
+
+#if !defined(INTROSORT_NAME) || !defined(INTROSORT_TYPE)  \
+    || !defined(INTROSORT_LESS)
+#error "INTROSORT_NAME, INTROSORT_TYPE and INTROSORT_LESS must be defined"
+#endif
+
+#include <stddef.h>
+
+#ifndef INTROSORT_INSERTION_MAX
+#define INTROSORT_INSERTION_MAX 16
+#endif
+
+#define INTROSORT_CAT_(a, b) a##b
+#define INTROSORT_CAT(a, b) INTROSORT_CAT_(a, b)
+#define INTROSORT_FN(suffix) INTROSORT_CAT(INTROSORT_NAME, suffix)
+
+#ifdef INTROSORT_CONTEXT
+#define INTROSORT_PARAMS , INTROSORT_CONTEXT ctx
+#define INTROSORT_ARGS , ctx
+#else
+#define INTROSORT_PARAMS
+#define INTROSORT_ARGS
+#endif
+
+#define INTROSORT_SWAP(a, b)  \
+  do {                        \
+    INTROSORT_TYPE _t = (a);  \
+    (a) = (b);                \
+    (b) = _t;                 \
+  } while (0)
+
+static inline void INTROSORT_FN(_insertion)(
+    INTROSORT_TYPE *items, size_t n INTROSORT_PARAMS) {
+  for (size_t i = 1; i < n; i++) {
+    INTROSORT_TYPE x = items[i];
+    size_t j = i;
+
+    for (; j && INTROSORT_LESS(x, items[j - 1]); j--) {
+      items[j] = items[j - 1];
+    }
+
+    items[j] = x;
+  }
+}
+
+static inline void INTROSORT_FN(_sift)(
+    INTROSORT_TYPE *items, size_t root, size_t n INTROSORT_PARAMS) {
+  INTROSORT_TYPE x = items[root];
+  size_t child;
+
+  while ((child = root * 2 + 1) < n) {
+    if (child + 1 < n && INTROSORT_LESS(items[child], items[child + 1])) {
+      child++;
+    }
+
+    if (!INTROSORT_LESS(x, items[child])) {
+      break;
+    }
+
+    items[root] = items[child];
+    root = child;
+  }
+
+  items[root] = x;
+}
+
+static void INTROSORT_FN(_heapsort)(
+    INTROSORT_TYPE *items, size_t n INTROSORT_PARAMS) {
+  for (size_t i = n / 2; i--;) {
+    INTROSORT_FN(_sift)(items, i, n INTROSORT_ARGS);
+  }
+
+  while (n > 1) {
+    INTROSORT_SWAP(items[0], items[n - 1]);
+    INTROSORT_FN(_sift)(items, 0, --n INTROSORT_ARGS);
+  }
+}
+
+// Partitions items around a median of three and returns the split point i,
+// with items[0, i) no greater than items[i, n). Needs n >= 3; 0 < i < n.
+static inline size_t INTROSORT_FN(_partition)(
+    INTROSORT_TYPE *items, size_t n INTROSORT_PARAMS) {
+  INTROSORT_TYPE pivot;
+  size_t i, j, mid;
+
+  // Median of three; the ends then act as sentinels for the scans below.
+  mid = n / 2;
+
+  if (INTROSORT_LESS(items[mid], items[0])) {
+    INTROSORT_SWAP(items[mid], items[0]);
+  }
+  if (INTROSORT_LESS(items[n - 1], items[mid])) {
+    INTROSORT_SWAP(items[n - 1], items[mid]);
+
+    if (INTROSORT_LESS(items[mid], items[0])) {
+      INTROSORT_SWAP(items[mid], items[0]);
+    }
+  }
+
+  pivot = items[mid];
+  i = 0;
+  j = n - 1;
+
+  for (;;) {
+    do {
+      i++;
+    } while (INTROSORT_LESS(items[i], pivot));
+
+    do {
+      j--;
+    } while (INTROSORT_LESS(pivot, items[j]));
+
+    if (i >= j) {
+      return i;
+    }
+
+    INTROSORT_SWAP(items[i], items[j]);
+  }
+}
+
+static void INTROSORT_FN(_loop)(
+    INTROSORT_TYPE *items, size_t n, unsigned depth INTROSORT_PARAMS) {
+  size_t i;
+
+  while (n > INTROSORT_INSERTION_MAX) {
+    if (!depth--) {
+      INTROSORT_FN(_heapsort)(items, n INTROSORT_ARGS);
+      return;
+    }
+
+    i = INTROSORT_FN(_partition)(items, n INTROSORT_ARGS);
+
+    // Recurse into the smaller side so the stack stays logarithmic.
+    if (i < n - i) {
+      INTROSORT_FN(_loop)(items, i, depth INTROSORT_ARGS);
+      items += i;
+      n -= i;
+    } else {
+      INTROSORT_FN(_loop)(items + i, n - i, depth INTROSORT_ARGS);
+      n = i;
+    }
+  }
+
+  INTROSORT_FN(_insertion)(items, n INTROSORT_ARGS);
+}
+
+static inline unsigned INTROSORT_FN(_depth)(size_t n) {
+  unsigned depth = 0;
+
+  for (; n > 1; n >>= 1) {
+    depth += 2;
+  }
+
+  return depth;
+}
+
+static void INTROSORT_NAME(INTROSORT_TYPE *items, size_t n INTROSORT_PARAMS) {
+  INTROSORT_FN(_loop)(items, n, INTROSORT_FN(_depth)(n) INTROSORT_ARGS);
+}
+
+// Only the side holding nth is partitioned further, so this is linear on
+// average. Like the sort, it falls back to heapsort if the pivots go bad.
+static void INTROSORT_FN(_select)(
+    INTROSORT_TYPE *items, size_t n, size_t nth INTROSORT_PARAMS) {
+  unsigned depth = INTROSORT_FN(_depth)(n);
+  size_t i;
+
+  while (n > INTROSORT_INSERTION_MAX) {
+    if (!depth--) {
+      INTROSORT_FN(_heapsort)(items, n INTROSORT_ARGS);
+      return;
+    }
+
+    i = INTROSORT_FN(_partition)(items, n INTROSORT_ARGS);
+
+    if (nth < i) {
+      n = i;
+    } else {
+      items += i;
+      n -= i;
+      nth -= i;
+    }
+  }
+
+  INTROSORT_FN(_insertion)(items, n INTROSORT_ARGS);
+}
+
+#undef INTROSORT_SWAP
+#undef INTROSORT_ARGS
+#undef INTROSORT_PARAMS
+#undef INTROSORT_FN
+#undef INTROSORT_CAT
+#undef INTROSORT_CAT_
+#undef INTROSORT_INSERTION_MAX
+#undef INTROSORT_CONTEXT
+#undef INTROSORT_LESS
+#undef INTROSORT_TYPE
+#undef INTROSORT_NAME
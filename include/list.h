@@ -16,6 +16,7 @@
 #ifndef __ZCM_LIST_H__
 #define __ZCM_LIST_H__
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stddef.h>
 
@@ -38,6 +39,19 @@ struct dllistnode {
 
 struct listkind;
 
+// A cursor over any kind of list. Array kinds hand out at most two runs of
+// contiguous items and linked kinds hand out their chain of nodes, so either
+// way a step is a pointer increment or a pointer chase, with no call through
+// the listkind. Doubly linked nodes start like singly linked ones.
+typedef struct list_iter {
+  void **cursor;
+  void **end;
+  void **next;
+  void **next_end;
+  struct sllistnode *node;
+  struct sllistnode *head;
+} list_iter;
+
 #define LIST_DEFINITION             \
   struct listkind *kind;            \
   size_t size;                      \
@@ -91,6 +105,21 @@ typedef struct listkind {
   size_t (*discard_all)(list *, int (*)(void *), int (*)(void *, size_t));
   void (*shuffle)(list *);
   void (*sort)(list *, int(*)(const void *, const void *));
+  void (*sort_stable)(list *, int(*)(const void *, const void *));
+  void *(*select_nth)(list *, size_t, int(*)(const void *, const void *));
+  void (*partial_sort)(list *, size_t, int(*)(const void *, const void *));
+  size_t (*index_of)(list *, void *);
+  size_t (*count_of)(list *, void *);
+  void (*pop_many)(list *, size_t, void **);
+  void (*shift_many)(list *, size_t, void **);
+  void (*unshift_array)(list *, size_t, void **);
+  void (*insert)(list *, size_t, void *);
+  void *(*remove_at)(list *, size_t);
+  void (*reverse)(list *);
+  void (*rotate)(list *, size_t);
+  void (*slice)(list *, size_t, size_t, list *);
+  void (*splice)(list *, size_t, list *, size_t, size_t);
+  void (*iter)(list *, list_iter *);
 } listkind;
 
 extern FLYAPI listkind *LISTKIND_ARRAY;
@@ -115,14 +144,142 @@ FLYAPI void list_unshift(list *l, void *data);
 FLYAPI void list_concat(list *l1, list *l2);
 FLYAPI void list_concat_into(list *l1, list *l2);
 FLYAPI void list_append_array(list *l, size_t n, void **items);
+FLYAPI void list_unshift_array(list *l, size_t n, void **items);
+
+// Remove up to n items from the end or the front of the list and copy them
+// to out in list order, so out[0] is the item that was nearest the front.
+// They return how many were removed, which is fewer than n only when the
+// list runs out. list_drain_into_array empties the list into out, which
+// needs room for all of it.
+FLYAPI size_t list_pop_many(list *l, size_t n, void **out);
+FLYAPI size_t list_shift_many(list *l, size_t n, void **out);
+FLYAPI size_t list_drain_into_array(list *l, void **out);
+
+// Negative indices count from the end, as in list_get(). list_insert puts
+// data in front of the item at i, so inserting at the size appends. The array
+// kinds move every item after i, the deque whichever side is shorter, and the
+// linked kinds walk to i; LISTKIND_GAP is the kind for many nearby edits.
+FLYAPI void list_insert(list *l, ptrdiff_t i, void *data);
+FLYAPI void *list_remove_at(list *l, ptrdiff_t i);
+
+FLYAPI void list_reverse(list *l);
+
+// Rotates left by k, so the item at k comes first. Negative k rotates right.
+// Array kinds use three reversals and the deque moves the shorter side
+// around the ring; the doubly linked list just moves its head.
+FLYAPI void list_rotate(list *l, ptrdiff_t k);
+
+// Ranges are half-open, [from, to), with negative ends counted from the size.
+// list_slice returns a new list of the same kind holding the range. Use
+// arlist_view() or deque_view() to borrow a range of an array without
+// copying it.
+FLYAPI list *list_slice(list *l, ptrdiff_t from, ptrdiff_t to);
+
+// Moves the range [from, to) out of src and inserts it in front of pos in
+// dst, which must be a different list. Linked lists relink the range in O(1)
+// once the three positions are found. Lists of different kinds trade one
+// item at a time.
+FLYAPI void list_splice(
+    list *dst, ptrdiff_t pos, list *src, ptrdiff_t from, ptrdiff_t to);
 
 FLYAPI void *list_find_first(list *l, int (*matcher)(void *));
+
+// Exact pointer comparisons, with no matcher call per item. list_index_of
+// returns SIZE_MAX and sets FLY_NOT_FOUND when data isn't in the list.
+FLYAPI size_t list_index_of(list *l, void *data);
+FLYAPI bool list_contains(list *l, void *data);
+FLYAPI size_t list_count_of(list *l, void *data);
 FLYAPI void list_foreach(list *l, int (*fn)(void *, size_t));
+
+// list_iter_of() asks the kind for a cursor once, and stepping it after that
+// is inline. The list must not be resized while a cursor is in use. Check
+// list_iter_has_next() before each list_iter_peek() or list_iter_next().
+FLYAPI list_iter list_iter_of(list *l);
+
+// For kinds outside this file: points it at first, then second. Either run
+// may be empty.
+FLYAPI inline void list_iter_init_runs(list_iter *it, void **first,
+    size_t first_size, void **second, size_t second_size) {
+  if (!first_size) {
+    first = second;
+    first_size = second_size;
+    second_size = 0;
+  }
+
+  it->cursor = first;
+  it->end = first_size ? first + first_size : first;
+  it->next = second_size ? second : NULL;
+  it->next_end = second_size ? second + second_size : NULL;
+  it->node = it->head = NULL;
+}
+
+__attribute__((pure))
+FLYAPI inline bool list_iter_has_next(list_iter *it) {
+  return it->node ? it->node != it->head : it->cursor != it->end;
+}
+
+__attribute__((pure))
+FLYAPI inline void *list_iter_peek(list_iter *it) {
+  return it->node ? it->node->data : *it->cursor;
+}
+
+FLYAPI inline void *list_iter_next(list_iter *it) {
+  void *ret;
+
+  if (it->node) {
+    ret = it->node->data;
+    it->node = it->node->next;
+    return ret;
+  }
+
+  ret = *it->cursor++;
+
+  if (it->cursor == it->end && it->next) {
+    it->cursor = it->next;
+    it->end = it->next_end;
+    it->next = it->next_end = NULL;
+  }
+
+  return ret;
+}
+
+// Loops over the items of l with var, which the caller declares, set to each
+// in turn. break and continue behave as in any loop. The kind-specific
+// versions near the end of this file skip even the cursor setup.
+#define LIST_FOR_EACH(l, var)  \
+  for (list_iter _fly_iter = list_iter_of((list *) (l));  \
+       list_iter_has_next(&_fly_iter)  \
+         && ((var = list_iter_next(&_fly_iter)), 1);)
+
 FLYAPI void *list_discard(list *l, int (*matcher)(void *));
 FLYAPI size_t list_discard_all(
     list *l, int (*matcher)(void *), int (*fn)(void *, size_t));
 FLYAPI void list_shuffle(list *l);
 FLYAPI void list_sort(list *l, int (*comp)(const void *, const void *));
+FLYAPI void list_sort_stable(
+    list *l, int (*comp)(const void *, const void *));
+
+// Moves the nth item into its sorted position, with nothing greater before it
+// and nothing less after it, and returns it. Linear on average.
+FLYAPI void *list_select_nth(
+    list *l, size_t n, int (*comp)(const void *, const void *));
+
+// Sorts just the k smallest items into the front of the list. The order of
+// the rest is unspecified.
+FLYAPI void list_partial_sort(
+    list *l, size_t k, int (*comp)(const void *, const void *));
+
+// Copies the k smallest items into out, in order, without touching the list.
+// Only a bounded heap of k items is kept. Returns how many were copied.
+FLYAPI size_t list_top_k(
+    list *l, size_t k, int (*comp)(const void *, const void *), void **out);
+
+// Array kinds at or above this size are sorted in parallel; everything else
+// falls back to list_sort().
+#define LIST_SORT_PARALLEL_THRESHOLD (64 * 1024)
+
+FLYAPI void list_sort_parallel(
+    list *l, int (*comp)(const void *, const void *), size_t nthreads);
 
 FLYAPI inline enum FLY_STATUS list_bad_call(void *lp, ptrdiff_t i) {
   list *l = (list *) lp;
@@ -252,11 +409,15 @@ FLYAPI inline void *arlist_get(arlist *l, ptrdiff_t i) {
 
 FLYAPI inline void arlist_push(arlist *l, void *data) {
   FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
   arlist_push_unsafe(l, data);
 }
 
 FLYAPI inline void arlist_unshift(arlist *l, void *data) {
   FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
   arlist_unshift_unsafe(l, data);
 }
 
@@ -264,6 +425,8 @@ FLYAPI inline void *arlist_pop(arlist *l) {
   FLY_BAIL_IF_NULL(l, NULL);
   FLY_BAIL_IF_EMPTY(l->size, NULL);
 
+  fly_status = FLY_OK;
+
   return arlist_pop_unsafe(l);
 }
 
@@ -271,9 +434,19 @@ FLYAPI inline void *arlist_shift(arlist *l) {
   FLY_BAIL_IF_NULL(l, NULL);
   FLY_BAIL_IF_EMPTY(l->size, NULL);
 
+  fly_status = FLY_OK;
+
   return arlist_shift_unsafe(l);
 }
 
+// Borrows items [from, to) without copying them. The view can be read,
+// searched and sorted in place, but it must not be resized or deleted, and it
+// goes stale once l is resized. A deque range that wraps around the end of
+// its buffer is lined up first, in order, since sorting a view that wrapped
+// would move the deque's other items; that leaves earlier views stale too.
+FLYAPI arlist arlist_view(arlist *l, size_t from, size_t to);
+FLYAPI deque deque_view(deque *l, size_t from, size_t to);
+
 FLYAPI void arlist_concat(arlist * restrict l1, arlist * restrict l2);
 FLYAPI void arlist_shuffle(arlist *l);
 FLYAPI void **arlist_draw(arlist * restrict l, void ** restrict cursor);
@@ -288,6 +461,22 @@ FLYAPI inline void *arlist_pick(arlist *l) {
 }
 
 FLYAPI void arlist_sort(arlist *l, int (*comp)(const void *, const void *));
+FLYAPI void arlist_sort_stable(
+    arlist *l, int (*comp)(const void *, const void *));
+
+// These expect l to be sorted by comp already. The bounds are the index of
+// the first item not before key and the first item after it, respectively.
+FLYAPI size_t arlist_lower_bound(
+    arlist *l, void *key, int (*comp)(const void *, const void *));
+FLYAPI size_t arlist_upper_bound(
+    arlist *l, void *key, int (*comp)(const void *, const void *));
+FLYAPI void *arlist_bsearch(
+    arlist *l, void *key, int (*comp)(const void *, const void *));
+
+// Inserts data after any items equal to it and returns its index, or
+// SIZE_MAX if the list couldn't grow.
+FLYAPI size_t arlist_insert_sorted(
+    arlist *l, void *data, int (*comp)(const void *, const void *));
 
 FLYAPI inline void *deque_get(deque *l, ptrdiff_t i) {
   if (list_bad_call(l, i)) {
@@ -298,11 +487,15 @@ FLYAPI inline void *deque_get(deque *l, ptrdiff_t i) {
 
 FLYAPI inline void deque_push(deque *l, void *data) {
   FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
   deque_push_unsafe(l, data);
 }
 
 FLYAPI inline void deque_unshift(deque *l, void *data) {
   FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
   deque_unshift_unsafe(l, data);
 }
 
@@ -310,6 +503,8 @@ FLYAPI inline void *deque_pop(deque *l) {
   FLY_BAIL_IF_NULL(l, NULL);
   FLY_BAIL_IF_EMPTY(l->size, NULL);
 
+  fly_status = FLY_OK;
+
   return deque_pop_unsafe(l);
 }
 
@@ -317,6 +512,8 @@ FLYAPI inline void *deque_shift(deque *l) {
   FLY_BAIL_IF_NULL(l, NULL);
   FLY_BAIL_IF_EMPTY(l->size, NULL);
 
+  fly_status = FLY_OK;
+
   return deque_shift_unsafe(l);
 }
 
@@ -338,6 +535,16 @@ FLYAPI inline void *deque_pick(deque *l) {
 }
 
 FLYAPI void deque_sort(deque *l, int (*comp)(const void *, const void *));
+FLYAPI void deque_sort_stable(
+    deque *l, int (*comp)(const void *, const void *));
+
+// The items from start up to the end of the buffer; the rest wrap to 0.
+__attribute__((pure))
+FLYAPI inline size_t deque_first_segment(deque *l) {
+  const size_t tail = l->capacity - l->start;
+
+  return tail < l->size ? tail : l->size;
+}
 
 FLYAPI void *dllist_get(dllist *l, ptrdiff_t i);
 FLYAPI void dllist_push(dllist *l, void *data);
@@ -359,6 +566,58 @@ FLYAPI void sllist_move(sllist * restrict dst, sllist * restrict src);
 FLYAPI void sllist_shuffle(sllist *l);
 FLYAPI void sllist_sort(sllist *l, int (*comp)(const void *, const void *));
 
+// Given a pointer to one of the kinds above, these pick that kind's own
+// function at compile time, and the array kinds' are inline, so there's no
+// call through the listkind. Anything else, list * included, goes through
+// the listkind as before. The library itself is built without them, C++ has
+// no _Generic, and defining FLY_LIST_NO_GENERIC before including this header
+// turns them off.
+#if !defined(FLYAPIBUILD) && !defined(FLY_LIST_NO_GENERIC)  \
+  && !defined(__cplusplus)
+#define FLY_LIST_GENERIC(l, fn)  \
+  _Generic((l),  \
+    arlist *: arlist_##fn,  \
+    deque *: deque_##fn,  \
+    dllist *: dllist_##fn,  \
+    sllist *: sllist_##fn,  \
+    default: list_##fn)
+
+#define list_get(l, i) FLY_LIST_GENERIC(l, get)(l, i)
+#define list_push(l, data) FLY_LIST_GENERIC(l, push)(l, data)
+#define list_unshift(l, data) FLY_LIST_GENERIC(l, unshift)(l, data)
+#define list_pop(l) FLY_LIST_GENERIC(l, pop)(l)
+#define list_shift(l) FLY_LIST_GENERIC(l, shift)(l)
+#endif
+
+// Kind-specific loops, like LIST_FOR_EACH but open-coded over the storage, so
+// they compile down to a pointer increment or a pointer chase per item. They
+// evaluate l more than once, and the list must not change inside the loop.
+// The deque walks its two ring segments as two runs of the same inner loop.
+#define ARLIST_FOR_EACH(l, var)  \
+  for (void **_fly_it = (l)->items,  \
+         **_fly_end = (l)->size ? _fly_it + (l)->size : _fly_it;  \
+       _fly_it != _fly_end && ((var = *_fly_it), 1); _fly_it++)
+
+#define DEQUE_FOR_EACH(l, var)  \
+  for (void **_fly_it = (l)->size ? (l)->items + (l)->start : NULL,  \
+         **_fly_end = _fly_it ? _fly_it + deque_first_segment(l) : NULL,  \
+         **_fly_rest = (l)->items + ((l)->size - deque_first_segment(l));  \
+       _fly_it;  \
+       _fly_it = _fly_it == _fly_end && _fly_rest != (l)->items  \
+         ? (_fly_end = _fly_rest, _fly_rest = (l)->items, (l)->items)  \
+         : NULL)  \
+    for (; _fly_it != _fly_end && ((var = *_fly_it), 1); _fly_it++)
+
+#define SLLIST_FOR_EACH(l, var)  \
+  for (struct sllistnode *_fly_node = (l)->head->next;  \
+       _fly_node != (l)->head && ((var = _fly_node->data), 1);  \
+       _fly_node = _fly_node->next)
+
+#define DLLIST_FOR_EACH(l, var)  \
+  for (struct dllistnode *_fly_node = (l)->head->next;  \
+       _fly_node != (l)->head && ((var = _fly_node->data), 1);  \
+       _fly_node = _fly_node->next)
+
 #include "unjargon.h"
 
 #endif
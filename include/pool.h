@@ -0,0 +1,70 @@
+#ifndef __ZCM_POOL_H__
+#define __ZCM_POOL_H__
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "arena.h"
+
+#include "jargon.h"
+
+// Slots are carved out of slabs in the pool's own arena, each slab twice the
+// size of the last, and handed out the first time they're needed.
+struct pool_slab {
+  struct pool_slab *prev;
+  uint8_t *slots;
+  size_t count;
+  uint64_t live[];
+};
+
+// Objects of one size and alignment. Freed objects hold the link to the next
+// free one in their first bytes, so allocating and freeing are O(1) and cost
+// no memory of their own. init is called on every object pool_alloc() hands
+// out and fini on every object given back, whether by pool_free() or, for
+// the ones still out, by pool_reset() and pool_del(). To find those, a pool
+// with a fini keeps a bit per slot, and pool_free() has to look up the slab
+// an object came from, of which there are O(log n).
+typedef struct pool {
+  arena *arena;
+  size_t size;
+  size_t align;
+  void *free;
+  uint8_t *next;
+  uint8_t *end;
+  struct pool_slab *slabs;
+  size_t live;
+  void (*init)(void *);
+  void (*fini)(void *);
+} pool;
+
+#define POOL_FIRST_SLAB 32
+
+// align has to be a power of two. Objects are at least a pointer in size and
+// alignment, and their size is rounded up to a multiple of their alignment.
+FLYAPI pool *pool_new_with_callbacks(
+    size_t size, size_t align, void (*init)(void *), void (*fini)(void *));
+
+__attribute__((artificial))
+FLYAPI inline pool *pool_new(size_t size, size_t align) {
+  return pool_new_with_callbacks(size, align, NULL, NULL);
+}
+
+#define pool_new_type(T) pool_new(sizeof (T), alignof (T))
+
+FLYAPI void pool_del(pool *p);
+
+FLYAPI void *pool_alloc(pool *p);
+
+#define pool_alloc_type(p, T) (T *) pool_alloc(p)
+
+FLYAPI void pool_free(pool *p, void *obj);
+
+// Gives back every object at once, calling fini on the ones still out, and
+// keeps the first block of the arena for the objects that come next.
+FLYAPI void pool_reset(pool *p);
+
+#include "unjargon.h"
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef __ZCM_PQUEUE_H__
+#define __ZCM_PQUEUE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "list.h"
+
+#include "jargon.h"
+
+// A d-ary min-heap kept in the items array of an arlist. comp orders items
+// the same way list_sort() does, smallest first, and NULL orders them by
+// address. Wider nodes make the heap shallower and keep a node's children
+// next to each other, so a pop touches fewer cache lines than a binary heap.
+//
+// If moved is set, it's called with an item's new index every time the item
+// is placed in the heap, and with PQUEUE_REMOVED when it leaves. Callers can
+// keep that index as a handle for pqueue_decrease_key() and pqueue_remove().
+typedef struct pqueue {
+  arlist *heap;
+  size_t arity;
+  int (*comp)(const void *, const void *);
+  void (*moved)(void *data, size_t index);
+} pqueue;
+
+#define PQUEUE_DEFAULT_ARITY 4
+#define PQUEUE_REMOVED SIZE_MAX
+
+FLYAPI pqueue *pqueue_new_of_arity(
+    size_t arity, int (*comp)(const void *, const void *));
+
+__attribute__((artificial))
+FLYAPI inline pqueue *pqueue_new(int (*comp)(const void *, const void *)) {
+  return pqueue_new_of_arity(PQUEUE_DEFAULT_ARITY, comp);
+}
+
+FLYAPI void pqueue_del(pqueue *q);
+
+FLYAPI inline size_t pqueue_size(pqueue *q) {
+  FLY_BAIL_IF_NULL(q, 0);
+
+  return q->heap->size;
+}
+
+FLYAPI void pqueue_push(pqueue *q, void *data);
+
+// Appends all of items at once. When they outnumber what's already queued,
+// the heap is rebuilt bottom-up in O(n) instead of sifting each one in; on an
+// empty queue this is a plain heapify.
+FLYAPI void pqueue_push_array(pqueue *q, size_t n, void **items);
+
+FLYAPI void *pqueue_peek(pqueue *q);
+FLYAPI void *pqueue_pop(pqueue *q);
+
+// Restores the heap after the item at index has moved closer to the front.
+FLYAPI void pqueue_decrease_key(pqueue *q, size_t index);
+
+FLYAPI void *pqueue_remove(pqueue *q, size_t index);
+
+#include "unjargon.h"
+
+#endif
@@ -133,6 +133,15 @@ FLYAPI inline uint64_t rng64_next_in_biased(rng64 *rng, uint64_t bound) {
   return fastrange64(rng64_next(rng), bound);
 }
 
+// Fill out with the next n values, the same ones n calls to rng32_next() or
+// rng64_next() would give, and leave rng where those calls would. The stream
+// is split into RNG_FILL_LANES lanes a step apart that each jump that many
+// steps at a time, so their multiplies don't wait on each other.
+#define RNG_FILL_LANES 4
+
+FLYAPI void rng32_fill(rng32 *rng, uint32_t *out, size_t n);
+FLYAPI void rng64_fill(rng64 *rng, uint64_t *out, size_t n);
+
 #if __STDC_VERSION__ >= 201112L
 
 #define rng_seed(rng) _Generic((rng), \
@@ -160,6 +169,11 @@ FLYAPI inline uint64_t rng64_next_in_biased(rng64 *rng, uint64_t bound) {
     rng64 *: rng64_next_in_biased \
   )(rng, bound)
 
+#define rng_fill(rng, out, n) _Generic((rng), \
+    rng32 *: rng32_fill, \
+    rng64 *: rng64_fill \
+  )(rng, out, n)
+
 #endif
 
 __attribute__((const))
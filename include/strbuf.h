@@ -0,0 +1,75 @@
+#ifndef __ZCM_STRBUF_H__
+#define __ZCM_STRBUF_H__
+
+#include <stddef.h>
+
+#include "common.h"
+#include "arena.h"
+
+#include "jargon.h"
+
+// A string built up in an arena. It's an arena_vec of chars, so as long as
+// nothing else is allocated from the arena in the meantime, it grows in place
+// and is never copied. The string isn't kept null-terminated until it's
+// finished; appends that fail leave it as it was.
+typedef struct strbuf {
+  arena_vec chars;
+} strbuf;
+
+#define STRBUF_MIN_CAPACITY 32
+
+__attribute__((artificial))
+FLYAPI inline void strbuf_init(strbuf *sb, arena *a) {
+  arena_vec_init(&sb->chars, a, 1, 1);
+}
+
+FLYAPI inline size_t strbuf_size(strbuf *sb) {
+  return sb->chars.size;
+}
+
+FLYAPI void strbuf_append(strbuf *sb, const char *s);
+FLYAPI void strbuf_appendn(strbuf *sb, const char *s, size_t n);
+
+__attribute__((format(printf, 2, 3)))
+FLYAPI void strbuf_appendf(strbuf *sb, const char *format, ...);
+
+// Terminates the string, gives back the space it didn't use if it's still at
+// the top of the arena, and leaves sb empty for the next one. The string is
+// the arena's, so it goes with the frame it was started in.
+FLYAPI char *strbuf_finish(strbuf *sb);
+
+struct strtab_entry {
+  const char *str;
+  size_t len;
+  size_t hash;
+};
+
+// Keeps one copy of each distinct string in an arena of its own, so the
+// pointers it hands out stay put for as long as the table does, and two
+// strings with the same contents are equal exactly when their pointers are.
+// That makes them good pointer keys for dict_set(). The table is open
+// addressed and kept at most half full.
+typedef struct strtab {
+  arena *strings;
+  struct strtab_entry *slots;
+  size_t size;
+  size_t capacity;
+} strtab;
+
+#define STRTAB_MIN_CAPACITY 64
+
+FLYAPI strtab *strtab_new(void);
+FLYAPI void strtab_del(strtab *t);
+
+FLYAPI const char *strtab_intern(strtab *t, const char *s);
+
+// Interns the n chars at s, which don't have to be null-terminated. The copy
+// in the table is.
+FLYAPI const char *strtab_internn(strtab *t, const char *s, size_t n);
+
+// The table's copy of s, or NULL with FLY_NOT_FOUND if it hasn't got one.
+FLYAPI const char *strtab_lookup(strtab *t, const char *s);
+
+#include "unjargon.h"
+
+#endif
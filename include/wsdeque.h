@@ -0,0 +1,56 @@
+#ifndef __ZCM_WSDEQUE_H__
+#define __ZCM_WSDEQUE_H__
+
+#include <stddef.h>
+
+#ifndef __cplusplus
+#include <stdatomic.h>
+#endif
+
+#include "common.h"
+#include "list.h"
+
+#include "jargon.h"
+
+// C++ can't name C11 atomics before C++23, so C++ includers see the same
+// layout with plain members. Only the library reads or writes them.
+#ifdef __cplusplus
+#define WSDEQUE_ATOMIC(T) T
+#else
+#define WSDEQUE_ATOMIC(T) _Atomic(T)
+#endif
+
+struct wsdeque_ring {
+  struct wsdeque_ring *prev;
+  size_t mask;
+  WSDEQUE_ATOMIC(void *) items[];
+};
+
+// Chase-Lev work-stealing deque. The owning thread pushes and pops at the
+// bottom; any number of thieves may concurrently take from the top with
+// wsdeque_steal(). Everything else in the list API is owner-only and must not
+// race with thieves. Thieves never write `size`, so it is an upper bound on
+// the number of items while steals are in flight.
+typedef struct wsdeque {
+  UNIFY_OBJECT_DEF(list _list,
+    struct listkind *kind;
+    size_t size;
+    rng64 rng;
+  )
+  WSDEQUE_ATOMIC(struct wsdeque_ring *) ring;
+  WSDEQUE_ATOMIC(ptrdiff_t) top;
+  WSDEQUE_ATOMIC(ptrdiff_t) bottom;
+} wsdeque;
+
+#undef WSDEQUE_ATOMIC
+
+extern FLYAPI listkind *LISTKIND_WORKSTEAL;
+
+FLYAPI void wsdeque_push(wsdeque *l, void *data);
+FLYAPI void *wsdeque_pop(wsdeque *l);
+FLYAPI void *wsdeque_steal(wsdeque *l);
+FLYAPI size_t wsdeque_size(wsdeque *l);
+
+#include "unjargon.h"
+
+#endif
@@ -1,67 +1,484 @@
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "arena.h"
+#include "arena_shared.h"
+
+#ifdef ARENA_HAS_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifndef __STDC_NO_THREADS__
+#include <threads.h>
+#endif
 
 #define BLOCK_ALIGNMENT_PADDING (sizeof (arena) % alignof (max_align_t))
 
+static struct arena_spares global_spares = { NULL, 0, 0 };
+
+#ifndef __STDC_NO_THREADS__
+static mtx_t global_spares_lock;
+static once_flag global_spares_once = ONCE_FLAG_INIT;
+
+static void global_spares_lock_init(void) {
+  mtx_init(&global_spares_lock, mtx_plain);
+}
+
+static inline void lock_global_spares(void) {
+  call_once(&global_spares_once, &global_spares_lock_init);
+  mtx_lock(&global_spares_lock);
+}
+
+static inline void unlock_global_spares(void) {
+  mtx_unlock(&global_spares_lock);
+}
+#else
+static inline void lock_global_spares(void) {
+}
+
+static inline void unlock_global_spares(void) {
+}
+#endif
+
+static inline size_t arena_block_size(struct arena_block *block) {
+  return (size_t) (block->end - block->data);
+}
+
+static bool arena_spares_put(
+    struct arena_spares *spares, struct arena_block *block) {
+  const size_t size = arena_block_size(block);
+
+  if (spares->size > spares->limit || size > spares->limit - spares->size) {
+    return false;
+  }
+
+  block->prev = spares->blocks;
+  spares->blocks = block;
+  spares->size += size;
+
+  return true;
+}
+
+// The smallest spare of at least size bytes.
+static struct arena_block *arena_spares_take(
+    struct arena_spares *spares, size_t size) {
+  struct arena_block **best = NULL, *ret;
+
+  for (struct arena_block **cur = &spares->blocks; *cur; cur = &(*cur)->prev) {
+    if (arena_block_size(*cur) >= size
+        && (!best || arena_block_size(*cur) < arena_block_size(*best))) {
+      best = cur;
+    }
+  }
+
+  if (!best) {
+    return NULL;
+  }
+
+  ret = *best;
+  *best = ret->prev;
+  spares->size -= arena_block_size(ret);
+
+  return ret;
+}
+
+static void arena_spares_trim(struct arena_spares *spares) {
+  while (spares->size > spares->limit) {
+    struct arena_block *block = spares->blocks;
+
+    spares->blocks = block->prev;
+    spares->size -= arena_block_size(block);
+    free(block);
+  }
+}
+
+static void arena_block_give(arena *a, struct arena_block *block) {
+  bool kept;
+
+  if (arena_spares_put(&a->spares, block)) {
+    return;
+  }
+
+  lock_global_spares();
+  kept = arena_spares_put(&global_spares, block);
+  unlock_global_spares();
+
+  if (!kept) {
+    free(block);
+  }
+}
+
+static struct arena_block *arena_block_take(arena *a, size_t size) {
+  struct arena_block *ret;
+
+  if ((ret = arena_spares_take(&a->spares, size))) {
+    return ret;
+  }
+
+  lock_global_spares();
+  ret = arena_spares_take(&global_spares, size);
+  unlock_global_spares();
+
+  if (ret) {
+    return ret;
+  }
+
+  if ((ret = malloc(sizeof (struct arena_block) + size))) {
+    ret->end = ret->data + size;
+  }
+
+  return ret;
+}
+
+#ifdef ARENA_STATS
+static inline void arena_count_used(arena *a, ptrdiff_t delta) {
+  if ((a->counters.used += delta) > a->counters.peak) {
+    a->counters.peak = a->counters.used;
+  }
+}
+
+static inline void arena_count_padding(arena *a, size_t padding) {
+  a->counters.padding += padding;
+}
+
+static inline void arena_count_new_large(
+    arena *a, struct arena_large_alloc *large, size_t size) {
+  large->size = size;
+  arena_count_used(a, size);
+}
+
+static inline void arena_count_large(
+    arena *a, struct arena_large_alloc *large, size_t size) {
+  arena_count_used(a, size - large->size);
+  large->size = size;
+}
+#else
+#define arena_count_used(a, delta) ((void) 0)
+#define arena_count_padding(a, padding) ((void) 0)
+#define arena_count_new_large(a, large, size) ((void) 0)
+#define arena_count_large(a, large, size) ((void) 0)
+#endif
+
+// Earlier blocks count in full, since nothing goes in what they have left.
+static size_t arena_used(arena *a) {
+  size_t ret = a->next - a->block->data;
+
+  for (struct arena_block *block = a->block->prev; block; block = block->prev) {
+    ret += block->end - block->data;
+  }
+
+#ifdef ARENA_STATS
+  for (struct arena_large_alloc *large = a->large; large; large = large->prev) {
+    ret += large->size;
+  }
+#endif
+
+  return ret;
+}
+
+#define ARENA_HEADER_SIZE \
+  (sizeof (arena) + BLOCK_ALIGNMENT_PADDING + sizeof (struct arena_block))
+
+// The first block sits right after the arena, in the same allocation.
+static void arena_init(arena *a, size_t size, uint8_t *reserved) {
+  fly_status = FLY_OK;
+
+  a->large = NULL;
+  a->block = (struct arena_block *)
+    ((uintptr_t) (a + 1) + BLOCK_ALIGNMENT_PADDING);
+
+  a->block->prev = NULL;
+  a->block->end = a->block->data + size;
+
+  a->spares.blocks = NULL;
+  a->spares.size = 0;
+  a->spares.limit = ARENA_DEFAULT_SPARE_LIMIT;
+  a->reserved = reserved;
+  a->deferred = NULL;
+
+#ifdef ARENA_STATS
+  a->counters = (struct arena_counters) { 0 };
+#endif
+
+  arena_clear(a);
+}
+
 FLYAPI arena *arena_new(size_t size) {
   if (size < ARENA_MINIMUM_SIZE) {
     size = ARENA_DEFAULT_SIZE;
   }
 
-  arena *ret = (arena *) malloc(
-      sizeof (arena) + BLOCK_ALIGNMENT_PADDING
-      + sizeof (struct arena_block) + size);
+  arena *ret = (arena *) malloc(ARENA_HEADER_SIZE + size);
 
   if (ret) {
-    fly_status = FLY_OK;
+    arena_init(ret, size, NULL);
+  } else {
+    fly_status = FLY_E_OUT_OF_MEMORY;
+  }
 
-    ret->large = NULL;
-    ret->block = (struct arena_block *)
-      ((uintptr_t) (ret + 1) + BLOCK_ALIGNMENT_PADDING);
+  return ret;
+}
 
-    ret->block->prev = NULL;
-    ret->block->end = ret->block->data + size;
+#ifdef ARENA_HAS_MMAP
+static inline uintptr_t arena_round_up(uintptr_t n, uintptr_t to) {
+  return (n + to - 1) & ~(to - 1);
+}
 
-    arena_clear(ret);
-  } else {
+static inline size_t arena_commit_step(arena *a) {
+  return (size_t) (a->reserved - (uint8_t *) a) >= ARENA_HUGE_PAGE_SIZE
+    ? ARENA_HUGE_PAGE_SIZE : ARENA_DEFAULT_SIZE;
+}
+
+// Only the first block of a mapped arena is mapped; any after it are not.
+static inline bool arena_is_mapped_block(arena *a) {
+  return a->reserved && !a->block->prev;
+}
+
+static bool arena_commit_to(arena *a, uintptr_t next) {
+  uintptr_t end = arena_round_up(next, arena_commit_step(a));
+
+  if (end > (uintptr_t) a->reserved) {
+    end = (uintptr_t) a->reserved;
+  }
+
+  if (mprotect(a->block->end, end - (uintptr_t) a->block->end,
+        PROT_READ | PROT_WRITE)) {
+    return false;
+  }
+
+  a->end = a->block->end = (uint8_t *) end;
+
+  return true;
+}
+
+// Leaves a block's worth of committed pages above the top, so that a frame
+// pushed and popped in a loop doesn't fault them back in every time.
+static void arena_decommit_tail(arena *a) {
+  uintptr_t from = arena_round_up(
+      (uintptr_t) a->next + ARENA_DEFAULT_SIZE, sysconf(_SC_PAGESIZE));
+
+  if (!arena_is_mapped_block(a) || from >= (uintptr_t) a->end) {
+    return;
+  }
+
+#ifdef MADV_DONTNEED
+  madvise((void *) from, (uintptr_t) a->end - from, MADV_DONTNEED);
+#endif
+  mprotect((void *) from, (uintptr_t) a->end - from, PROT_NONE);
+
+  a->end = a->block->end = (uint8_t *) from;
+}
+
+FLYAPI arena *arena_new_mapped(size_t reserve) {
+  const size_t page = sysconf(_SC_PAGESIZE);
+  size_t commit;
+  void *base;
+
+  if (reserve < ARENA_MINIMUM_SIZE) {
+    reserve = ARENA_DEFAULT_SIZE;
+  }
+
+  if (reserve > SIZE_MAX - ARENA_HEADER_SIZE - page) {
+    fly_status = FLY_E_TOO_BIG;
+    return NULL;
+  }
+
+  reserve = arena_round_up(ARENA_HEADER_SIZE + reserve, page);
+  base = mmap(NULL, reserve, PROT_NONE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if (base == MAP_FAILED) {
     fly_status = FLY_E_OUT_OF_MEMORY;
+    return NULL;
   }
 
-  return ret;
+#ifdef MADV_HUGEPAGE
+  if (reserve >= ARENA_HUGE_PAGE_SIZE) {
+    madvise(base, reserve, MADV_HUGEPAGE);
+  }
+#endif
+
+  commit = arena_round_up(ARENA_HEADER_SIZE + ARENA_DEFAULT_SIZE, page);
+  commit = commit < reserve ? commit : reserve;
+
+  if (mprotect(base, commit, PROT_READ | PROT_WRITE)) {
+    munmap(base, reserve);
+    fly_status = FLY_E_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  arena_init(
+      (arena *) base, commit - ARENA_HEADER_SIZE, (uint8_t *) base + reserve);
+
+  return (arena *) base;
+}
+#else
+static inline bool arena_is_mapped_block(arena *a) {
+  (void) a;
+  return false;
 }
 
+static bool arena_commit_to(arena *a, uintptr_t next) {
+  (void) a;
+  (void) next;
+  return false;
+}
+
+static void arena_decommit_tail(arena *a) {
+  (void) a;
+}
+
+FLYAPI arena *arena_new_mapped(size_t reserve) {
+  return arena_new(reserve);
+}
+#endif
+
 static inline void arena_unwind(arena *a) {
   while (a->large) {
-    free(a->large->data);
+    free(a->large->raw);
     a->large = a->large->prev;
   }
   while (a->block->prev) {
     struct arena_block *abp = a->block->prev;
-    free(a->block);
+    arena_block_give(a, a->block);
     a->block = abp;
   }
 }
 
+// Each call is unlinked before it's made, in case it pushes or defers.
+static void arena_run_deferred(arena *a, bool all) {
+  while (a->deferred && (all || a->deferred->frame == a->frame)) {
+    struct arena_deferred *deferred = a->deferred;
+
+    a->deferred = deferred->prev;
+    deferred->fn(deferred->arg);
+  }
+}
+
 FLYAPI void arena_del(arena *a) {
+  arena_run_deferred(a, true);
   arena_unwind(a);
+  arena_set_spare_limit(a, 0);
+
+#ifdef ARENA_HAS_MMAP
+  if (a->reserved) {
+    munmap(a, a->reserved - (uint8_t *) a);
+    return;
+  }
+#endif
+
   free(a);
 }
 
+FLYAPI void arena_set_spare_limit(arena *a, size_t bytes) {
+  struct arena_block *spare = a->spares.blocks, *prev;
+
+  a->spares.blocks = NULL;
+  a->spares.size = 0;
+  a->spares.limit = bytes;
+
+  for (; spare; spare = prev) {
+    prev = spare->prev;
+    arena_block_give(a, spare);
+  }
+}
+
+FLYAPI void arena_set_global_spare_limit(size_t bytes) {
+  lock_global_spares();
+  global_spares.limit = bytes;
+  arena_spares_trim(&global_spares);
+  unlock_global_spares();
+}
+
 FLYAPI void *arena_alloc(arena *a, size_t size) {
   return arena_alloc_aligned(a, size, alignof (max_align_t));
 }
 
+static inline size_t arena_large_slack(size_t align) {
+  return align > alignof (max_align_t) ? align - 1 : 0;
+}
+
+static bool arena_large_malloc(
+    struct arena_large_alloc *large, size_t size, size_t align) {
+  const size_t slack = arena_large_slack(align);
+
+  if (size > SIZE_MAX - slack || !(large->raw = malloc(size + slack))) {
+    return false;
+  }
+
+  large->data = (void *) (((uintptr_t) large->raw + slack) & ~(align - 1));
+  large->align = align;
+
+  return true;
+}
+
+// realloc() keeps the bytes where they were relative to raw, which may not be
+// where the new raw puts data, so they're moved along if not.
+static bool arena_large_realloc(
+    struct arena_large_alloc *large, size_t old_size, size_t new_size) {
+  const size_t slack = arena_large_slack(large->align);
+  const size_t offset = (uint8_t *) large->data - (uint8_t *) large->raw;
+  uint8_t *raw;
+
+  if (!new_size) {
+    new_size = 1;
+  }
+
+  if (new_size > SIZE_MAX - slack
+      || !(raw = (uint8_t *) realloc(large->raw, new_size + slack))) {
+    return false;
+  }
+
+  large->raw = raw;
+  large->data = (void *) (((uintptr_t) raw + slack) & ~(large->align - 1));
+
+  if ((uint8_t *) large->data != raw + offset) {
+    memmove(
+        large->data, raw + offset, old_size < new_size ? old_size : new_size);
+  }
+
+  return true;
+}
+
+// The list holding chunks big enough for size, or NULL if there isn't one.
+static inline void **arena_free_list_for(arena *a, size_t size) {
+  if (!size || size > ARENA_SIZE_CLASS * ARENA_SIZE_CLASSES) {
+    return NULL;
+  }
+
+  return &a->free_lists[(size - 1) / ARENA_SIZE_CLASS];
+}
+
 FLYAPI void *arena_alloc_aligned(arena *a, size_t size, size_t align) {
   uintptr_t aligned, next;
+  void **list = arena_free_list_for(a, size);
+
+  if (list && *list && !((uintptr_t) *list & (align - 1))) {
+    void *chunk = *list;
+
+    fly_status = FLY_OK;
+    *list = *(void **) chunk;
+
+    return chunk;
+  }
 
 retry:
   aligned = ((uintptr_t) a->next + align - 1) & ~(align - 1);
   next = aligned + size;
 
   if (next > (uintptr_t) a->end) {
+    if (arena_is_mapped_block(a) && next <= (uintptr_t) a->reserved) {
+      if (!arena_commit_to(a, next)) {
+        fly_status = FLY_E_OUT_OF_MEMORY;
+        return NULL;
+      }
+
+      goto retry;
+    }
+
     size_t block_size = a->end - a->block->data;
 
     if (size > block_size || (size_t) (a->end - a->next) >= block_size / 64) {
@@ -69,35 +486,39 @@ retry:
       struct arena_large_alloc *large =
         arena_alloc_type(a, struct arena_large_alloc);
 
-      if (!large) {
+      if (!large || !arena_large_malloc(large, size, align)) {
+        arena_free(a, large);
         fly_status = FLY_E_OUT_OF_MEMORY;
         return NULL;
       }
 
+      arena_count_new_large(a, large, size);
+
       large->prev = a->large;
-      return (a->large = large)->data = malloc(size);
+      return (a->large = large)->data;
     }
 
-    size_t next_size = 2 * block_size;
-
-    struct arena_block *next_block =
-      (struct arena_block *) malloc(sizeof (struct arena_block) + next_size);
+    struct arena_block *next_block = arena_block_take(a, 2 * block_size);
 
     if (!next_block) {
       fly_status = FLY_E_OUT_OF_MEMORY;
       return NULL;
     }
 
+    arena_count_used(a, a->end - a->next);
     next_block->prev = a->block;
     a->block = next_block;
     a->next = next_block->data;
-    a->end = next_block->end = next_block->data + next_size;
+    a->end = next_block->end;
 
     goto retry;
   }
 
   fly_status = FLY_OK;
 
+  arena_count_padding(a, aligned - (uintptr_t) a->next);
+  arena_count_used(a, next - (uintptr_t) a->next);
+  a->last = (uint8_t *) aligned;
   a->next = (uint8_t *) next;
 
   return (void *) aligned;
@@ -125,14 +546,137 @@ FLYAPI void *arena_calloc_aligned(
   return ret;
 }
 
+static inline bool arena_roll_back(arena *a, void *ptr) {
+  if (ptr != a->last) {
+    return false;
+  }
+
+  arena_count_used(a, a->last - a->next);
+  a->next = a->last;
+  a->last = NULL;
+
+  return true;
+}
+
+// Nothing in the current block was malloc'd on its own, so only pointers
+// outside it need the walk.
+static struct arena_large_alloc *arena_find_large(arena *a, void *ptr) {
+  if ((uintptr_t) ptr >= (uintptr_t) a->block->data
+      && (uintptr_t) ptr < (uintptr_t) a->end) {
+    return NULL;
+  }
+
+  for (struct arena_large_alloc *large = a->large; large; large = large->prev) {
+    if (large->data == ptr) {
+      return large;
+    }
+  }
+
+  return NULL;
+}
+
+// The record itself can only go if it's the newest and no frame remembers
+// it, since arena_pop() walks the records back to the one it saved.
+static bool arena_free_large(arena *a, void *ptr) {
+  struct arena_large_alloc *large = arena_find_large(a, ptr);
+
+  if (!large) {
+    return false;
+  }
+
+  free(large->raw);
+  large->data = large->raw = NULL;
+  arena_count_large(a, large, 0);
+
+  if (large == a->large && (!a->frame || a->frame->context.large != large)) {
+    a->large = large->prev;
+    arena_roll_back(a, large);
+  }
+
+  return true;
+}
+
 FLYAPI void arena_free(arena *a, void *ptr) {
+  arena_free_sized(a, ptr, 0);
+}
+
+FLYAPI void arena_free_sized(arena *a, void *ptr, size_t size) {
+  fly_status = FLY_OK;
+
+  if (!ptr || arena_roll_back(a, ptr) || arena_free_large(a, ptr)) {
+    return;
+  }
+
+  // Filed under the largest class it can serve in full. The lists hand out
+  // chunks as max-aligned, and keep their links in them, so chunks that
+  // aren't are left where they are.
+  if (size >= ARENA_SIZE_CLASS
+      && !((uintptr_t) ptr & (ARENA_SIZE_CLASS - 1))) {
+    size_t class = size / ARENA_SIZE_CLASS;
+    void **list = &a->free_lists[
+      (class < ARENA_SIZE_CLASSES ? class : ARENA_SIZE_CLASSES) - 1];
+
+    *(void **) ptr = *list;
+    *list = ptr;
+  }
+}
+
+FLYAPI void *arena_realloc(
+    arena *a, void *ptr, size_t old_size, size_t new_size) {
+  struct arena_large_alloc *large;
+  void *ret;
+
+  if (!ptr) {
+    return arena_alloc(a, new_size);
+  }
+
+  if (ptr == a->last && new_size <= (size_t) (a->end - a->last)) {
+    fly_status = FLY_OK;
+    arena_count_used(a, a->last + new_size - a->next);
+    a->next = a->last + new_size;
+    return ptr;
+  }
+
+  if ((large = arena_find_large(a, ptr))) {
+    if (!arena_large_realloc(large, old_size, new_size)) {
+      fly_status = FLY_E_OUT_OF_MEMORY;
+      return NULL;
+    }
+
+    fly_status = FLY_OK;
+    arena_count_large(a, large, new_size);
+    return large->data;
+  }
+
+  if (new_size <= old_size) {
+    fly_status = FLY_OK;
+    return ptr;
+  }
+
+  if (!(ret = arena_alloc(a, new_size))) {
+    return NULL;
+  }
+
+  memcpy(ret, ptr, old_size);
+  arena_free_sized(a, ptr, old_size);
+  fly_status = FLY_OK;
+
+  return ret;
 }
 
 FLYAPI void arena_clear(arena *a) {
+  arena_run_deferred(a, true);
   arena_unwind(a);
   a->next = a->block->data;
+  a->last = NULL;
   a->end = a->block->end;
   a->frame = NULL;
+  memset(a->free_lists, 0, sizeof (a->free_lists));
+  arena_decommit_tail(a);
+
+#ifdef ARENA_STATS
+  a->counters.used = arena_used(a);
+#endif
 }
 
 FLYAPI void arena_push(arena *a) {
@@ -151,17 +695,22 @@ FLYAPI void arena_push(arena *a) {
   a->frame = frame;
 }
 
+extern inline arena *arena_scope_begin(arena *a);
+extern inline void arena_scope_end(arena **scope);
+
 FLYAPI void arena_pop(arena *a) {
   if (!a->frame) {
     fly_status = FLY_EMPTY;
     return;
   }
 
+  arena_run_deferred(a, false);
+
   for (struct arena_large_alloc *current = a->large,
                                 *target = a->frame->context.large;
        current && current != target;
        current = current->prev) {
-    free(current->data);
+    free(current->raw);
   }
 
   struct arena_block *tip = a->block;
@@ -169,13 +718,23 @@ FLYAPI void arena_pop(arena *a) {
   fly_status = FLY_OK;
   a->end = (a->context = a->frame->context).block->end;
   a->frame = a->frame->prev;
+  a->last = NULL;
+
+  // Some of the chunks may have been in blocks that are about to go.
+  memset(a->free_lists, 0, sizeof (a->free_lists));
 
   while (tip != a->block) {
     struct arena_block *next_tip = tip->prev;
 
-    free(tip);
+    arena_block_give(a, tip);
     tip = next_tip;
   }
+
+  arena_decommit_tail(a);
+
+#ifdef ARENA_STATS
+  a->counters.used = arena_used(a);
+#endif
 }
 
 FLYAPI void arena_commit(arena *a) {
@@ -185,5 +744,353 @@ FLYAPI void arena_commit(arena *a) {
   }
 
   fly_status = a->frame ? FLY_OK : FLY_EMPTY;
+
+  for (struct arena_deferred *deferred = a->deferred;
+       deferred && deferred->frame == a->frame;
+       deferred = deferred->prev) {
+    deferred->frame = a->frame->prev;
+  }
+
   a->frame = a->frame->prev;
 }
+
+FLYAPI void arena_defer(arena *a, void (*fn)(void *), void *arg) {
+  struct arena_deferred *deferred =
+    arena_alloc_type(a, struct arena_deferred);
+
+  if (!deferred) {
+    return;
+  }
+
+  deferred->prev = a->deferred;
+  deferred->frame = a->frame;
+  deferred->fn = fn;
+  deferred->arg = arg;
+  a->deferred = deferred;
+}
+
+FLYAPI void arena_stats(arena *a, struct arena_stats *out) {
+  *out = (struct arena_stats) { .reserved = a->spares.size };
+
+  for (struct arena_block *block = a->block; block; block = block->prev) {
+    out->blocks++;
+    out->reserved += block->end - block->data;
+  }
+
+  for (struct arena_large_alloc *large = a->large; large; large = large->prev) {
+    if (large->data) {
+      out->large_allocs++;
+#ifdef ARENA_STATS
+      out->large_bytes += large->size;
+#endif
+    }
+  }
+
+  for (struct arena_frame *frame = a->frame; frame; frame = frame->prev) {
+    out->frames++;
+  }
+
+  out->reserved += out->large_bytes;
+
+#ifdef ARENA_STATS
+  out->used = a->counters.used;
+  out->padding = a->counters.padding;
+  out->peak = a->counters.peak;
+#else
+  out->used = arena_used(a);
+#endif
+
+  fly_status = FLY_OK;
+}
+
+extern inline void arena_vec_init(
+    arena_vec *v, arena *a, size_t item_size, size_t align);
+
+FLYAPI bool arena_vec_reserve(arena_vec *v, size_t capacity) {
+  arena *a = v->arena;
+  void *items;
+
+  if (capacity <= v->capacity) {
+    fly_status = FLY_OK;
+    return true;
+  }
+
+  if (capacity > SIZE_MAX / v->item_size) {
+    fly_status = FLY_E_TOO_BIG;
+    return false;
+  }
+
+  size_t old_size = v->capacity * v->item_size;
+  size_t new_size = capacity * v->item_size;
+
+  // arena_realloc() only keeps max_align_t when it has to move things, and
+  // the first allocation may need less.
+  if (v->items && (v->align <= alignof (max_align_t)
+        || (v->items == a->last
+          && new_size <= (size_t) (a->end - a->last)))) {
+    items = arena_realloc(a, v->items, old_size, new_size);
+  } else if ((items = arena_alloc_aligned(a, new_size, v->align))
+      && v->items) {
+    memcpy(items, v->items, old_size);
+    arena_free_sized(a, v->items, old_size);
+  }
+
+  if (!items) {
+    return false;
+  }
+
+  v->items = items;
+  v->capacity = capacity;
+  fly_status = FLY_OK;
+
+  return true;
+}
+
+static bool arena_vec_grow(arena_vec *v, size_t n) {
+  size_t capacity = v->capacity ? v->capacity : ARENA_VEC_MIN_CAPACITY;
+
+  if (n > SIZE_MAX - v->size) {
+    fly_status = FLY_E_TOO_BIG;
+    return false;
+  }
+
+  while (capacity < v->size + n) {
+    capacity = capacity <= SIZE_MAX / 2 ? 2 * capacity : v->size + n;
+  }
+
+  return arena_vec_reserve(v, capacity);
+}
+
+FLYAPI void *arena_vec_push(arena_vec *v) {
+  return arena_vec_push_array(v, 1, NULL);
+}
+
+FLYAPI void *arena_vec_push_array(arena_vec *v, size_t n, const void *items) {
+  uint8_t *ret;
+
+  if (n > v->capacity - v->size && !arena_vec_grow(v, n)) {
+    return NULL;
+  }
+
+  ret = (uint8_t *) v->items + v->size * v->item_size;
+  v->size += n;
+  fly_status = FLY_OK;
+
+  if (items) {
+    memcpy(ret, items, n * v->item_size);
+  }
+
+  return ret;
+}
+
+static thread_local arena *local_arena = NULL;
+
+#ifndef __STDC_NO_THREADS__
+static tss_t local_arena_key;
+static once_flag local_arena_once = ONCE_FLAG_INIT;
+
+static void local_arena_dtor(void *a) {
+  arena_del((arena *) a);
+}
+
+static void local_arena_key_init(void) {
+  tss_create(&local_arena_key, &local_arena_dtor);
+}
+#endif
+
+FLYAPI arena *arena_local(void) {
+  if (local_arena) {
+    fly_status = FLY_OK;
+    return local_arena;
+  }
+
+  if (!(local_arena = arena_new(ARENA_DEFAULT_SIZE))) {
+    return NULL;
+  }
+
+#ifndef __STDC_NO_THREADS__
+  // The key's destructor frees the arena when the thread exits.
+  call_once(&local_arena_once, &local_arena_key_init);
+  tss_set(local_arena_key, local_arena);
+#endif
+
+  return local_arena;
+}
+
+FLYAPI void arena_local_del(void) {
+  if (!local_arena) {
+    return;
+  }
+
+#ifndef __STDC_NO_THREADS__
+  tss_set(local_arena_key, NULL);
+#endif
+
+  arena_del(local_arena);
+  local_arena = NULL;
+}
+
+#ifdef ARENA_HAS_SHARED
+static struct arena_shared_block *arena_shared_block_new(
+    size_t size, size_t used) {
+  struct arena_shared_block *ret = (struct arena_shared_block *)
+    malloc(sizeof (struct arena_shared_block) + size);
+
+  if (!ret) {
+    fly_status = FLY_E_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  ret->prev = NULL;
+  ret->size = size;
+  atomic_init(&ret->used, used);
+
+  return ret;
+}
+
+FLYAPI arena_shared *arena_shared_new(size_t size) {
+  arena_shared *ret = (arena_shared *) malloc(sizeof (arena_shared));
+  struct arena_shared_block *block;
+
+  if (size < ARENA_MINIMUM_SIZE) {
+    size = ARENA_DEFAULT_SIZE;
+  }
+
+  if (!ret) {
+    fly_status = FLY_E_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  if (!(block = arena_shared_block_new(size, 0))) {
+    free(ret);
+    return NULL;
+  }
+
+  if (mtx_init(&ret->lock, mtx_plain) != thrd_success) {
+    free(block);
+    free(ret);
+    fly_status = FLY_E_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  fly_status = FLY_OK;
+  atomic_init(&ret->block, block);
+
+  return ret;
+}
+
+FLYAPI void arena_shared_del(arena_shared *a) {
+  struct arena_shared_block *block = atomic_load(&a->block);
+
+  while (block) {
+    struct arena_shared_block *prev = block->prev;
+
+    free(block);
+    block = prev;
+  }
+
+  mtx_destroy(&a->lock);
+  free(a);
+}
+
+static inline void *arena_shared_align(void *ptr, size_t align) {
+  return (void *) (((uintptr_t) ptr + align - 1) & ~(uintptr_t) (align - 1));
+}
+
+// A failed add leaves `used` past the end, which is harmless: the block is
+// full as far as anyone else is concerned, and it's about to be replaced.
+static inline void *arena_shared_bump(
+    struct arena_shared_block *block, size_t n, size_t align) {
+  size_t offset;
+
+  if (n > block->size) {
+    return NULL;
+  }
+
+  offset = atomic_fetch_add_explicit(&block->used, n, memory_order_relaxed);
+
+  if (offset > block->size - n) {
+    return NULL;
+  }
+
+  return arena_shared_align(block->data + offset, align);
+}
+
+// Only one thread puts in the next block; the rest find it on their retry.
+// Requests over a quarter of a block get a block of their own, linked in
+// behind the current one so that it stays current.
+static void *arena_shared_refill(
+    arena_shared *a, struct arena_shared_block *seen, size_t n, size_t align) {
+  struct arena_shared_block *current, *block;
+  void *ret = NULL;
+
+  mtx_lock(&a->lock);
+  current = atomic_load_explicit(&a->block, memory_order_relaxed);
+
+  if (current != seen && (ret = arena_shared_bump(current, n, align))) {
+    mtx_unlock(&a->lock);
+    fly_status = FLY_OK;
+    return ret;
+  }
+
+  if (n > current->size / 4) {
+    if ((block = arena_shared_block_new(n, n))) {
+      block->prev = current->prev;
+      current->prev = block;
+    }
+  } else if ((block = arena_shared_block_new(2 * current->size, n))) {
+    block->prev = current;
+    atomic_store_explicit(&a->block, block, memory_order_release);
+  }
+
+  mtx_unlock(&a->lock);
+
+  if (block) {
+    fly_status = FLY_OK;
+    ret = arena_shared_align(block->data, align);
+  }
+
+  return ret;
+}
+
+FLYAPI void *arena_shared_alloc(arena_shared *a, size_t size) {
+  return arena_shared_alloc_aligned(a, size, alignof (max_align_t));
+}
+
+// Every request is rounded up to the block alignment, so offsets stay
+// aligned and only over-aligned requests need any slack.
+FLYAPI void *arena_shared_alloc_aligned(
+    arena_shared *a, size_t size, size_t align) {
+  const size_t slack = align > ARENA_SIZE_CLASS ? align - 1 : 0;
+  struct arena_shared_block *block;
+  void *ret;
+
+  if (size > SIZE_MAX - slack - ARENA_SIZE_CLASS) {
+    fly_status = FLY_E_TOO_BIG;
+    return NULL;
+  }
+
+  size = (size + slack + ARENA_SIZE_CLASS - 1) & ~(ARENA_SIZE_CLASS - 1);
+  block = atomic_load_explicit(&a->block, memory_order_acquire);
+
+  if ((ret = arena_shared_bump(block, size, align))) {
+    fly_status = FLY_OK;
+    return ret;
+  }
+
+  return arena_shared_refill(a, block, size, align);
+}
+
+// Keeps only the newest block, which is also the biggest.
+FLYAPI void arena_shared_clear(arena_shared *a) {
+  struct arena_shared_block *block = atomic_load(&a->block), *prev;
+
+  for (prev = block->prev; prev; prev = block->prev) {
+    block->prev = prev->prev;
+    free(prev);
+  }
+
+  atomic_store(&block->used, 0);
+  fly_status = FLY_OK;
+}
+#endif
@@ -0,0 +1,395 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "gapbuf.h"
+
+#include "jargon.h"
+
+static void gapbuf_init(gapbuf *l);
+static void gapbuf_del(gapbuf *l);
+static void *_unsafe_gapbuf_get(gapbuf *l, ptrdiff_t i);
+static void _unsafe_gapbuf_push(gapbuf *l, void *data);
+static void _unsafe_gapbuf_unshift(gapbuf *l, void *data);
+static void *_unsafe_gapbuf_pop(gapbuf *l);
+static void *_unsafe_gapbuf_shift(gapbuf *l);
+static void gapbuf_concat(gapbuf * restrict l1, gapbuf * restrict l2);
+static void _unsafe_gapbuf_append_array(gapbuf *l, size_t n, void **items);
+static void _unsafe_gapbuf_foreach(gapbuf *l, int (*)(void *, size_t));
+static void *_unsafe_gapbuf_find_first(gapbuf *l, int (*matcher)(void *));
+static void *_unsafe_gapbuf_discard(gapbuf *l, int (*matcher)(void *));
+static size_t _unsafe_gapbuf_discard_all(
+    gapbuf *l, int (*matcher)(void *), int (*fn)(void *, size_t));
+static void _unsafe_gapbuf_shuffle(gapbuf *l);
+static void _unsafe_gapbuf_sort(
+    gapbuf *l, int (*comp)(const void *, const void *));
+static void _unsafe_gapbuf_sort_stable(
+    gapbuf *l, int (*comp)(const void *, const void *));
+static void *_unsafe_gapbuf_select_nth(
+    gapbuf *l, size_t n, int (*comp)(const void *, const void *));
+static void _unsafe_gapbuf_partial_sort(
+    gapbuf *l, size_t k, int (*comp)(const void *, const void *));
+static size_t _unsafe_gapbuf_index_of(gapbuf *l, void *data);
+static size_t _unsafe_gapbuf_count_of(gapbuf *l, void *data);
+static void _unsafe_gapbuf_pop_many(gapbuf *l, size_t n, void **out);
+static void _unsafe_gapbuf_shift_many(gapbuf *l, size_t n, void **out);
+static void _unsafe_gapbuf_unshift_array(
+    gapbuf *l, size_t n, void **items);
+static void _unsafe_gapbuf_insert(gapbuf *l, size_t i, void *data);
+static void *_unsafe_gapbuf_remove_at(gapbuf *l, size_t i);
+static void _unsafe_gapbuf_reverse(gapbuf *l);
+static void _unsafe_gapbuf_rotate(gapbuf *l, size_t k);
+static void _unsafe_gapbuf_slice(gapbuf *l, size_t from, size_t n, list *dst);
+static void _unsafe_gapbuf_splice(
+    gapbuf *dst, size_t pos, gapbuf *src, size_t from, size_t n);
+static void _unsafe_gapbuf_iter(gapbuf *l, list_iter *it);
+
+FLYAPI listkind *LISTKIND_GAP = &(listkind) {
+  sizeof (gapbuf),
+  (void *) &gapbuf_init,
+  (void *) &gapbuf_del,
+  (void *) &_unsafe_gapbuf_get,
+  (void *) &_unsafe_gapbuf_push,
+  (void *) &_unsafe_gapbuf_unshift,
+  (void *) &_unsafe_gapbuf_pop,
+  (void *) &_unsafe_gapbuf_shift,
+  (void *) &gapbuf_concat,
+  (void *) &_unsafe_gapbuf_append_array,
+  (void *) &_unsafe_gapbuf_foreach,
+  (void *) &_unsafe_gapbuf_find_first,
+  (void *) &_unsafe_gapbuf_discard,
+  (void *) &_unsafe_gapbuf_discard_all,
+  (void *) &_unsafe_gapbuf_shuffle,
+  (void *) &_unsafe_gapbuf_sort,
+  (void *) &_unsafe_gapbuf_sort_stable,
+  (void *) &_unsafe_gapbuf_select_nth,
+  (void *) &_unsafe_gapbuf_partial_sort,
+  (void *) &_unsafe_gapbuf_index_of,
+  (void *) &_unsafe_gapbuf_count_of,
+  (void *) &_unsafe_gapbuf_pop_many,
+  (void *) &_unsafe_gapbuf_shift_many,
+  (void *) &_unsafe_gapbuf_unshift_array,
+  (void *) &_unsafe_gapbuf_insert,
+  (void *) &_unsafe_gapbuf_remove_at,
+  (void *) &_unsafe_gapbuf_reverse,
+  (void *) &_unsafe_gapbuf_rotate,
+  (void *) &_unsafe_gapbuf_slice,
+  (void *) &_unsafe_gapbuf_splice,
+  (void *) &_unsafe_gapbuf_iter,
+};
+
+static void gapbuf_init(gapbuf *l) {
+  l->size = 0;
+  l->capacity = 0;
+  l->items = NULL;
+  l->gap = 0;
+}
+
+static void gapbuf_del(gapbuf *l) {
+  free(l->items);
+}
+
+static inline size_t gapbuf_hole(gapbuf *l) {
+  return l->capacity - l->size;
+}
+
+// Only the items between the old and new gap positions move.
+static void gapbuf_move_gap(gapbuf *l, size_t to) {
+  const size_t hole = gapbuf_hole(l);
+
+  if (to < l->gap) {
+    memmove(
+        l->items + to + hole, l->items + to,
+        (l->gap - to) * sizeof (void *));
+  } else if (to > l->gap) {
+    memmove(
+        l->items + l->gap, l->items + l->gap + hole,
+        (to - l->gap) * sizeof (void *));
+  }
+
+  l->gap = to;
+}
+
+// Grows the buffer like an arlist, then slides the items after the gap back
+// against the new end.
+static bool gapbuf_reserve(gapbuf *l, size_t new_elements) {
+  const size_t old_capacity = l->capacity, tail = l->size - l->gap;
+
+  if (new_elements <= gapbuf_hole(l)) {
+    return true;
+  }
+
+  if (!arlist_grow((arlist *) l, new_elements)) {
+    return false;
+  }
+
+  memmove(
+      l->items + l->capacity - tail, l->items + old_capacity - tail,
+      tail * sizeof (void *));
+
+  return true;
+}
+
+static void *_unsafe_gapbuf_get(gapbuf *l, ptrdiff_t i) {
+  if (i < 0) {
+    i += l->size;
+  }
+
+  return l->items[(size_t) i < l->gap ? (size_t) i : i + gapbuf_hole(l)];
+}
+
+static void _unsafe_gapbuf_insert(gapbuf *l, size_t i, void *data) {
+  if (!gapbuf_reserve(l, 1)) {
+    return;
+  }
+
+  gapbuf_move_gap(l, i);
+  l->items[l->gap++] = data;
+  l->size++;
+}
+
+// Removes from whichever edge of the gap is nearer, so deleting backwards
+// from the gap and deleting forwards from it are both free.
+static void *_unsafe_gapbuf_remove_at(gapbuf *l, size_t i) {
+  void *ret;
+
+  if (i < l->gap) {
+    gapbuf_move_gap(l, i + 1);
+    ret = l->items[--l->gap];
+  } else {
+    gapbuf_move_gap(l, i);
+    ret = l->items[i + gapbuf_hole(l)];
+  }
+
+  l->size--;
+
+  return ret;
+}
+
+static void _unsafe_gapbuf_push(gapbuf *l, void *data) {
+  _unsafe_gapbuf_insert(l, l->size, data);
+}
+
+static void _unsafe_gapbuf_unshift(gapbuf *l, void *data) {
+  _unsafe_gapbuf_insert(l, 0, data);
+}
+
+static void *_unsafe_gapbuf_pop(gapbuf *l) {
+  return _unsafe_gapbuf_remove_at(l, l->size - 1);
+}
+
+static void *_unsafe_gapbuf_shift(gapbuf *l) {
+  return _unsafe_gapbuf_remove_at(l, 0);
+}
+
+static void _unsafe_gapbuf_append_array(gapbuf *l, size_t n, void **items) {
+  if (!gapbuf_reserve(l, n)) {
+    return;
+  }
+
+  gapbuf_move_gap(l, l->size);
+  memcpy(l->items + l->gap, items, n * sizeof (void *));
+  l->gap += n;
+  l->size += n;
+}
+
+static void _unsafe_gapbuf_unshift_array(
+    gapbuf *l, size_t n, void **items) {
+  if (!gapbuf_reserve(l, n)) {
+    return;
+  }
+
+  gapbuf_move_gap(l, 0);
+  memcpy(l->items, items, n * sizeof (void *));
+  l->gap = n;
+  l->size += n;
+}
+
+static void _unsafe_gapbuf_pop_many(gapbuf *l, size_t n, void **out) {
+  gapbuf_move_gap(l, l->size - n);
+  memcpy(out, l->items + l->capacity - n, n * sizeof (void *));
+  l->size -= n;
+}
+
+static void _unsafe_gapbuf_shift_many(gapbuf *l, size_t n, void **out) {
+  gapbuf_move_gap(l, n);
+  memcpy(out, l->items, n * sizeof (void *));
+  l->gap = 0;
+  l->size -= n;
+}
+
+// Closes the gap so the items can be handed to the arlist implementation.
+static void gapbuf_view(gapbuf *l, arlist *view) {
+  gapbuf_move_gap(l, l->size);
+
+  view->kind = LISTKIND_ARRAY;
+  view->size = l->size;
+  view->rng = l->rng;
+  view->capacity = l->capacity;
+  view->items = l->items;
+}
+
+static void gapbuf_unview(gapbuf *l, arlist *view) {
+  l->size = l->gap = view->size;
+  l->rng = view->rng;
+}
+
+static void gapbuf_concat(gapbuf * restrict l1, gapbuf * restrict l2) {
+  arlist view;
+
+  gapbuf_view(l2, &view);
+
+  if (view.size) {
+    _unsafe_gapbuf_append_array(l1, view.size, view.items);
+  }
+}
+
+static void _unsafe_gapbuf_foreach(gapbuf *l, int (*fn)(void *, size_t)) {
+  arlist view;
+
+  gapbuf_view(l, &view);
+  LISTKIND_ARRAY->foreach((list *) &view, fn);
+}
+
+static void *_unsafe_gapbuf_find_first(gapbuf *l, int (*matcher)(void *)) {
+  arlist view;
+
+  gapbuf_view(l, &view);
+  return LISTKIND_ARRAY->find_first((list *) &view, matcher);
+}
+
+static void *_unsafe_gapbuf_discard(gapbuf *l, int (*matcher)(void *)) {
+  arlist view;
+  void *ret;
+
+  gapbuf_view(l, &view);
+  ret = LISTKIND_ARRAY->discard((list *) &view, matcher);
+  gapbuf_unview(l, &view);
+
+  return ret;
+}
+
+static size_t _unsafe_gapbuf_discard_all(
+    gapbuf *l, int (*matcher)(void *), int (*fn)(void *, size_t)) {
+  arlist view;
+  size_t ret;
+
+  gapbuf_view(l, &view);
+  ret = LISTKIND_ARRAY->discard_all((list *) &view, matcher, fn);
+  gapbuf_unview(l, &view);
+
+  return ret;
+}
+
+static void _unsafe_gapbuf_shuffle(gapbuf *l) {
+  arlist view;
+
+  gapbuf_view(l, &view);
+  LISTKIND_ARRAY->shuffle((list *) &view);
+  gapbuf_unview(l, &view);
+}
+
+static void _unsafe_gapbuf_sort(
+    gapbuf *l, int (*comp)(const void *, const void *)) {
+  arlist view;
+
+  gapbuf_view(l, &view);
+  LISTKIND_ARRAY->sort((list *) &view, comp);
+}
+
+static void _unsafe_gapbuf_sort_stable(
+    gapbuf *l, int (*comp)(const void *, const void *)) {
+  arlist view;
+
+  gapbuf_view(l, &view);
+  LISTKIND_ARRAY->sort_stable((list *) &view, comp);
+}
+
+static void *_unsafe_gapbuf_select_nth(
+    gapbuf *l, size_t n, int (*comp)(const void *, const void *)) {
+  arlist view;
+
+  gapbuf_view(l, &view);
+  return LISTKIND_ARRAY->select_nth((list *) &view, n, comp);
+}
+
+static void _unsafe_gapbuf_partial_sort(
+    gapbuf *l, size_t k, int (*comp)(const void *, const void *)) {
+  arlist view;
+
+  gapbuf_view(l, &view);
+  LISTKIND_ARRAY->partial_sort((list *) &view, k, comp);
+}
+
+static size_t _unsafe_gapbuf_index_of(gapbuf *l, void *data) {
+  arlist view;
+
+  gapbuf_view(l, &view);
+  return LISTKIND_ARRAY->index_of((list *) &view, data);
+}
+
+static size_t _unsafe_gapbuf_count_of(gapbuf *l, void *data) {
+  arlist view;
+
+  gapbuf_view(l, &view);
+  return LISTKIND_ARRAY->count_of((list *) &view, data);
+}
+
+static void _unsafe_gapbuf_reverse(gapbuf *l) {
+  arlist view;
+
+  gapbuf_view(l, &view);
+  LISTKIND_ARRAY->reverse((list *) &view);
+}
+
+static void _unsafe_gapbuf_rotate(gapbuf *l, size_t k) {
+  arlist view;
+
+  gapbuf_view(l, &view);
+  LISTKIND_ARRAY->rotate((list *) &view, k);
+}
+
+// Copies the parts of the range on either side of the gap, leaving it be.
+static void _unsafe_gapbuf_slice(gapbuf *l, size_t from, size_t n, list *dst) {
+  size_t before = from < l->gap ? l->gap - from : 0;
+
+  if (before >= n) {
+    dst->kind->append_array(dst, n, l->items + from);
+    return;
+  }
+
+  if (before) {
+    dst->kind->append_array(dst, before, l->items + from);
+
+    if (fly_status != FLY_OK) {
+      return;
+    }
+  }
+
+  dst->kind->append_array(
+      dst, n - before, l->items + from + before + gapbuf_hole(l));
+}
+
+// Brings the range up against src's gap and dst's gap to pos, then copies
+// the range across, so both gaps end up where the edit happened.
+static void _unsafe_gapbuf_splice(
+    gapbuf *dst, size_t pos, gapbuf *src, size_t from, size_t n) {
+  if (!gapbuf_reserve(dst, n)) {
+    return;
+  }
+
+  gapbuf_move_gap(dst, pos);
+  gapbuf_move_gap(src, from + n);
+  memcpy(dst->items + pos, src->items + from, n * sizeof (void *));
+
+  dst->gap += n;
+  dst->size += n;
+  src->gap = from;
+  src->size -= n;
+}
+
+// The runs on either side of the gap.
+static void _unsafe_gapbuf_iter(gapbuf *l, list_iter *it) {
+  list_iter_init_runs(
+      it, l->items, l->gap,
+      l->items + l->gap + gapbuf_hole(l), l->size - l->gap);
+}
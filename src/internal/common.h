@@ -25,4 +25,12 @@
 #endif /* _MSC_VER */
 #endif /* ASSUME */
 
+#ifndef PREFETCH
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr) ((void) (addr))
+#endif
+#endif /* PREFETCH */
+
 #endif
@@ -21,9 +21,17 @@
 #include <stdbool.h>
 #include <string.h>
 
+#ifndef __STDC_NO_THREADS__
+#include <threads.h>
+#endif
+
 #include "list.h"
 #include "internal/common.h"
 
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
 #include "jargon.h"
 
 typedef struct sllistnode sllistnode;
@@ -56,6 +64,13 @@ extern inline void *deque_pop(deque *l);
 extern inline void deque_unshift(deque *l, void *data);
 extern inline void *deque_shift(deque *l);
 extern inline void *deque_pick(deque *l);
+extern inline size_t deque_first_segment(deque *l);
+
+extern inline void list_iter_init_runs(list_iter *it, void **first,
+    size_t first_size, void **second, size_t second_size);
+extern inline bool list_iter_has_next(list_iter *it);
+extern inline void *list_iter_peek(list_iter *it);
+extern inline void *list_iter_next(list_iter *it);
 
 static void arlist_init(arlist *l);
 static void arlist_del(arlist *l);
@@ -68,6 +83,26 @@ static size_t _unsafe_arlist_discard_all(
 static void _unsafe_arlist_shuffle(arlist *l);
 static void _unsafe_arlist_sort(
     arlist *l, int (*comp)(const void *, const void *));
+static void _unsafe_arlist_sort_stable(
+    arlist *l, int (*comp)(const void *, const void *));
+static void *_unsafe_arlist_select_nth(
+    arlist *l, size_t n, int (*comp)(const void *, const void *));
+static void _unsafe_arlist_partial_sort(
+    arlist *l, size_t k, int (*comp)(const void *, const void *));
+static size_t _unsafe_arlist_index_of(arlist *l, void *data);
+static size_t _unsafe_arlist_count_of(arlist *l, void *data);
+static void _unsafe_arlist_pop_many(arlist *l, size_t n, void **out);
+static void _unsafe_arlist_shift_many(arlist *l, size_t n, void **out);
+static void _unsafe_arlist_unshift_array(
+    arlist *l, size_t n, void **items);
+static void _unsafe_arlist_insert(arlist *l, size_t i, void *data);
+static void *_unsafe_arlist_remove_at(arlist *l, size_t i);
+static void _unsafe_arlist_reverse(arlist *l);
+static void _unsafe_arlist_rotate(arlist *l, size_t k);
+static void _unsafe_arlist_slice(arlist *l, size_t from, size_t n, list *dst);
+static void _unsafe_arlist_splice(
+    arlist *dst, size_t pos, arlist *src, size_t from, size_t n);
+static void _unsafe_arlist_iter(arlist *l, list_iter *it);
 
 static void deque_init(deque *l);
 static void _unsafe_deque_append_array(deque *l, size_t n, void **items);
@@ -79,6 +114,26 @@ static size_t _unsafe_deque_discard_all(
 static void _unsafe_deque_shuffle(deque *l);
 static void _unsafe_deque_sort(
     deque *l, int (*comp)(const void *, const void *));
+static void _unsafe_deque_sort_stable(
+    deque *l, int (*comp)(const void *, const void *));
+static void *_unsafe_deque_select_nth(
+    deque *l, size_t n, int (*comp)(const void *, const void *));
+static void _unsafe_deque_partial_sort(
+    deque *l, size_t k, int (*comp)(const void *, const void *));
+static size_t _unsafe_deque_index_of(deque *l, void *data);
+static size_t _unsafe_deque_count_of(deque *l, void *data);
+static void _unsafe_deque_pop_many(deque *l, size_t n, void **out);
+static void _unsafe_deque_shift_many(deque *l, size_t n, void **out);
+static void _unsafe_deque_unshift_array(
+    deque *l, size_t n, void **items);
+static void _unsafe_deque_insert(deque *l, size_t i, void *data);
+static void *_unsafe_deque_remove_at(deque *l, size_t i);
+static void _unsafe_deque_reverse(deque *l);
+static void _unsafe_deque_rotate(deque *l, size_t k);
+static void _unsafe_deque_slice(deque *l, size_t from, size_t n, list *dst);
+static void _unsafe_deque_splice(
+    deque *dst, size_t pos, deque *src, size_t from, size_t n);
+static void _unsafe_deque_iter(deque *l, list_iter *it);
 
 static void dllist_init(dllist *l);
 static void dllist_del(dllist *l);
@@ -94,6 +149,21 @@ static size_t _unsafe_dllist_discard_all(
 static void _unsafe_dllist_shuffle(dllist *l);
 static void _unsafe_dllist_sort(
     dllist *l, int (*comp)(const void *, const void *));
+static void *_unsafe_dllist_select_nth(
+    dllist *l, size_t n, int (*comp)(const void *, const void *));
+static void _unsafe_dllist_partial_sort(
+    dllist *l, size_t k, int (*comp)(const void *, const void *));
+static void _unsafe_dllist_pop_many(dllist *l, size_t n, void **out);
+static void _unsafe_dllist_shift_many(dllist *l, size_t n, void **out);
+static void _unsafe_dllist_unshift_array(
+    dllist *l, size_t n, void **items);
+static void _unsafe_dllist_insert(dllist *l, size_t i, void *data);
+static void *_unsafe_dllist_remove_at(dllist *l, size_t i);
+static void _unsafe_dllist_reverse(dllist *l);
+static void _unsafe_dllist_rotate(dllist *l, size_t k);
+static void _unsafe_dllist_slice(dllist *l, size_t from, size_t n, list *dst);
+static void _unsafe_dllist_splice(
+    dllist *dst, size_t pos, dllist *src, size_t from, size_t n);
 
 static void sllist_init(sllist *l);
 static void sllist_del(sllist *l);
@@ -111,6 +181,24 @@ static size_t _unsafe_sllist_discard_all(
 static void _unsafe_sllist_shuffle(sllist *l);
 static void _unsafe_sllist_sort(
     sllist *l, int (*comp)(const void *, const void *));
+static void *_unsafe_sllist_select_nth(
+    sllist *l, size_t n, int (*comp)(const void *, const void *));
+static void _unsafe_sllist_partial_sort(
+    sllist *l, size_t k, int (*comp)(const void *, const void *));
+static size_t _unsafe_sllist_index_of(sllist *l, void *data);
+static size_t _unsafe_sllist_count_of(sllist *l, void *data);
+static void _unsafe_sllist_pop_many(sllist *l, size_t n, void **out);
+static void _unsafe_sllist_shift_many(sllist *l, size_t n, void **out);
+static void _unsafe_sllist_unshift_array(
+    sllist *l, size_t n, void **items);
+static void _unsafe_sllist_insert(sllist *l, size_t i, void *data);
+static void *_unsafe_sllist_remove_at(sllist *l, size_t i);
+static void _unsafe_sllist_reverse(sllist *l);
+static void _unsafe_sllist_rotate(sllist *l, size_t k);
+static void _unsafe_sllist_slice(sllist *l, size_t from, size_t n, list *dst);
+static void _unsafe_sllist_splice(
+    sllist *dst, size_t pos, sllist *src, size_t from, size_t n);
+static void _unsafe_sllist_iter(sllist *l, list_iter *it);
 
 #ifdef __TURBOC__
 #define ASSIGN_STATIC_PTR(KIND) \
@@ -139,6 +227,21 @@ ASSIGN_STATIC_PTR(LISTKIND_ARRAY) {
   (void *) &_unsafe_arlist_discard_all,
   (void *) &_unsafe_arlist_shuffle,
   (void *) &_unsafe_arlist_sort,
+  (void *) &_unsafe_arlist_sort_stable,
+  (void *) &_unsafe_arlist_select_nth,
+  (void *) &_unsafe_arlist_partial_sort,
+  (void *) &_unsafe_arlist_index_of,
+  (void *) &_unsafe_arlist_count_of,
+  (void *) &_unsafe_arlist_pop_many,
+  (void *) &_unsafe_arlist_shift_many,
+  (void *) &_unsafe_arlist_unshift_array,
+  (void *) &_unsafe_arlist_insert,
+  (void *) &_unsafe_arlist_remove_at,
+  (void *) &_unsafe_arlist_reverse,
+  (void *) &_unsafe_arlist_rotate,
+  (void *) &_unsafe_arlist_slice,
+  (void *) &_unsafe_arlist_splice,
+  (void *) &_unsafe_arlist_iter,
 };
 
 ASSIGN_STATIC_PTR(LISTKIND_DEQUE) {
@@ -158,6 +261,21 @@ ASSIGN_STATIC_PTR(LISTKIND_DEQUE) {
   (void *) &_unsafe_deque_discard_all,
   (void *) &_unsafe_deque_shuffle,
   (void *) &_unsafe_deque_sort,
+  (void *) &_unsafe_deque_sort_stable,
+  (void *) &_unsafe_deque_select_nth,
+  (void *) &_unsafe_deque_partial_sort,
+  (void *) &_unsafe_deque_index_of,
+  (void *) &_unsafe_deque_count_of,
+  (void *) &_unsafe_deque_pop_many,
+  (void *) &_unsafe_deque_shift_many,
+  (void *) &_unsafe_deque_unshift_array,
+  (void *) &_unsafe_deque_insert,
+  (void *) &_unsafe_deque_remove_at,
+  (void *) &_unsafe_deque_reverse,
+  (void *) &_unsafe_deque_rotate,
+  (void *) &_unsafe_deque_slice,
+  (void *) &_unsafe_deque_splice,
+  (void *) &_unsafe_deque_iter,
 };
 
 ASSIGN_STATIC_PTR(LISTKIND_DLINK) {
@@ -177,6 +295,21 @@ ASSIGN_STATIC_PTR(LISTKIND_DLINK) {
   (void *) &_unsafe_dllist_discard_all,
   (void *) &_unsafe_dllist_shuffle,
   (void *) &_unsafe_dllist_sort,
+  (void *) &_unsafe_dllist_sort,  /* already stable */
+  (void *) &_unsafe_dllist_select_nth,
+  (void *) &_unsafe_dllist_partial_sort,
+  (void *) &_unsafe_sllist_index_of,  /* not a typo */
+  (void *) &_unsafe_sllist_count_of,
+  (void *) &_unsafe_dllist_pop_many,
+  (void *) &_unsafe_dllist_shift_many,
+  (void *) &_unsafe_dllist_unshift_array,
+  (void *) &_unsafe_dllist_insert,
+  (void *) &_unsafe_dllist_remove_at,
+  (void *) &_unsafe_dllist_reverse,
+  (void *) &_unsafe_dllist_rotate,
+  (void *) &_unsafe_dllist_slice,
+  (void *) &_unsafe_dllist_splice,
+  (void *) &_unsafe_sllist_iter,  /* not a typo */
 };
 
 ASSIGN_STATIC_PTR(LISTKIND_SLINK) {
@@ -196,6 +329,21 @@ ASSIGN_STATIC_PTR(LISTKIND_SLINK) {
   (void *) &_unsafe_sllist_discard_all,
   (void *) &_unsafe_sllist_shuffle,
   (void *) &_unsafe_sllist_sort,
+  (void *) &_unsafe_sllist_sort,  /* already stable */
+  (void *) &_unsafe_sllist_select_nth,
+  (void *) &_unsafe_sllist_partial_sort,
+  (void *) &_unsafe_sllist_index_of,
+  (void *) &_unsafe_sllist_count_of,
+  (void *) &_unsafe_sllist_pop_many,
+  (void *) &_unsafe_sllist_shift_many,
+  (void *) &_unsafe_sllist_unshift_array,
+  (void *) &_unsafe_sllist_insert,
+  (void *) &_unsafe_sllist_remove_at,
+  (void *) &_unsafe_sllist_reverse,
+  (void *) &_unsafe_sllist_rotate,
+  (void *) &_unsafe_sllist_slice,
+  (void *) &_unsafe_sllist_splice,
+  (void *) &_unsafe_sllist_iter,
 };
 
 #undef ASSIGN_STATIC_PTR
@@ -394,6 +542,228 @@ FLYAPI void list_append_array(list *l, size_t n, void **items) {
   l->kind->append_array(l, n, items);
 }
 
+FLYAPI void list_unshift_array(list *l, size_t n, void **items) {
+  FLY_BAIL_IF_NULL(l && items);
+
+  if (n > PTRINDEX_MAX - l->size) {
+    fly_status = FLY_E_TOO_BIG;
+    return;
+  }
+
+  fly_status = FLY_OK;
+
+  if (!n) {
+    return;
+  }
+
+  l->kind->unshift_array(l, n, items);
+}
+
+FLYAPI size_t list_pop_many(list *l, size_t n, void **out) {
+  FLY_BAIL_IF_NULL(l && (out || !n), 0);
+  FLY_BAIL_IF_EMPTY(l->size, 0);
+
+  fly_status = FLY_OK;
+
+  if (n > l->size) {
+    n = l->size;
+  }
+
+  if (n) {
+    l->kind->pop_many(l, n, out);
+  }
+
+  return n;
+}
+
+FLYAPI size_t list_shift_many(list *l, size_t n, void **out) {
+  FLY_BAIL_IF_NULL(l && (out || !n), 0);
+  FLY_BAIL_IF_EMPTY(l->size, 0);
+
+  fly_status = FLY_OK;
+
+  if (n > l->size) {
+    n = l->size;
+  }
+
+  if (n) {
+    l->kind->shift_many(l, n, out);
+  }
+
+  return n;
+}
+
+FLYAPI size_t list_drain_into_array(list *l, void **out) {
+  size_t n;
+
+  FLY_BAIL_IF_NULL(l && (out || !l->size), 0);
+
+  fly_status = FLY_OK;
+
+  if ((n = l->size)) {
+    l->kind->shift_many(l, n, out);
+  }
+
+  return n;
+}
+
+FLYAPI void list_insert(list *l, ptrdiff_t i, void *data) {
+  FLY_BAIL_IF_NULL(l);
+
+  if (i < 0) {
+    i += (ptrdiff_t) l->size;
+  }
+
+  if ((size_t) i > l->size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return;
+  }
+
+  fly_status = FLY_OK;
+
+  l->kind->insert(l, (size_t) i, data);
+}
+
+FLYAPI void *list_remove_at(list *l, ptrdiff_t i) {
+  if (list_bad_call(l, i)) {
+    return NULL;
+  }
+
+  if (i < 0) {
+    i += (ptrdiff_t) l->size;
+  }
+
+  return l->kind->remove_at(l, (size_t) i);
+}
+
+FLYAPI void list_reverse(list *l) {
+  FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
+
+  if (l->size > 1) {
+    l->kind->reverse(l);
+  }
+}
+
+FLYAPI void list_rotate(list *l, ptrdiff_t k) {
+  size_t left;
+
+  FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
+
+  if (l->size < 2) {
+    return;
+  }
+
+  // written so that PTRDIFF_MIN doesn't overflow
+  if (k < 0) {
+    left = l->size - 1 - (size_t) -(k + 1) % l->size;
+  } else {
+    left = (size_t) k % l->size;
+  }
+
+  if (left) {
+    l->kind->rotate(l, left);
+  }
+}
+
+static inline enum FLY_STATUS list_bad_range(
+    list *l, ptrdiff_t *from, ptrdiff_t *to) {
+  if (*from < 0) {
+    *from += (ptrdiff_t) l->size;
+  }
+  if (*to < 0) {
+    *to += (ptrdiff_t) l->size;
+  }
+
+  if (*from < 0 || *from > *to || (size_t) *to > l->size) {
+    return fly_status = FLY_E_OUT_OF_RANGE;
+  }
+
+  return fly_status = FLY_OK;
+}
+
+FLYAPI list *list_slice(list *l, ptrdiff_t from, ptrdiff_t to) {
+  enum FLY_STATUS status;
+  list *ret;
+
+  FLY_BAIL_IF_NULL(l, NULL);
+
+  if (list_bad_range(l, &from, &to)) {
+    return NULL;
+  }
+
+  if (!(ret = list_new_kind(l->kind))) {
+    return NULL;
+  }
+
+  if (to > from) {
+    l->kind->slice(l, (size_t) from, (size_t) (to - from), ret);
+
+    if ((status = fly_status) != FLY_OK) {
+      list_del(ret);
+      fly_status = status;
+      return NULL;
+    }
+  }
+
+  return ret;
+}
+
+FLYAPI void list_splice(
+    list *dst, ptrdiff_t pos, list *src, ptrdiff_t from, ptrdiff_t to) {
+  size_t n;
+  void *data;
+
+  FLY_BAIL_IF_NULL(dst && src);
+
+  if (dst == src) {
+    fly_status = FLY_E_INVALID_ARG;
+    return;
+  }
+
+  if (list_bad_range(src, &from, &to)) {
+    return;
+  }
+
+  if (pos < 0) {
+    pos += (ptrdiff_t) dst->size;
+  }
+
+  if (pos < 0 || (size_t) pos > dst->size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return;
+  }
+
+  if ((n = (size_t) (to - from)) > PTRINDEX_MAX - dst->size) {
+    fly_status = FLY_E_TOO_BIG;
+    return;
+  }
+
+  if (!n) {
+    return;
+  }
+
+  if (dst->kind == src->kind) {
+    dst->kind->splice(dst, (size_t) pos, src, (size_t) from, n);
+    return;
+  }
+
+  // Different kinds can only trade one item at a time, back to front so that
+  // each lands in front of the one before it.
+  while (n--) {
+    data = src->kind->remove_at(src, (size_t) from + n);
+    dst->kind->insert(dst, (size_t) pos, data);
+
+    if (fly_status != FLY_OK) {
+      src->kind->insert(src, (size_t) from + n, data);
+      return;
+    }
+  }
+}
+
 static void *_unsafe_arlist_find_first(arlist *l, int (*matcher)(void *)) {
   size_t i;
   void **each = l->items;
@@ -464,126 +834,369 @@ FLYAPI void *list_find_first(list *l, int (*matcher)(void *)) {
   return l->kind->find_first(l, matcher);
 }
 
-static void *_unsafe_arlist_discard(arlist *l, int (*matcher)(void *)) {
+// Exact pointer search doesn't need a matcher call per item. On x86-64 the
+// array kinds compare four pointers per step with SSE2, or eight with AVX2
+// when the CPU has it; everything else walks the items one at a time.
+#if defined(__x86_64__) || defined(_M_X64)
+#define LIST_SEARCH_SSE2
+#if defined(__GNUC__) || defined(__clang__)
+#define LIST_SEARCH_AVX2
+#endif
+#endif
+
+static size_t array_index_of_scalar(void **items, size_t size, void *data) {
   size_t i = 0;
 
-  while (i < l->size) {
-    if (matcher(l->items[i++])) {
-      void *ret = l->items[i - 1];
+  while (i < size && items[i] != data) {
+    i++;
+  }
 
-      memmove(
-          l->items + i - 1, l->items + i,
-          (l->size - i) * sizeof (void *));
+  return i;
+}
 
-      l->size--;
+static size_t array_count_of_scalar(void **items, size_t size, void *data) {
+  size_t count = 0;
 
-      fly_status = FLY_OK;
-      return ret;
-    }
+  for (size_t i = 0; i < size; i++) {
+    count += items[i] == data;
   }
 
-  fly_status = FLY_NOT_FOUND;
-  return NULL;
+  return count;
 }
 
-static inline size_t _deque_inc_start(deque *l) {
-  if (l->start == l->capacity - 1) {
-    const size_t old_start = l->start;
-    l->start = 0;
-    return old_start;
-  } else {
-    return l->start++;
-  }
-}
+#ifdef LIST_SEARCH_SSE2
+// SSE2 has no 64-bit compare, so a pointer matches where both halves do.
+static __m128i sse2_cmpeq_ptr(void **items, __m128i needle) {
+  __m128i eq = _mm_cmpeq_epi32(
+      _mm_loadu_si128((const __m128i *) items), needle);
 
-static inline size_t _deque_dec_end(deque *l) {
-  if (l->end) {
-    return l->end--;
-  } else {
-    l->end = l->capacity - 1;
-    return 0;
-  }
+  return _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
 }
 
-static inline void *_deque_nudge_left(void **item, void **start) {
-  void *found = *item;
-  memmove(start + 1, start, (item - start) * sizeof (void *));
-  return found;
-}
+static size_t array_index_of_sse2(void **items, size_t size, void *data) {
+  const __m128i needle = _mm_set1_epi64x((long long) (uintptr_t) data);
+  __m128i lo, hi;
+  size_t i;
+  int mask;
 
-static inline void *_deque_nudge_right(void **item, void **end) {
-  void *found = *item;
-  memmove(item, item + 1, (end - item) * sizeof (void *));
-  return found;
-}
+  for (i = 0; i + 4 <= size; i += 4) {
+    lo = sse2_cmpeq_ptr(items + i, needle);
+    hi = sse2_cmpeq_ptr(items + i + 2, needle);
 
-static void *_unsafe_deque_discard(deque *l, int (*matcher)(void *)) {
-  void ** const boundary = l->items + l->capacity;
-  void ** const segment = l->end <= l->start ? boundary : l->items + l->end;
+    if ((mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(lo, hi))))) {
+      mask = _mm_movemask_pd(_mm_castsi128_pd(lo))
+        | _mm_movemask_pd(_mm_castsi128_pd(hi)) << 2;
 
-  void **item = l->items + l->start;
+      for (; !(mask & 1); mask >>= 1) {
+        i++;
+      }
 
-  if (matcher(*item)) {
-    fly_status = FLY_OK;
+      return i;
+    }
+  }
 
-    l->size--;
-    _deque_inc_start(l);
-    return *item;
+  return i + array_index_of_scalar(items + i, size - i, data);
+}
+
+// Matching lanes are all ones, so subtracting them counts up by one.
+static size_t array_count_of_sse2(void **items, size_t size, void *data) {
+  const __m128i needle = _mm_set1_epi64x((long long) (uintptr_t) data);
+  __m128i counts = _mm_setzero_si128();
+  size_t i;
+
+  for (i = 0; i + 4 <= size; i += 4) {
+    counts = _mm_sub_epi64(counts, sse2_cmpeq_ptr(items + i, needle));
+    counts = _mm_sub_epi64(counts, sse2_cmpeq_ptr(items + i + 2, needle));
   }
 
-  while (++item < segment) {
-    if (matcher(*item)) {
-      fly_status = FLY_OK;
+  return (size_t) _mm_cvtsi128_si64(counts)
+    + (size_t) _mm_cvtsi128_si64(_mm_unpackhi_epi64(counts, counts))
+    + array_count_of_scalar(items + i, size - i, data);
+}
+#endif  /* LIST_SEARCH_SSE2 */
 
-      l->size--;
+#ifdef LIST_SEARCH_AVX2
+__attribute__((target("avx2")))
+static size_t array_index_of_avx2(void **items, size_t size, void *data) {
+  const __m256i needle = _mm256_set1_epi64x((long long) (uintptr_t) data);
+  __m256i lo, hi, any;
+  size_t i;
+  int mask;
 
-      if ((segment == boundary && l->end)
-          || item - (l->items + l->start) < segment - item) {
-        return _deque_nudge_left(item, l->items + _deque_inc_start(l));
-      } else {
-        const size_t prev_end = _deque_dec_end(l);
+  for (i = 0; i + 8 <= size; i += 8) {
+    lo = _mm256_cmpeq_epi64(
+        _mm256_loadu_si256((const __m256i *) (items + i)), needle);
+    hi = _mm256_cmpeq_epi64(
+        _mm256_loadu_si256((const __m256i *) (items + i + 4)), needle);
+    any = _mm256_or_si256(lo, hi);
 
-        if (item == segment - 1 && (segment != boundary || prev_end == 0)) {
-          return *item;
-        }
-        return _deque_nudge_right(item, segment - 1);
+    if (!_mm256_testz_si256(any, any)) {
+      mask = _mm256_movemask_pd(_mm256_castsi256_pd(lo))
+        | _mm256_movemask_pd(_mm256_castsi256_pd(hi)) << 4;
+
+      for (; !(mask & 1); mask >>= 1) {
+        i++;
       }
+
+      return i;
     }
   }
 
-  if (item == boundary) {
-    void ** const end = (item = l->items) + l->end;
+  return i + array_index_of_scalar(items + i, size - i, data);
+}
 
-    for (; item < end; item++) {
-      if (matcher(*item)) {
-        l->size--;
-        l->end--;
-        fly_status = FLY_OK;
-        return _deque_nudge_right(item, end);
-      }
-    }
+__attribute__((target("avx2")))
+static size_t array_count_of_avx2(void **items, size_t size, void *data) {
+  const __m256i needle = _mm256_set1_epi64x((long long) (uintptr_t) data);
+  __m256i counts = _mm256_setzero_si256();
+  __m128i sum;
+  size_t i;
+
+  for (i = 0; i + 8 <= size; i += 8) {
+    counts = _mm256_sub_epi64(counts, _mm256_cmpeq_epi64(
+          _mm256_loadu_si256((const __m256i *) (items + i)), needle));
+    counts = _mm256_sub_epi64(counts, _mm256_cmpeq_epi64(
+          _mm256_loadu_si256((const __m256i *) (items + i + 4)), needle));
   }
 
-  fly_status = FLY_NOT_FOUND;
-  return NULL;
-}
+  sum = _mm_add_epi64(_mm256_castsi256_si128(counts),
+      _mm256_extracti128_si256(counts, 1));
 
-static inline void dllist_stitch(dllistnode *current) {
-  current->prev->next = current->next;
-  current->next->prev = current->prev;
+  return (size_t) _mm_cvtsi128_si64(sum)
+    + (size_t) _mm_cvtsi128_si64(_mm_unpackhi_epi64(sum, sum))
+    + array_count_of_scalar(items + i, size - i, data);
 }
+#endif  /* LIST_SEARCH_AVX2 */
 
-static inline void sllist_stitch(
-    sllistnode *current, sllistnode *prev, sllist * restrict l) {
-  if (current == l->last) {
-    l->last = prev;
+// Returns size if data isn't there.
+static size_t unsafe_array_index_of(void **items, size_t size, void *data) {
+#ifdef LIST_SEARCH_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    return array_index_of_avx2(items, size, data);
   }
-
-  prev->next = current->next;
+#endif
+#ifdef LIST_SEARCH_SSE2
+  return array_index_of_sse2(items, size, data);
+#else
+  return array_index_of_scalar(items, size, data);
+#endif
 }
 
-static void *_unsafe_dllist_discard(dllist *l, int (*matcher)(void *)) {
-  dllistnode *head = l->head,
+static size_t unsafe_array_count_of(void **items, size_t size, void *data) {
+#ifdef LIST_SEARCH_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    return array_count_of_avx2(items, size, data);
+  }
+#endif
+#ifdef LIST_SEARCH_SSE2
+  return array_count_of_sse2(items, size, data);
+#else
+  return array_count_of_scalar(items, size, data);
+#endif
+}
+
+#undef LIST_SEARCH_SSE2
+#undef LIST_SEARCH_AVX2
+
+static size_t _unsafe_arlist_index_of(arlist *l, void *data) {
+  return unsafe_array_index_of(l->items, l->size, data);
+}
+
+static size_t _unsafe_arlist_count_of(arlist *l, void *data) {
+  return unsafe_array_count_of(l->items, l->size, data);
+}
+
+static size_t _unsafe_deque_index_of(deque *l, void *data) {
+  const size_t first = deque_first_segment(l);
+  size_t i = unsafe_array_index_of(l->items + l->start, first, data);
+
+  if (i == first && first < l->size) {
+    i += unsafe_array_index_of(l->items, l->size - first, data);
+  }
+
+  return i;
+}
+
+static size_t _unsafe_deque_count_of(deque *l, void *data) {
+  const size_t first = deque_first_segment(l);
+
+  return unsafe_array_count_of(l->items + l->start, first, data)
+    + unsafe_array_count_of(l->items, l->size - first, data);
+}
+
+static size_t _unsafe_sllist_index_of(sllist *l, void *data) {
+  sllistnode *current = l->head->next;
+  size_t i = 0;
+
+  for (; current != l->head && current->data != data; i++) {
+    current = current->next;
+  }
+
+  return i;
+}
+
+static size_t _unsafe_sllist_count_of(sllist *l, void *data) {
+  sllistnode *current = l->head;
+  size_t count = 0;
+
+  while ((current = current->next) != l->head) {
+    count += current->data == data;
+  }
+
+  return count;
+}
+
+FLYAPI size_t list_index_of(list *l, void *data) {
+  size_t i;
+
+  FLY_BAIL_IF_NULL(l, SIZE_MAX);
+
+  if ((i = l->kind->index_of(l, data)) >= l->size) {
+    fly_status = FLY_NOT_FOUND;
+    return SIZE_MAX;
+  }
+
+  fly_status = FLY_OK;
+
+  return i;
+}
+
+FLYAPI bool list_contains(list *l, void *data) {
+  FLY_BAIL_IF_NULL(l, false);
+
+  fly_status = FLY_OK;
+
+  return l->kind->index_of(l, data) < l->size;
+}
+
+FLYAPI size_t list_count_of(list *l, void *data) {
+  FLY_BAIL_IF_NULL(l, 0);
+
+  fly_status = FLY_OK;
+
+  return l->kind->count_of(l, data);
+}
+
+static void *_unsafe_arlist_discard(arlist *l, int (*matcher)(void *)) {
+  size_t i = 0;
+
+  while (i < l->size) {
+    if (matcher(l->items[i++])) {
+      void *ret = l->items[i - 1];
+
+      memmove(
+          l->items + i - 1, l->items + i,
+          (l->size - i) * sizeof (void *));
+
+      l->size--;
+
+      fly_status = FLY_OK;
+      return ret;
+    }
+  }
+
+  fly_status = FLY_NOT_FOUND;
+  return NULL;
+}
+
+static inline size_t _deque_inc_start(deque *l) {
+  if (l->start == l->capacity - 1) {
+    const size_t old_start = l->start;
+    l->start = 0;
+    return old_start;
+  } else {
+    return l->start++;
+  }
+}
+
+static inline size_t _deque_dec_end(deque *l) {
+  if (l->end) {
+    return l->end--;
+  } else {
+    l->end = l->capacity - 1;
+    return 0;
+  }
+}
+
+static inline void *_deque_nudge_left(void **item, void **start) {
+  void *found = *item;
+  memmove(start + 1, start, (item - start) * sizeof (void *));
+  return found;
+}
+
+static inline void *_deque_nudge_right(void **item, void **end) {
+  void *found = *item;
+  memmove(item, item + 1, (end - item) * sizeof (void *));
+  return found;
+}
+
+static void *_unsafe_deque_discard(deque *l, int (*matcher)(void *)) {
+  void ** const boundary = l->items + l->capacity;
+  void ** const segment = l->end <= l->start ? boundary : l->items + l->end;
+
+  void **item = l->items + l->start;
+
+  if (matcher(*item)) {
+    fly_status = FLY_OK;
+
+    l->size--;
+    _deque_inc_start(l);
+    return *item;
+  }
+
+  while (++item < segment) {
+    if (matcher(*item)) {
+      fly_status = FLY_OK;
+
+      l->size--;
+
+      if ((segment == boundary && l->end)
+          || item - (l->items + l->start) < segment - item) {
+        return _deque_nudge_left(item, l->items + _deque_inc_start(l));
+      } else {
+        const size_t prev_end = _deque_dec_end(l);
+
+        if (item == segment - 1 && (segment != boundary || prev_end == 0)) {
+          return *item;
+        }
+        return _deque_nudge_right(item, segment - 1);
+      }
+    }
+  }
+
+  if (item == boundary) {
+    void ** const end = (item = l->items) + l->end;
+
+    for (; item < end; item++) {
+      if (matcher(*item)) {
+        l->size--;
+        l->end--;
+        fly_status = FLY_OK;
+        return _deque_nudge_right(item, end);
+      }
+    }
+  }
+
+  fly_status = FLY_NOT_FOUND;
+  return NULL;
+}
+
+static inline void dllist_stitch(dllistnode *current) {
+  current->prev->next = current->next;
+  current->next->prev = current->prev;
+}
+
+static inline void sllist_stitch(
+    sllistnode *current, sllistnode *prev, sllist * restrict l) {
+  if (current == l->last) {
+    l->last = prev;
+  }
+
+  prev->next = current->next;
+}
+
+static void *_unsafe_dllist_discard(dllist *l, int (*matcher)(void *)) {
+  dllistnode *head = l->head,
              *current = head->next;
 
   while (current != head) {
@@ -699,6 +1312,40 @@ FLYAPI void list_foreach(list *l, int (*fn)(void *, size_t)) {
   l->kind->foreach(l, fn);
 }
 
+static void _unsafe_arlist_iter(arlist *l, list_iter *it) {
+  list_iter_init_runs(it, l->items, l->size, NULL, 0);
+}
+
+static void _unsafe_deque_iter(deque *l, list_iter *it) {
+  const size_t first = deque_first_segment(l);
+
+  if (!l->size) {
+    list_iter_init_runs(it, NULL, 0, NULL, 0);
+    return;
+  }
+
+  list_iter_init_runs(
+      it, l->items + l->start, first, l->items, l->size - first);
+}
+
+static void _unsafe_sllist_iter(sllist *l, list_iter *it) {
+  list_iter_init_runs(it, NULL, 0, NULL, 0);
+  it->node = l->head->next;
+  it->head = l->head;
+}
+
+FLYAPI list_iter list_iter_of(list *l) {
+  list_iter it;
+
+  list_iter_init_runs(&it, NULL, 0, NULL, 0);
+  FLY_BAIL_IF_NULL(l, it);
+
+  fly_status = FLY_OK;
+  l->kind->iter(l, &it);
+
+  return it;
+}
+
 static size_t _unsafe_arlist_discard_all(
     arlist *l, int (*matcher)(void *), int (*fn)(void *, size_t)) {
   size_t total_removed = 0, i = 0;
@@ -997,6 +1644,50 @@ FLYAPI void list_sort(list *l, int (*comp)(const void *, const void *)) {
   }
 }
 
+FLYAPI void list_sort_stable(
+    list *l, int (*comp)(const void *, const void *)) {
+  FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
+
+  if (l->size > 1) {
+    l->kind->sort_stable(l, comp ? comp : &comp_uintptr);
+  }
+}
+
+FLYAPI void *list_select_nth(
+    list *l, size_t n, int (*comp)(const void *, const void *)) {
+  FLY_BAIL_IF_NULL(l, NULL);
+
+  if (n >= l->size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return NULL;
+  }
+
+  fly_status = FLY_OK;
+
+  return l->kind->select_nth(l, n, comp ? comp : &comp_uintptr);
+}
+
+FLYAPI void list_partial_sort(
+    list *l, size_t k, int (*comp)(const void *, const void *)) {
+  FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
+
+  if (l->size < 2 || !k) {
+    return;
+  }
+
+  comp = comp ? comp : &comp_uintptr;
+
+  if (k < l->size) {
+    l->kind->partial_sort(l, k, comp);
+  } else {
+    l->kind->sort(l, comp);
+  }
+}
+
 #define ARLIST_DEFAULT_CAPACITY 8
 
 static inline void arlist_init(arlist *l) {
@@ -1046,24 +1737,28 @@ FLYAPI size_t arlist_grow(arlist *l, size_t new_elements) {
   return l->capacity = delta;
 }
 
+// The deque needn't have been full before growing, so the new space starts
+// at the old capacity rather than at the size.
 FLYAPI void deque_reorient(deque *l, size_t grew_by) {
+  const size_t old_capacity = l->capacity - grew_by;
+
   if (l->start < l->end || !l->size) {
     return;
   }
 
   if (!l->end) {
-    l->end = l->size;
+    l->end = old_capacity;
     return;
   }
 
   if (grew_by >= l->end) {
-    memcpy(l->items + l->size, l->items, l->end * sizeof (void *));
-    l->end = (l->end + l->size) % l->capacity;
+    memcpy(l->items + old_capacity, l->items, l->end * sizeof (void *));
+    l->end = (l->end + old_capacity) % l->capacity;
   } else {
     memcpy(
-        l->items + l->size, l->items,
+        l->items + old_capacity, l->items,
         grew_by * sizeof (void *));
-    memcpy(
+    memmove(
         l->items, l->items + grew_by,
         (l->end - grew_by) * sizeof (void *));
     l->end -= grew_by;
@@ -1134,38 +1829,176 @@ static void _unsafe_deque_append_array(deque *l, size_t n, void **suffix) {
   l->size += n;
 }
 
-static inline void unsafe_array_shuffle(
-    void ** const restrict items, size_t i, rng64 * const restrict rng) {
-  void *temp;
-  size_t j;
+static void _unsafe_arlist_pop_many(arlist *l, size_t n, void **out) {
+  memcpy(out, l->items + (l->size -= n), n * sizeof (void *));
+}
 
-  ASSUME(i > 1);
+static void _unsafe_arlist_shift_many(arlist *l, size_t n, void **out) {
+  memcpy(out, l->items, n * sizeof (void *));
+  memmove(l->items, l->items + n, (l->size -= n) * sizeof (void *));
+}
 
-  while (i > 1) {
-    j = rng64_next_in(rng, i--);
+static void _unsafe_arlist_unshift_array(
+    arlist *l, size_t n, void **prefix) {
+  ARLIST_HAS_CAPACITY_OR_DIE(l, n)
 
-    temp     = items[i];
-    items[i] = items[j];
-    items[j] = temp;
+  memmove(l->items + n, l->items, l->size * sizeof (void *));
+  memcpy(l->items, prefix, n * sizeof (void *));
+  l->size += n;
+}
+
+// Copies n items starting at slot i of the buffer, wrapping past the end.
+static inline void deque_copy_out(deque *l, size_t i, size_t n, void **out) {
+  size_t right = l->capacity - i;
+
+  if (right >= n) {
+    memcpy(out, l->items + i, n * sizeof (void *));
+  } else {
+    memcpy(out, l->items + i, right * sizeof (void *));
+    memcpy(out + right, l->items, (n - right) * sizeof (void *));
   }
 }
 
-static inline void _unsafe_arlist_shuffle(arlist *l) {
-  unsafe_array_shuffle(l->items, l->size, &l->rng);
+static inline void deque_copy_in(deque *l, size_t i, size_t n, void **in) {
+  size_t right = l->capacity - i;
+
+  if (right >= n) {
+    memcpy(l->items + i, in, n * sizeof (void *));
+  } else {
+    memcpy(l->items + i, in, right * sizeof (void *));
+    memcpy(l->items, in + right, (n - right) * sizeof (void *));
+  }
 }
 
-FLYAPI void arlist_shuffle(arlist *l) {
-  FLY_BAIL_IF_NULL(l);
+static void _unsafe_deque_pop_many(deque *l, size_t n, void **out) {
+  l->size -= n;
+  l->end = (l->start + l->size) % l->capacity;
+  deque_copy_out(l, l->end, n, out);
+}
 
-  fly_status = FLY_OK;
+static void _unsafe_deque_shift_many(deque *l, size_t n, void **out) {
+  deque_copy_out(l, l->start, n, out);
+  l->start = (l->start + n) % l->capacity;
+  l->size -= n;
+}
 
-  if (l->size > 1) {
-    _unsafe_arlist_shuffle(l);
-  }
+static void _unsafe_deque_unshift_array(deque *l, size_t n, void **prefix) {
+  DEQUE_HAS_CAPACITY_OR_DIE(l, n)
+
+  l->start = (l->start + l->capacity - n) % l->capacity;
+  deque_copy_in(l, l->start, n, prefix);
+  l->size += n;
 }
 
-static inline void unsafe_deque_unwrap(deque *l) {
-  if (l->end < l->start && l->end != 0) {
+static void _unsafe_arlist_insert(arlist *l, size_t i, void *data) {
+  ARLIST_HAS_CAPACITY_OR_DIE(l, 1)
+
+  memmove(l->items + i + 1, l->items + i, (l->size - i) * sizeof (void *));
+  l->items[i] = data;
+  l->size++;
+}
+
+static void *_unsafe_arlist_remove_at(arlist *l, size_t i) {
+  void *ret = l->items[i];
+
+  memmove(l->items + i, l->items + i + 1, (--l->size - i) * sizeof (void *));
+
+  return ret;
+}
+
+static inline size_t deque_next_slot(deque *l, size_t slot) {
+  return ++slot == l->capacity ? 0 : slot;
+}
+
+static inline size_t deque_prev_slot(deque *l, size_t slot) {
+  return (slot ? slot : l->capacity) - 1;
+}
+
+// Positional edits slide whichever side of i is shorter by one slot, so the
+// cost is bounded by half the size.
+static void _unsafe_deque_insert(deque *l, size_t i, void *data) {
+  size_t dst, src, moves;
+
+  DEQUE_HAS_CAPACITY_OR_DIE(l, 1)
+
+  if (i < l->size - i) {
+    dst = l->start = deque_prev_slot(l, l->start);
+
+    for (moves = i; moves; moves--) {
+      l->items[dst] = l->items[src = deque_next_slot(l, dst)];
+      dst = src;
+    }
+  } else {
+    dst = l->end;
+    l->end = deque_next_slot(l, l->end);
+
+    for (moves = l->size - i; moves; moves--) {
+      l->items[dst] = l->items[src = deque_prev_slot(l, dst)];
+      dst = src;
+    }
+  }
+
+  l->items[dst] = data;
+  l->size++;
+}
+
+static void *_unsafe_deque_remove_at(deque *l, size_t i) {
+  size_t dst = (l->start + i) % l->capacity, src, moves;
+  void *ret = l->items[dst];
+
+  if (i < l->size - 1 - i) {
+    for (moves = i; moves; moves--) {
+      l->items[dst] = l->items[src = deque_prev_slot(l, dst)];
+      dst = src;
+    }
+
+    l->start = deque_next_slot(l, l->start);
+  } else {
+    for (moves = l->size - 1 - i; moves; moves--) {
+      l->items[dst] = l->items[src = deque_next_slot(l, dst)];
+      dst = src;
+    }
+
+    l->end = deque_prev_slot(l, l->end);
+  }
+
+  l->size--;
+
+  return ret;
+}
+
+static inline void unsafe_array_shuffle(
+    void ** const restrict items, size_t i, rng64 * const restrict rng) {
+  void *temp;
+  size_t j;
+
+  ASSUME(i > 1);
+
+  while (i > 1) {
+    j = rng64_next_in(rng, i--);
+
+    temp     = items[i];
+    items[i] = items[j];
+    items[j] = temp;
+  }
+}
+
+static inline void _unsafe_arlist_shuffle(arlist *l) {
+  unsafe_array_shuffle(l->items, l->size, &l->rng);
+}
+
+FLYAPI void arlist_shuffle(arlist *l) {
+  FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
+
+  if (l->size > 1) {
+    _unsafe_arlist_shuffle(l);
+  }
+}
+
+static inline void unsafe_deque_unwrap(deque *l) {
+  if (l->end < l->start && l->end != 0) {
     // Unwrap by cutting the deque by the smaller segment.
     // Doesn't matter that we change the order since we're shuffling anyway.
     if (l->end < l->capacity - l->start) {
@@ -1273,12 +2106,94 @@ FLYAPI void **deque_draw(deque * restrict l, void ** restrict cursor) {
   return cursor;
 }
 
+typedef int (*sort_comparator)(const void *, const void *);
+
+#define INTROSORT_NAME introsort_address
+#define INTROSORT_TYPE void *
+#define INTROSORT_LESS(a, b) ((uintptr_t) (a) < (uintptr_t) (b))
+#include "introsort.h"
+
+#define INTROSORT_NAME introsort_comp
+#define INTROSORT_TYPE void *
+#define INTROSORT_CONTEXT sort_comparator
+#define INTROSORT_LESS(a, b) (ctx(&(a), &(b)) < 0)
+#include "introsort.h"
+
+// Below this size the histogram passes cost more than introsort does.
+#define RADIX_SORT_MIN_SIZE 256
+
+// LSD radix sort on the pointer values, one byte per pass. Bytes that are the
+// same in every item, such as the high bytes of nearby heap addresses, are
+// skipped.
+static bool unsafe_radix_sort_address(void **items, size_t size) {
+  size_t counts[sizeof (uintptr_t)][256] = {{0}};
+  size_t *bucket, digit, i, offset, count;
+  void **src = items, **dst, **scratch, **swap;
+  unsigned shift;
+  uintptr_t key;
+
+  if (!(scratch = (void **) malloc(size * sizeof (void *)))) {
+    return false;
+  }
+
+  for (i = 0; i < size; i++) {
+    key = (uintptr_t) items[i];
+
+    for (digit = 0; digit < sizeof (uintptr_t); digit++) {
+      counts[digit][(key >> (digit * 8)) & 0xff]++;
+    }
+  }
+
+  for (digit = 0, dst = scratch; digit < sizeof (uintptr_t); digit++) {
+    bucket = counts[digit];
+    shift = digit * 8;
+
+    if (bucket[((uintptr_t) src[0] >> shift) & 0xff] == size) {
+      continue;
+    }
+
+    for (i = 0, offset = 0; i < 256; i++) {
+      count = bucket[i];
+      bucket[i] = offset;
+      offset += count;
+    }
+
+    for (i = 0; i < size; i++) {
+      key = (uintptr_t) src[i];
+      dst[bucket[(key >> shift) & 0xff]++] = src[i];
+    }
+
+    swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  if (src != items) {
+    memcpy(items, src, size * sizeof (void *));
+  }
+
+  free(scratch);
+  return true;
+}
+
+static void unsafe_array_sort(
+    void **items, size_t size, int (*comp)(const void *, const void *)) {
+  if (comp != &comp_uintptr) {
+    introsort_comp(items, size, comp);
+  } else if (size < RADIX_SORT_MIN_SIZE
+      || !unsafe_radix_sort_address(items, size)) {
+    introsort_address(items, size);
+  }
+}
+
+#undef RADIX_SORT_MIN_SIZE
+
 static inline void _unsafe_arlist_sort(
     arlist *l, int (*comp)(const void *, const void *)) {
   ASSUME(l != NULL && l->items != NULL && l->size > 1);
   ASSUME(comp != NULL);
 
-  qsort(l->items, l->size, sizeof (void *), comp);
+  unsafe_array_sort(l->items, l->size, comp);
 }
 
 static inline void _unsafe_deque_sort(
@@ -1287,7 +2202,7 @@ static inline void _unsafe_deque_sort(
   ASSUME(comp != NULL);
 
   unsafe_deque_unwrap(l);
-  qsort(l->items + l->start, l->size, sizeof (void *), comp);
+  unsafe_array_sort(l->items + l->start, l->size, comp);
 }
 
 FLYAPI void arlist_sort(arlist *l, int (*comp)(const void *, const void *)) {
@@ -1310,6 +2225,814 @@ FLYAPI void deque_sort(deque *l, int (*comp)(const void *, const void *)) {
   }
 }
 
+static inline void unsafe_array_select(
+    void **items, size_t size, size_t nth,
+    int (*comp)(const void *, const void *)) {
+  if (comp != &comp_uintptr) {
+    introsort_comp_select(items, size, nth, comp);
+  } else {
+    introsort_address_select(items, size, nth);
+  }
+}
+
+// Selecting the last of the k items leaves the k - 1 before it to be sorted,
+// which costs O(n + k log k) rather than O(n log n).
+static inline void unsafe_array_partial_sort(
+    void **items, size_t size, size_t k,
+    int (*comp)(const void *, const void *)) {
+  ASSUME(k > 0 && k < size);
+
+  unsafe_array_select(items, size, k - 1, comp);
+  unsafe_array_sort(items, k - 1, comp);
+}
+
+static void *_unsafe_arlist_select_nth(
+    arlist *l, size_t n, int (*comp)(const void *, const void *)) {
+  ASSUME(l != NULL && l->items != NULL && n < l->size);
+  ASSUME(comp != NULL);
+
+  unsafe_array_select(l->items, l->size, n, comp);
+
+  return l->items[n];
+}
+
+static void *_unsafe_deque_select_nth(
+    deque *l, size_t n, int (*comp)(const void *, const void *)) {
+  ASSUME(l != NULL && l->items != NULL && n < l->size);
+  ASSUME(comp != NULL);
+
+  unsafe_deque_unwrap(l);
+  unsafe_array_select(l->items + l->start, l->size, n, comp);
+
+  return l->items[l->start + n];
+}
+
+static void _unsafe_arlist_partial_sort(
+    arlist *l, size_t k, int (*comp)(const void *, const void *)) {
+  unsafe_array_partial_sort(l->items, l->size, k, comp);
+}
+
+static void _unsafe_deque_partial_sort(
+    deque *l, size_t k, int (*comp)(const void *, const void *)) {
+  unsafe_deque_unwrap(l);
+  unsafe_array_partial_sort(l->items + l->start, l->size, k, comp);
+}
+
+// Keeps the smallest items seen so far in a max-heap in out; once it's full,
+// a new item only gets in by replacing the root.
+FLYAPI size_t list_top_k(
+    list *l, size_t k, int (*comp)(const void *, const void *), void **out) {
+  list_iter it;
+  size_t count = 0;
+  void *data;
+
+  FLY_BAIL_IF_NULL(l && (out || !k), 0);
+
+  fly_status = FLY_OK;
+
+  if (!k || !l->size) {
+    return 0;
+  }
+
+  comp = comp ? comp : &comp_uintptr;
+  it = list_iter_of(l);
+
+  while (list_iter_has_next(&it)) {
+    data = list_iter_next(&it);
+
+    if (count < k) {
+      out[count++] = data;
+
+      if (count == k) {
+        for (size_t i = count / 2; i--;) {
+          introsort_comp_sift(out, i, count, comp);
+        }
+      }
+    } else if (comp(&data, &out[0]) < 0) {
+      out[0] = data;
+      introsort_comp_sift(out, 0, count, comp);
+    }
+  }
+
+  unsafe_array_sort(out, count, comp);
+
+  return count;
+}
+
+#define STABLE_SORT_MIN_RUN 32
+
+static inline void unsafe_array_reverse(void **items, size_t size) {
+  void *swap, **end = items + size;
+
+  while (items < --end) {
+    swap = *items;
+    *items++ = *end;
+    *end = swap;
+  }
+}
+
+// Extends the sorted prefix items[0, sorted) to all of items[0, size). Each
+// item goes after any equal items already placed, so this is stable.
+static void unsafe_array_insertion_sort(
+    void **items, size_t sorted, size_t size,
+    int (*comp)(const void *, const void *)) {
+  size_t lo, hi, mid;
+  void *data;
+
+  for (; sorted < size; sorted++) {
+    data = items[sorted];
+    lo = 0;
+    hi = sorted;
+
+    while (lo < hi) {
+      mid = lo + (hi - lo) / 2;
+
+      if (comp(&data, items + mid) < 0) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+
+    memmove(items + lo + 1, items + lo, (sorted - lo) * sizeof (void *));
+    items[lo] = data;
+  }
+}
+
+// Returns the length of the run at the start of items. Strictly descending
+// runs are reversed in place; requiring strictness keeps equal items in order.
+static size_t unsafe_array_count_run(
+    void **items, size_t size, int (*comp)(const void *, const void *)) {
+  size_t i = 2;
+
+  if (size < 2) {
+    return size;
+  }
+
+  if (comp(items + 1, items) < 0) {
+    while (i < size && comp(items + i, items + i - 1) < 0) {
+      i++;
+    }
+
+    unsafe_array_reverse(items, i);
+  } else {
+    while (i < size && comp(items + i, items + i - 1) >= 0) {
+      i++;
+    }
+  }
+
+  return i;
+}
+
+static void unsafe_array_merge(
+    void ** restrict dst, void ** restrict left, size_t left_size,
+    void ** restrict right, size_t right_size,
+    int (*comp)(const void *, const void *)) {
+  void **left_end = left + left_size, **right_end = right + right_size;
+
+  // Runs that are already in order need no merging at all.
+  if (!left_size || !right_size || comp(right, left_end - 1) >= 0) {
+    memcpy(dst, left, left_size * sizeof (void *));
+    memcpy(dst + left_size, right, right_size * sizeof (void *));
+    return;
+  }
+
+  while (left < left_end && right < right_end) {
+    if (comp(right, left) < 0) {
+      *dst++ = *right++;
+    } else {
+      *dst++ = *left++;
+    }
+  }
+
+  memcpy(dst, left, (left_end - left) * sizeof (void *));
+  dst += left_end - left;
+  memcpy(dst, right, (right_end - right) * sizeof (void *));
+}
+
+// Natural merge sort: finds the existing runs, extends short ones to
+// STABLE_SORT_MIN_RUN with insertion sort, then merges neighboring runs back
+// and forth with a scratch buffer. Returns false if that can't be allocated.
+static bool unsafe_array_sort_stable(
+    void **items, size_t size, int (*comp)(const void *, const void *)) {
+  void **src = items, **dst, **scratch;
+  size_t *runs, run_count, run, i;
+
+  if (size <= STABLE_SORT_MIN_RUN) {
+    run = unsafe_array_count_run(items, size, comp);
+    unsafe_array_insertion_sort(items, run, size, comp);
+    return true;
+  }
+
+  // Every run but the last is at least STABLE_SORT_MIN_RUN long.
+  scratch = (void **) malloc(size * sizeof (void *)
+      + (size / STABLE_SORT_MIN_RUN + 2) * sizeof (size_t));
+
+  if (!scratch) {
+    return false;
+  }
+
+  runs = (size_t *) (scratch + size);
+
+  for (i = 0, run_count = 0; i < size; i += run) {
+    runs[run_count++] = i;
+    run = unsafe_array_count_run(items + i, size - i, comp);
+
+    if (run < STABLE_SORT_MIN_RUN) {
+      const size_t extended =
+        size - i < STABLE_SORT_MIN_RUN ? size - i : STABLE_SORT_MIN_RUN;
+
+      unsafe_array_insertion_sort(items + i, run, extended, comp);
+      run = extended;
+    }
+  }
+
+  runs[run_count] = size;
+
+  for (dst = scratch; run_count > 1; run_count = (run_count + 1) / 2) {
+    for (i = 0; i < run_count; i += 2) {
+      if (i + 1 < run_count) {
+        unsafe_array_merge(dst + runs[i],
+            src + runs[i], runs[i + 1] - runs[i],
+            src + runs[i + 1], runs[i + 2] - runs[i + 1], comp);
+      } else {
+        memcpy(dst + runs[i], src + runs[i],
+            (size - runs[i]) * sizeof (void *));
+      }
+
+      runs[i / 2] = runs[i];
+    }
+
+    runs[(run_count + 1) / 2] = size;
+
+    src = dst;
+    dst = src == items ? scratch : items;
+  }
+
+  if (src != items) {
+    memcpy(items, src, size * sizeof (void *));
+  }
+
+  free(scratch);
+  return true;
+}
+
+#undef STABLE_SORT_MIN_RUN
+
+// Unlike unsafe_deque_unwrap, this keeps the items in order: the whole buffer
+// is rotated left by start using three reversals.
+static inline void unsafe_deque_unwrap_ordered(deque *l) {
+  if (l->start + l->size > l->capacity) {
+    unsafe_array_reverse(l->items, l->start);
+    unsafe_array_reverse(l->items + l->start, l->capacity - l->start);
+    unsafe_array_reverse(l->items, l->capacity);
+
+    l->start = 0;
+    l->end = l->size % l->capacity;
+  }
+}
+
+static void _unsafe_arlist_sort_stable(
+    arlist *l, int (*comp)(const void *, const void *)) {
+  ASSUME(l != NULL && l->items != NULL && l->size > 1);
+  ASSUME(comp != NULL);
+
+  if (!unsafe_array_sort_stable(l->items, l->size, comp)) {
+    fly_status = FLY_E_OUT_OF_MEMORY;
+  }
+}
+
+static void _unsafe_deque_sort_stable(
+    deque *l, int (*comp)(const void *, const void *)) {
+  ASSUME(l != NULL && l->items != NULL && l->size > 1);
+  ASSUME(comp != NULL);
+
+  unsafe_deque_unwrap_ordered(l);
+
+  if (!unsafe_array_sort_stable(l->items + l->start, l->size, comp)) {
+    fly_status = FLY_E_OUT_OF_MEMORY;
+  }
+}
+
+FLYAPI void arlist_sort_stable(
+    arlist *l, int (*comp)(const void *, const void *)) {
+  FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
+
+  if (l->size > 1) {
+    _unsafe_arlist_sort_stable(l, comp ? comp : &comp_uintptr);
+  }
+}
+
+FLYAPI void deque_sort_stable(
+    deque *l, int (*comp)(const void *, const void *)) {
+  FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
+
+  if (l->size > 1) {
+    _unsafe_deque_sort_stable(l, comp ? comp : &comp_uintptr);
+  }
+}
+
+// Probes below this many items are already in cache, or nearly.
+#define ARRAY_SEARCH_PREFETCH_MIN 1024
+
+// Defines a function that counts the sorted items for which before(item) is
+// true. The loop always runs log2(size) times and its step is a conditional
+// move, so there are no mispredicted branches. Large arrays also prefetch
+// both of the next possible probes, which hides most of the misses an
+// Eytzinger layout would otherwise save.
+#define ARRAY_SEARCH_FN(name, before)                              \
+  static size_t name(void **items, size_t size, void *key,         \
+      int (*comp)(const void *, const void *)) {                   \
+    void **base = items;                                           \
+    size_t half;                                                   \
+                                                                   \
+    (void) comp;                                                   \
+                                                                   \
+    if (!size) {                                                   \
+      return 0;                                                    \
+    }                                                              \
+                                                                   \
+    while (size > 1) {                                             \
+      half = size / 2;                                             \
+                                                                   \
+      if (size >= ARRAY_SEARCH_PREFETCH_MIN) {                     \
+        PREFETCH(base + half / 2);                                 \
+        PREFETCH(base + half + half / 2);                          \
+      }                                                            \
+                                                                   \
+      base = before(base[half]) ? base + half : base;              \
+      size -= half;                                                \
+    }                                                              \
+                                                                   \
+    return (size_t) (base - items) + before(*base);                \
+  }
+
+// The default order gets its own copies with the comparison inlined.
+#define BEFORE_ADDRESS(item) ((uintptr_t) (item) < (uintptr_t) key)
+#define NOT_AFTER_ADDRESS(item) ((uintptr_t) (item) <= (uintptr_t) key)
+#define BEFORE_COMP(item) (comp(&(item), &key) < 0)
+#define NOT_AFTER_COMP(item) (comp(&(item), &key) <= 0)
+
+ARRAY_SEARCH_FN(unsafe_array_lower_bound_address, BEFORE_ADDRESS)
+ARRAY_SEARCH_FN(unsafe_array_upper_bound_address, NOT_AFTER_ADDRESS)
+ARRAY_SEARCH_FN(unsafe_array_lower_bound_comp, BEFORE_COMP)
+ARRAY_SEARCH_FN(unsafe_array_upper_bound_comp, NOT_AFTER_COMP)
+
+#undef BEFORE_ADDRESS
+#undef NOT_AFTER_ADDRESS
+#undef BEFORE_COMP
+#undef NOT_AFTER_COMP
+#undef ARRAY_SEARCH_FN
+#undef ARRAY_SEARCH_PREFETCH_MIN
+
+static size_t unsafe_array_bound(
+    void **items, size_t size, void *key,
+    int (*comp)(const void *, const void *), bool upper) {
+  if (comp == &comp_uintptr) {
+    return (upper ? &unsafe_array_upper_bound_address
+        : &unsafe_array_lower_bound_address)(items, size, key, comp);
+  }
+
+  return (upper ? &unsafe_array_upper_bound_comp
+      : &unsafe_array_lower_bound_comp)(items, size, key, comp);
+}
+
+FLYAPI size_t arlist_lower_bound(
+    arlist *l, void *key, int (*comp)(const void *, const void *)) {
+  FLY_BAIL_IF_NULL(l, 0);
+
+  fly_status = FLY_OK;
+
+  return unsafe_array_bound(
+      l->items, l->size, key, comp ? comp : &comp_uintptr, false);
+}
+
+FLYAPI size_t arlist_upper_bound(
+    arlist *l, void *key, int (*comp)(const void *, const void *)) {
+  FLY_BAIL_IF_NULL(l, 0);
+
+  fly_status = FLY_OK;
+
+  return unsafe_array_bound(
+      l->items, l->size, key, comp ? comp : &comp_uintptr, true);
+}
+
+FLYAPI void *arlist_bsearch(
+    arlist *l, void *key, int (*comp)(const void *, const void *)) {
+  size_t i;
+
+  FLY_BAIL_IF_NULL(l, NULL);
+
+  comp = comp ? comp : &comp_uintptr;
+  i = unsafe_array_bound(l->items, l->size, key, comp, false);
+
+  if (i == l->size || comp(&l->items[i], &key)) {
+    fly_status = FLY_NOT_FOUND;
+    return NULL;
+  }
+
+  fly_status = FLY_OK;
+
+  return l->items[i];
+}
+
+FLYAPI size_t arlist_insert_sorted(
+    arlist *l, void *data, int (*comp)(const void *, const void *)) {
+  size_t i;
+
+  FLY_BAIL_IF_NULL(l, SIZE_MAX);
+
+  if (!arlist_ensure_capacity(l, 1)) {
+    return SIZE_MAX;
+  }
+
+  fly_status = FLY_OK;
+
+  i = unsafe_array_bound(
+      l->items, l->size, data, comp ? comp : &comp_uintptr, true);
+
+  memmove(l->items + i + 1, l->items + i, (l->size - i) * sizeof (void *));
+  l->items[i] = data;
+  l->size++;
+
+  return i;
+}
+
+#ifndef __STDC_NO_THREADS__
+#define LIST_SORT_PARALLEL_GRAIN 8192
+#define LIST_SORT_PARALLEL_MAX_THREADS 64
+
+struct sort_task {
+  void **src;
+  void **dst;
+  size_t left;
+  size_t right;
+  size_t from;
+  size_t to;
+  int (*comp)(const void *, const void *);
+};
+
+// Number of items taken from the left run among the first k merged outputs.
+static inline size_t merge_corank(
+    void ** const left, size_t left_size, void ** const right,
+    size_t right_size, size_t k, int (*comp)(const void *, const void *)) {
+  size_t lo = k > right_size ? k - right_size : 0;
+  size_t hi = k < left_size ? k : left_size;
+  size_t i;
+
+  while (lo < hi) {
+    i = lo + (hi - lo) / 2;
+
+    // Ties go to the left run, which keeps the merge stable.
+    if (comp(left + i, right + k - i - 1) <= 0) {
+      lo = i + 1;
+    } else {
+      hi = i;
+    }
+  }
+
+  return lo;
+}
+
+static int run_sort_task(void *arg) {
+  struct sort_task *task = (struct sort_task *) arg;
+  void **left, **right, **left_end, **right_end, **out, **out_end;
+  size_t taken;
+
+  if (!task->dst) {
+    unsafe_array_sort(task->src, task->left, task->comp);
+    return 0;
+  }
+
+  taken = merge_corank(task->src, task->left, task->src + task->left,
+      task->right, task->from, task->comp);
+
+  left = task->src + taken;
+  left_end = task->src + task->left;
+  right = left_end + task->from - taken;
+  right_end = left_end + task->right;
+  out = task->dst + task->from;
+  out_end = task->dst + task->to;
+
+  while (out < out_end) {
+    if (right == right_end
+        || (left < left_end && task->comp(left, right) <= 0)) {
+      *out++ = *left++;
+    } else {
+      *out++ = *right++;
+    }
+  }
+
+  return 0;
+}
+
+static void run_sort_tasks(struct sort_task *tasks, size_t n) {
+  thrd_t threads[LIST_SORT_PARALLEL_MAX_THREADS + 1];
+  bool spawned[LIST_SORT_PARALLEL_MAX_THREADS + 1];
+  size_t i;
+
+  for (i = 1; i < n; i++) {
+    spawned[i] = thrd_create(threads + i, &run_sort_task, tasks + i)
+      == thrd_success;
+  }
+
+  run_sort_task(tasks);
+
+  for (i = 1; i < n; i++) {
+    if (spawned[i]) {
+      thrd_join(threads[i], NULL);
+    } else {
+      run_sort_task(tasks + i);
+    }
+  }
+}
+
+// Sorts each of nthreads chunks on its own thread, then merges pairs of runs
+// back and forth between items and a scratch buffer. Every merge round is
+// split across all of the threads by output range, so no round is serial.
+static bool unsafe_array_sort_parallel(
+    void **items, size_t size,
+    int (*comp)(const void *, const void *), size_t nthreads) {
+  struct sort_task tasks[LIST_SORT_PARALLEL_MAX_THREADS + 1];
+  size_t bounds[LIST_SORT_PARALLEL_MAX_THREADS + 1];
+  size_t runs, pairs, per_pair, n, i, j;
+  void **src = items, **dst, **scratch;
+
+  if (!(scratch = (void **) malloc(size * sizeof (void *)))) {
+    return false;
+  }
+
+  for (i = 0; i <= nthreads; i++) {
+    bounds[i] = size / nthreads * i + (size % nthreads) * i / nthreads;
+  }
+
+  for (i = 0; i < nthreads; i++) {
+    tasks[i].src = items + bounds[i];
+    tasks[i].dst = NULL;
+    tasks[i].left = bounds[i + 1] - bounds[i];
+    tasks[i].comp = comp;
+  }
+
+  run_sort_tasks(tasks, nthreads);
+
+  for (runs = nthreads, dst = scratch; runs > 1; runs = pairs + (runs & 1)) {
+    pairs = runs / 2;
+    per_pair = nthreads / pairs;
+    n = 0;
+
+    for (i = 0; i < runs; i += 2) {
+      const size_t total = bounds[i + (i + 1 < runs ? 2 : 1)] - bounds[i];
+      const size_t slices = i + 1 < runs ? per_pair : 1;
+
+      for (j = 0; j < slices; j++, n++) {
+        tasks[n].src = src + bounds[i];
+        tasks[n].dst = dst + bounds[i];
+        tasks[n].left = bounds[i + 1] - bounds[i];
+        tasks[n].right = total - tasks[n].left;
+        tasks[n].from = total / slices * j + (total % slices) * j / slices;
+        tasks[n].to =
+          total / slices * (j + 1) + (total % slices) * (j + 1) / slices;
+        tasks[n].comp = comp;
+      }
+    }
+
+    run_sort_tasks(tasks, n);
+
+    for (i = 0; i < runs; i += 2) {
+      bounds[i / 2] = bounds[i];
+    }
+    bounds[(runs + 1) / 2] = size;
+
+    dst = src;
+    src = tasks[0].dst;
+  }
+
+  if (src != items) {
+    memcpy(items, src, size * sizeof (void *));
+  }
+
+  free(scratch);
+  return true;
+}
+#endif  /* __STDC_NO_THREADS__ */
+
+FLYAPI void list_sort_parallel(
+    list *l, int (*comp)(const void *, const void *), size_t nthreads) {
+  void **items;
+
+  FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
+
+  if (l->size <= 1) {
+    return;
+  }
+
+  if (!comp) {
+    comp = &comp_uintptr;
+  }
+
+#ifndef __STDC_NO_THREADS__
+  if (nthreads > LIST_SORT_PARALLEL_MAX_THREADS) {
+    nthreads = LIST_SORT_PARALLEL_MAX_THREADS;
+  }
+  if (nthreads > l->size / LIST_SORT_PARALLEL_GRAIN) {
+    nthreads = l->size / LIST_SORT_PARALLEL_GRAIN;
+  }
+
+  if (nthreads > 1 && l->size >= LIST_SORT_PARALLEL_THRESHOLD) {
+    if (l->kind == LISTKIND_ARRAY) {
+      items = ((arlist *) l)->items;
+    } else if (l->kind == LISTKIND_DEQUE) {
+      unsafe_deque_unwrap((deque *) l);
+      items = ((deque *) l)->items + ((deque *) l)->start;
+    } else {
+      items = NULL;
+    }
+
+    if (items && unsafe_array_sort_parallel(items, l->size, comp, nthreads)) {
+      return;
+    }
+  }
+#endif
+
+  l->kind->sort(l, comp);
+}
+
+#ifndef __STDC_NO_THREADS__
+#undef LIST_SORT_PARALLEL_GRAIN
+#undef LIST_SORT_PARALLEL_MAX_THREADS
+#endif
+
+static void _unsafe_arlist_reverse(arlist *l) {
+  unsafe_array_reverse(l->items, l->size);
+}
+
+static void _unsafe_deque_reverse(deque *l) {
+  size_t left = l->start, right = deque_prev_slot(l, l->end);
+  void *swap;
+
+  for (size_t n = l->size / 2; n; n--) {
+    swap = l->items[left];
+    l->items[left] = l->items[right];
+    l->items[right] = swap;
+
+    left = deque_next_slot(l, left);
+    right = deque_prev_slot(l, right);
+  }
+}
+
+static void _unsafe_arlist_rotate(arlist *l, size_t k) {
+  unsafe_array_reverse(l->items, k);
+  unsafe_array_reverse(l->items + k, l->size - k);
+  unsafe_array_reverse(l->items, l->size);
+}
+
+// Carries items around the ring from one end to the other, whichever way is
+// shorter. A full ring only has its indices moved.
+static void _unsafe_deque_rotate(deque *l, size_t k) {
+  if (l->size == l->capacity) {
+    l->start = l->end = (l->start + k) % l->capacity;
+  } else if (k <= l->size - k) {
+    while (k--) {
+      l->items[l->end] = l->items[l->start];
+      l->start = deque_next_slot(l, l->start);
+      l->end = deque_next_slot(l, l->end);
+    }
+  } else {
+    for (k = l->size - k; k; k--) {
+      l->start = deque_prev_slot(l, l->start);
+      l->end = deque_prev_slot(l, l->end);
+      l->items[l->start] = l->items[l->end];
+    }
+  }
+}
+
+// The slices append through dst's own kind, so the array code also serves
+// the kinds that borrow it through a view.
+static void _unsafe_arlist_slice(arlist *l, size_t from, size_t n, list *dst) {
+  dst->kind->append_array(dst, n, l->items + from);
+}
+
+static void _unsafe_deque_slice(deque *l, size_t from, size_t n, list *dst) {
+  size_t i = (l->start + from) % l->capacity, right = l->capacity - i;
+
+  if (right >= n) {
+    dst->kind->append_array(dst, n, l->items + i);
+  } else {
+    dst->kind->append_array(dst, right, l->items + i);
+
+    if (fly_status == FLY_OK) {
+      dst->kind->append_array(dst, n - right, l->items);
+    }
+  }
+}
+
+static void _unsafe_arlist_splice(
+    arlist *dst, size_t pos, arlist *src, size_t from, size_t n) {
+  ARLIST_HAS_CAPACITY_OR_DIE(dst, n)
+
+  memmove(
+      dst->items + pos + n, dst->items + pos,
+      (dst->size - pos) * sizeof (void *));
+  memcpy(dst->items + pos, src->items + from, n * sizeof (void *));
+  memmove(
+      src->items + from, src->items + from + n,
+      (src->size - from - n) * sizeof (void *));
+
+  dst->size += n;
+  src->size -= n;
+}
+
+static void _unsafe_deque_splice(
+    deque *dst, size_t pos, deque *src, size_t from, size_t n) {
+  void **source;
+
+  DEQUE_HAS_CAPACITY_OR_DIE(dst, n)
+
+  // Line both up as plain arrays, with dst at the front so it has room.
+  unsafe_deque_unwrap_ordered(dst);
+  unsafe_deque_unwrap_ordered(src);
+
+  if (dst->start) {
+    memmove(dst->items, dst->items + dst->start, dst->size * sizeof (void *));
+    dst->start = 0;
+  }
+
+  source = src->items + src->start;
+
+  memmove(
+      dst->items + pos + n, dst->items + pos,
+      (dst->size - pos) * sizeof (void *));
+  memcpy(dst->items + pos, source + from, n * sizeof (void *));
+  memmove(
+      source + from, source + from + n,
+      (src->size - from - n) * sizeof (void *));
+
+  dst->end = (dst->size += n) % dst->capacity;
+  src->end = (src->start + (src->size -= n)) % src->capacity;
+}
+
+FLYAPI arlist arlist_view(arlist *l, size_t from, size_t to) {
+  arlist view;
+
+  view.kind = LISTKIND_ARRAY;
+  view.size = view.capacity = 0;
+  view.items = NULL;
+
+  FLY_BAIL_IF_NULL(l, view);
+
+  if (from > to || to > l->size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return view;
+  }
+
+  fly_status = FLY_OK;
+
+  view.rng = l->rng;
+  view.size = view.capacity = to - from;
+  view.items = l->items + from;
+
+  return view;
+}
+
+FLYAPI deque deque_view(deque *l, size_t from, size_t to) {
+  deque view;
+
+  view.kind = LISTKIND_DEQUE;
+  view.size = view.capacity = view.start = view.end = 0;
+  view.items = NULL;
+
+  FLY_BAIL_IF_NULL(l, view);
+
+  if (from > to || to > l->size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return view;
+  }
+
+  fly_status = FLY_OK;
+
+  view.rng = l->rng;
+
+  if (to > from) {
+    if (l->start + from < l->capacity && l->start + to > l->capacity) {
+      unsafe_deque_unwrap_ordered(l);
+    }
+
+    view.size = to - from;
+    view.capacity = l->capacity;
+    view.items = l->items;
+    view.start = (l->start + from) % l->capacity;
+    view.end = (view.start + view.size) % l->capacity;
+  }
+
+  return view;
+}
+
 #undef ARLIST_HAS_CAPACITY_OR_DIE
 #undef DEQUE_HAS_CAPACITY_OR_DIE
 
@@ -1369,6 +3092,8 @@ static void _unsafe_dllist_push(dllist *l, void *data) {
 
 FLYAPI void dllist_push(dllist *l, void *data) {
   FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
   _unsafe_dllist_push(l, data);
 }
 
@@ -1389,6 +3114,8 @@ static void _unsafe_dllist_unshift(dllist *l, void *data) {
 
 FLYAPI void dllist_unshift(dllist *l, void *data) {
   FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
   _unsafe_dllist_unshift(l, data);
 }
 
@@ -1475,39 +3202,198 @@ FLYAPI void dllist_move(dllist * restrict dst, dllist * restrict src) {
   dst->head->prev = src->head->prev;
   src->head->next = src->head->prev = src->head;
 
-  dst->size += src->size;
-  src->size = 0;
+  dst->size += src->size;
+  src->size = 0;
+}
+
+static void _unsafe_dllist_append_array(dllist *l, size_t n, void **items) {
+  const size_t n_save = n;
+  dllistnode *current;
+  dllistnode *last = l->head->prev;
+
+  do {
+    if ((current = (dllistnode *) malloc(sizeof (dllistnode)))) {
+      (last->next = current)->prev = last;
+      (last = current)->data = *items++;
+    } else {
+      goto out_of_memory_unwind;
+    }
+  } while (--n);
+
+  (last->next = l->head)->prev = last;
+  l->size += n_save;
+  return;
+
+out_of_memory_unwind:
+  while (last != l->head->prev) {
+    current = last->prev;
+    free(last);
+    last = current;
+  }
+
+  last->next = l->head;
+  fly_status = FLY_E_OUT_OF_MEMORY;
+}
+
+static void _unsafe_dllist_pop_many(dllist *l, size_t n, void **out) {
+  dllistnode *node = l->head, *next;
+
+  for (size_t i = n; i; i--) {
+    node = node->prev;
+  }
+
+  l->head->prev = node->prev;
+  node->prev->next = l->head;
+  l->size -= n;
+
+  while (n--) {
+    *out++ = node->data;
+    next = node->next;
+    free(node);
+    node = next;
+  }
+}
+
+static void _unsafe_dllist_shift_many(dllist *l, size_t n, void **out) {
+  dllistnode *node = l->head->next, *next;
+
+  l->size -= n;
+
+  while (n--) {
+    *out++ = node->data;
+    next = node->next;
+    free(node);
+    node = next;
+  }
+
+  (l->head->next = node)->prev = l->head;
 }
 
-static void _unsafe_dllist_append_array(dllist *l, size_t n, void **items) {
+static void _unsafe_dllist_unshift_array(
+    dllist *l, size_t n, void **items) {
+  dllistnode head, *last = &head, *current;
   const size_t n_save = n;
-  dllistnode *current;
-  dllistnode *last = l->head->prev;
 
+  // Build the chain off to the side so running out of memory changes nothing.
   do {
-    if ((current = (dllistnode *) malloc(sizeof (dllistnode)))) {
-      (last->next = current)->prev = last;
-      (last = current)->data = *items++;
-    } else {
+    if (!(current = (dllistnode *) malloc(sizeof (dllistnode)))) {
       goto out_of_memory_unwind;
     }
+
+    (last->next = current)->prev = last;
+    (last = current)->data = *items++;
   } while (--n);
 
-  (last->next = l->head)->prev = last;
+  (last->next = l->head->next)->prev = last;
+  (l->head->next = head.next)->prev = l->head;
   l->size += n_save;
   return;
 
 out_of_memory_unwind:
-  while (last != l->head->prev) {
+  while (last != &head) {
     current = last->prev;
     free(last);
     last = current;
   }
 
-  last->next = l->head;
   fly_status = FLY_E_OUT_OF_MEMORY;
 }
 
+// The node currently at index i, or the head when i is the size.
+static inline dllistnode *dllist_node_at(dllist *l, size_t i) {
+  if (i == l->size) {
+    return l->head;
+  }
+
+  if (i > l->size / 2) {
+    return _unsafe_dllist_get_node_reverse(l, l->size - i);
+  }
+
+  return (dllistnode *) _unsafe_sllist_get_node((sllist *) l, i);
+}
+
+static void _unsafe_dllist_insert(dllist *l, size_t i, void *data) {
+  dllistnode *node, *next = dllist_node_at(l, i);
+
+  if (!(node = listnode_alloc(sizeof (dllistnode)))) {
+    return;
+  }
+
+  node->data = data;
+  node->next = next;
+  node->prev = next->prev;
+  next->prev->next = node;
+  next->prev = node;
+  l->size++;
+}
+
+static void *_unsafe_dllist_remove_at(dllist *l, size_t i) {
+  dllistnode *node = dllist_node_at(l, i);
+  void *ret = node->data;
+
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  l->size--;
+  free(node);
+
+  return ret;
+}
+
+// Every node trades its links, the head included.
+static void _unsafe_dllist_reverse(dllist *l) {
+  dllistnode *node = l->head, *swap;
+
+  do {
+    swap = node->next;
+    node->next = node->prev;
+    node = node->prev = swap;
+  } while (node != l->head);
+}
+
+// The list is a ring through its head, so rotating just moves the head to
+// sit in front of the item at k.
+static void _unsafe_dllist_rotate(dllist *l, size_t k) {
+  dllistnode *head = l->head, *first = dllist_node_at(l, k);
+
+  head->prev->next = head->next;
+  head->next->prev = head->prev;
+
+  head->prev = first->prev;
+  head->next = first;
+  first->prev->next = head;
+  first->prev = head;
+}
+
+static void _unsafe_dllist_slice(dllist *l, size_t from, size_t n, list *dst) {
+  for (dllistnode *node = dllist_node_at(l, from); n; n--) {
+    dst->kind->push(dst, node->data);
+
+    if (fly_status != FLY_OK) {
+      return;
+    }
+
+    node = node->next;
+  }
+}
+
+static void _unsafe_dllist_splice(
+    dllist *dst, size_t pos, dllist *src, size_t from, size_t n) {
+  dllistnode *first = dllist_node_at(src, from);
+  dllistnode *last = dllist_node_at(src, from + n - 1);
+  dllistnode *next = dllist_node_at(dst, pos);
+
+  first->prev->next = last->next;
+  last->next->prev = first->prev;
+
+  first->prev = next->prev;
+  last->next = next;
+  next->prev->next = first;
+  next->prev = last;
+
+  dst->size += n;
+  src->size -= n;
+}
+
 static void sllist_init(sllist *l) {
   l->size = 0;
 
@@ -1543,6 +3429,8 @@ static void _unsafe_sllist_push(sllist *l, void *data) {
 
 FLYAPI void sllist_push(sllist *l, void *data) {
   FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
   _unsafe_sllist_push(l, data);
 }
 
@@ -1566,6 +3454,8 @@ static void _unsafe_sllist_unshift(sllist *l, void *data) {
 
 FLYAPI void sllist_unshift(sllist *l, void *data) {
   FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
   _unsafe_sllist_unshift(l, data);
 }
 
@@ -1693,6 +3583,177 @@ out_of_memory_unwind:
   fly_status = FLY_E_OUT_OF_MEMORY;
 }
 
+static void _unsafe_sllist_pop_many(sllist *l, size_t n, void **out) {
+  sllistnode *last = l->head, *node, *next;
+
+  for (size_t i = l->size - n; i; i--) {
+    last = last->next;
+  }
+
+  node = last->next;
+  (l->last = last)->next = l->head;
+  l->size -= n;
+
+  while (n--) {
+    *out++ = node->data;
+    next = node->next;
+    free(node);
+    node = next;
+  }
+}
+
+static void _unsafe_sllist_shift_many(sllist *l, size_t n, void **out) {
+  sllistnode *node = l->head->next, *next;
+
+  if (!(l->size -= n)) {
+    l->last = l->head;
+  }
+
+  while (n--) {
+    *out++ = node->data;
+    next = node->next;
+    free(node);
+    node = next;
+  }
+
+  l->head->next = node;
+}
+
+static void _unsafe_sllist_unshift_array(
+    sllist *l, size_t n, void **items) {
+  sllistnode head, *last = &head, *current;
+  const size_t n_save = n;
+
+  do {
+    if (!(last->next = (sllistnode *) malloc(sizeof (sllistnode)))) {
+      goto out_of_memory_unwind;
+    }
+
+    (last = last->next)->data = *items++;
+  } while (--n);
+
+  if (!l->size) {
+    l->last = last;
+  }
+
+  last->next = l->head->next;
+  l->head->next = head.next;
+  l->size += n_save;
+  return;
+
+out_of_memory_unwind:
+  for (current = head.next; current; current = head.next) {
+    head.next = current->next;
+    free(current);
+  }
+
+  fly_status = FLY_E_OUT_OF_MEMORY;
+}
+
+static void _unsafe_sllist_insert(sllist *l, size_t i, void *data) {
+  sllistnode *node, *prev;
+
+  if (!(node = listnode_alloc(sizeof (sllistnode)))) {
+    return;
+  }
+
+  if (i == l->size) {
+    prev = l->last;
+    l->last = node;
+  } else {
+    prev = i ? _unsafe_sllist_get_node(l, i - 1) : l->head;
+  }
+
+  node->data = data;
+  node->next = prev->next;
+  prev->next = node;
+  l->size++;
+}
+
+static void *_unsafe_sllist_remove_at(sllist *l, size_t i) {
+  sllistnode *prev = i ? _unsafe_sllist_get_node(l, i - 1) : l->head;
+  sllistnode *node = prev->next;
+  void *ret = node->data;
+
+  if ((prev->next = node->next) == l->head) {
+    l->last = prev;
+  }
+
+  l->size--;
+  free(node);
+
+  return ret;
+}
+
+static void _unsafe_sllist_reverse(sllist *l) {
+  sllistnode *prev = l->head, *node = l->head->next, *next;
+
+  l->last = node;
+
+  while (node != l->head) {
+    next = node->next;
+    node->next = prev;
+    prev = node;
+    node = next;
+  }
+
+  l->head->next = prev;
+}
+
+static void _unsafe_sllist_rotate(sllist *l, size_t k) {
+  sllistnode *tail = _unsafe_sllist_get_node(l, k - 1);
+
+  l->last->next = l->head->next;
+  l->head->next = tail->next;
+  (l->last = tail)->next = l->head;
+}
+
+static void _unsafe_sllist_slice(sllist *l, size_t from, size_t n, list *dst) {
+  for (sllistnode *node = _unsafe_sllist_get_node(l, from); n; n--) {
+    dst->kind->push(dst, node->data);
+
+    if (fly_status != FLY_OK) {
+      return;
+    }
+
+    node = node->next;
+  }
+}
+
+static void _unsafe_sllist_splice(
+    sllist *dst, size_t pos, sllist *src, size_t from, size_t n) {
+  sllistnode *before, *first, *last, *after;
+
+  before = from ? _unsafe_sllist_get_node(src, from - 1) : src->head;
+  first = before->next;
+
+  if (from + n == src->size) {
+    last = src->last;
+    src->last = before;
+  } else {
+    last = before;
+
+    for (size_t i = n; i; i--) {
+      last = last->next;
+    }
+  }
+
+  before->next = last->next;
+
+  if (pos == dst->size) {
+    after = dst->last;
+    dst->last = last;
+  } else {
+    after = pos ? _unsafe_sllist_get_node(dst, pos - 1) : dst->head;
+  }
+
+  last->next = after->next;
+  after->next = first;
+
+  dst->size += n;
+  src->size -= n;
+}
+
 static void _unsafe_sllist_shuffle(sllist *l) {
   const size_t size = l->size;
 
@@ -1765,103 +3826,224 @@ FLYAPI void dllist_shuffle(dllist *l) {
   }
 }
 
+struct sllistrun {
+  sllistnode *head;
+  sllistnode *last;
+};
+
+// Merges right into left. Ties go to left, which must hold the earlier items.
+static inline void sllist_merge(
+    struct sllistrun *left, struct sllistrun *right,
+    int (*comp)(const void *, const void *)) {
+  sllistnode *l = left->head, *r = right->head, head, *current = &head;
+
+  while (l && r) {
+    if (comp(&r->data, &l->data) < 0) {
+      current = current->next = r;
+      r = r->next;
+    } else {
+      current = current->next = l;
+      l = l->next;
+    }
+  }
+
+  if (l) {
+    current->next = l;
+  } else {
+    current->next = r;
+    left->last = right->last;
+  }
+
+  left->head = head.next;
+}
+
+// Splits the longest sorted run off the front of the chain at node. Strictly
+// descending runs are reversed as they're taken; strictness keeps it stable.
+static inline sllistnode *sllist_take_run(
+    sllistnode *node, struct sllistrun *run,
+    int (*comp)(const void *, const void *)) {
+  sllistnode *next = node->next;
+
+  run->head = run->last = node;
+
+  if (next && comp(&next->data, &node->data) < 0) {
+    do {
+      node = next;
+      next = node->next;
+      node->next = run->head;
+      run->head = node;
+    } while (next && comp(&next->data, &node->data) < 0);
+  } else {
+    while (next && comp(&next->data, &node->data) >= 0) {
+      node = next;
+      next = node->next;
+    }
+
+    run->last = node;
+  }
+
+  run->last->next = NULL;
+  return next;
+}
+
+// Bottom-up natural merge sort over a NULL-terminated chain. Each run already
+// in the input is carried up through the bins like a binary counter, where
+// bins[i] holds the merge of 2^i runs. Sorted input takes a single pass.
 static sllistnode *sllist_mergesort(
-    sllistnode *node, size_t size, sllistnode **last,
+    sllistnode *node, sllistnode **last,
     int (*comp)(const void *, const void *)) {
-  size_t i, next_size;
-  sllistnode *left, *right, *current;
+  struct sllistrun bins[sizeof (size_t) * 8], carry;
+  size_t bin_count = 0, i;
 
-  ASSUME(size > 0);
   ASSUME(node != NULL);
 
-  if (size <= 2) {
-    if (size <= 1) {
-      node->next = NULL;
-      return node;
-    }
+  while (node) {
+    node = sllist_take_run(node, &carry, comp);
 
-    if (comp(&node->data, &node->next->data) > 0) {
-      current = node->next;
-      current->next = node;
-      node->next = NULL;
+    for (i = 0; i < bin_count && bins[i].head; i++) {
+      sllist_merge(&bins[i], &carry, comp);
+      carry = bins[i];
+      bins[i].head = NULL;
+    }
 
-      if (last) {
-        *last = node;
-      }
+    bins[i] = carry;
 
-      return current;
-    } else {
-      return node;
+    if (i == bin_count) {
+      bin_count++;
     }
   }
 
+  // Higher bins hold earlier items, so each goes on the left.
+  for (carry.head = NULL, i = 0; i < bin_count; i++) {
+    if (!bins[i].head) {
+      continue;
+    }
 
-  i = (next_size = size >> 1) - 1;
-  current = node;
+    if (carry.head) {
+      sllist_merge(&bins[i], &carry, comp);
+    }
 
-  while (i) {
-    current = current->next;
-    --i;
+    carry = bins[i];
+  }
+
+  if (last) {
+    *last = carry.last;
   }
 
-  right = current->next;
-  current->next = NULL;
+  return carry.head;
+}
 
-  left = sllist_mergesort(node, next_size, last, comp);
-  right = sllist_mergesort(right, size - next_size, last, comp);
+// Appends run to chain. Either may be empty.
+static inline void sllist_append_run(
+    struct sllistrun *chain, struct sllistrun *run) {
+  if (!run->head) {
+    return;
+  }
 
-  if (comp(&left->data, &right->data) > 0) {
-    node = current = right;
-    right = right->next;
+  if (chain->head) {
+    chain->last->next = run->head;
   } else {
-    node = current = left;
-    left = left->next;
+    chain->head = run->head;
   }
 
-  while (left && right) {
-    if (comp(&left->data, &right->data) > 0) {
-      current->next = right;
-      current = right;
-      right = right->next;
-    } else {
-      current->next = left;
-      current = left;
-      left = left->next;
+  chain->last = run->last;
+}
+
+// Quickselect over a NULL-terminated chain of size nodes. Each pass splits
+// the nodes around a random pivot into less, equal and greater runs, then
+// keeps partitioning only the run that holds nth. The chain is rearranged in
+// place and the node that ends up at nth is returned.
+static sllistnode *sllist_select(
+    struct sllistrun *chain, size_t size, size_t nth, rng64 *rng,
+    int (*comp)(const void *, const void *)) {
+  struct sllistrun before = { NULL, NULL }, after = { NULL, NULL }, runs[3];
+  sllistnode *node = chain->head, *next;
+  size_t counts[3], i;
+  void *pivot;
+  int side;
+
+  ASSUME(node != NULL && nth < size);
+
+  for (;;) {
+    for (next = node, i = rng64_next_in(rng, size); i; i--) {
+      next = next->next;
     }
-  }
 
-  if (left) {
-    current->next = left;
-  } else {
-    current->next = right;
-  }
+    pivot = next->data;
 
-  while (current->next) {
-    current = current->next;
+    for (i = 0; i < 3; i++) {
+      runs[i].head = NULL;
+      counts[i] = 0;
+    }
+
+    for (; node; node = next) {
+      next = node->next;
+      node->next = NULL;
+
+      side = comp(&node->data, &pivot);
+      side = side < 0 ? 0 : side > 0 ? 2 : 1;
+
+      sllist_append_run(&runs[side], &(struct sllistrun) { node, node });
+      counts[side]++;
+    }
+
+    if (nth < counts[0]) {
+      sllist_append_run(&runs[1], &runs[2]);
+      sllist_append_run(&runs[1], &after);
+      after = runs[1];
+      node = runs[0].head;
+      size = counts[0];
+    } else if ((nth -= counts[0]) < counts[1]) {
+      break;
+    } else {
+      sllist_append_run(&before, &runs[0]);
+      sllist_append_run(&before, &runs[1]);
+      node = runs[2].head;
+      size = counts[2];
+      nth -= counts[1];
+    }
   }
 
-  if (last) {
-    *last = current;
+  for (node = runs[1].head; nth; nth--) {
+    node = node->next;
   }
 
+  sllist_append_run(&before, &runs[0]);
+  sllist_append_run(&before, &runs[1]);
+  sllist_append_run(&before, &runs[2]);
+  sllist_append_run(&before, &after);
+  *chain = before;
+
   return node;
 }
 
+// Selects the kth node, then merge sorts just the chain up to it.
+static void sllist_partial_sort(
+    struct sllistrun *chain, size_t size, size_t k, rng64 *rng,
+    int (*comp)(const void *, const void *)) {
+  sllistnode *kth = sllist_select(chain, size, k - 1, rng, comp), *rest;
+
+  rest = kth->next;
+  kth->next = NULL;
+  chain->head = sllist_mergesort(chain->head, &kth, comp);
+
+  if (!(kth->next = rest)) {
+    chain->last = kth;
+  }
+}
+
 static void _unsafe_sllist_sort(
     sllist *l, int (*comp)(const void *, const void *)) {
   l->last->next = NULL;
-  l->head->next = sllist_mergesort(l->head->next, l->size, &l->last, comp);
+  l->head->next = sllist_mergesort(l->head->next, &l->last, comp);
   l->last->next = l->head;
 }
 
-static void _unsafe_dllist_sort(
-    dllist *l, int (*comp)(const void *, const void *)) {
+// Restores the prev pointers and the circular link after the nodes have been
+// rearranged as a NULL-terminated singly linked chain.
+static inline void dllist_relink(dllist *l) {
   dllistnode *current = l->head;
 
-  l->head->prev->next = NULL;
-  l->head->next = (dllistnode *)
-    sllist_mergesort((sllistnode *) l->head->next, l->size, NULL, comp);
-
   do {
     current->next->prev = current;
   } while ((current = current->next)->next);
@@ -1870,6 +4052,14 @@ static void _unsafe_dllist_sort(
   l->head->prev = current;
 }
 
+static void _unsafe_dllist_sort(
+    dllist *l, int (*comp)(const void *, const void *)) {
+  l->head->prev->next = NULL;
+  l->head->next = (dllistnode *)
+    sllist_mergesort((sllistnode *) l->head->next, NULL, comp);
+  dllist_relink(l);
+}
+
 FLYAPI void sllist_sort(sllist *l, int (*comp)(const void *, const void *)) {
   FLY_BAIL_IF_NULL(l);
 
@@ -1890,3 +4080,53 @@ FLYAPI void dllist_sort(dllist *l, int (*comp)(const void *, const void *)) {
   }
 }
 
+
+static void *_unsafe_sllist_select_nth(
+    sllist *l, size_t n, int (*comp)(const void *, const void *)) {
+  struct sllistrun chain = { l->head->next, l->last };
+  sllistnode *node;
+
+  l->last->next = NULL;
+  node = sllist_select(&chain, l->size, n, &l->rng, comp);
+  l->head->next = chain.head;
+  (l->last = chain.last)->next = l->head;
+
+  return node->data;
+}
+
+static void _unsafe_sllist_partial_sort(
+    sllist *l, size_t k, int (*comp)(const void *, const void *)) {
+  struct sllistrun chain = { l->head->next, l->last };
+
+  l->last->next = NULL;
+  sllist_partial_sort(&chain, l->size, k, &l->rng, comp);
+  l->head->next = chain.head;
+  (l->last = chain.last)->next = l->head;
+}
+
+static void *_unsafe_dllist_select_nth(
+    dllist *l, size_t n, int (*comp)(const void *, const void *)) {
+  struct sllistrun chain = {
+    (sllistnode *) l->head->next, (sllistnode *) l->head->prev
+  };
+  sllistnode *node;
+
+  l->head->prev->next = NULL;
+  node = sllist_select(&chain, l->size, n, &l->rng, comp);
+  l->head->next = (dllistnode *) chain.head;
+  dllist_relink(l);
+
+  return node->data;
+}
+
+static void _unsafe_dllist_partial_sort(
+    dllist *l, size_t k, int (*comp)(const void *, const void *)) {
+  struct sllistrun chain = {
+    (sllistnode *) l->head->next, (sllistnode *) l->head->prev
+  };
+
+  l->head->prev->next = NULL;
+  sllist_partial_sort(&chain, l->size, k, &l->rng, comp);
+  l->head->next = (dllistnode *) chain.head;
+  dllist_relink(l);
+}
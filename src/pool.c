@@ -0,0 +1,198 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+
+#include "jargon.h"
+
+extern inline pool *pool_new(size_t size, size_t align);
+
+FLYAPI pool *pool_new_with_callbacks(
+    size_t size, size_t align, void (*init)(void *), void (*fini)(void *)) {
+  pool *ret;
+
+  if (!align || align & (align - 1)) {
+    fly_status = FLY_E_INVALID_ARG;
+    return NULL;
+  }
+
+  if (align < alignof (void *)) {
+    align = alignof (void *);
+  }
+
+  if (size < sizeof (void *)) {
+    size = sizeof (void *);
+  }
+
+  if (size > SIZE_MAX - align) {
+    fly_status = FLY_E_TOO_BIG;
+    return NULL;
+  }
+
+  if (!(ret = (pool *) malloc(sizeof (pool)))) {
+    fly_status = FLY_E_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  if (!(ret->arena = arena_new(0))) {
+    free(ret);
+    return NULL;
+  }
+
+  ret->size = (size + align - 1) & ~(align - 1);
+  ret->align = align;
+  ret->free = NULL;
+  ret->next = ret->end = NULL;
+  ret->slabs = NULL;
+  ret->live = 0;
+  ret->init = init;
+  ret->fini = fini;
+
+  fly_status = FLY_OK;
+
+  return ret;
+}
+
+// The bitmap of live slots is only there for pools with a fini.
+static bool pool_add_slab(pool *p) {
+  const size_t count = p->slabs ? 2 * p->slabs->count : POOL_FIRST_SLAB;
+  const size_t words = p->fini ? (count + 63) / 64 : 0;
+  size_t header = sizeof (struct pool_slab) + words * sizeof (uint64_t);
+  struct pool_slab *slab;
+
+  header = (header + p->align - 1) & ~(p->align - 1);
+
+  if (count > (SIZE_MAX - header) / p->size) {
+    fly_status = FLY_E_TOO_BIG;
+    return false;
+  }
+
+  slab = (struct pool_slab *) arena_alloc_aligned(
+      p->arena, header + count * p->size,
+      p->align > alignof (struct pool_slab)
+        ? p->align : alignof (struct pool_slab));
+
+  if (!slab) {
+    return false;
+  }
+
+  memset(slab->live, 0, words * sizeof (uint64_t));
+  slab->prev = p->slabs;
+  slab->slots = (uint8_t *) slab + header;
+  slab->count = count;
+
+  p->slabs = slab;
+  p->next = slab->slots;
+  p->end = slab->slots + count * p->size;
+
+  return true;
+}
+
+// Newest first, since the newest slab is the biggest.
+static void pool_mark(pool *p, uint8_t *obj, bool live) {
+  struct pool_slab *slab = p->slabs;
+
+  while (obj < slab->slots || obj >= slab->slots + slab->count * p->size) {
+    slab = slab->prev;
+  }
+
+  size_t i = (obj - slab->slots) / p->size;
+  uint64_t bit = (uint64_t) 1 << (i % 64);
+
+  if (live) {
+    slab->live[i / 64] |= bit;
+  } else {
+    slab->live[i / 64] &= ~bit;
+  }
+}
+
+static void pool_fini_live(pool *p) {
+  if (!p->fini || !p->live) {
+    return;
+  }
+
+  for (struct pool_slab *slab = p->slabs; slab; slab = slab->prev) {
+    for (size_t w = 0; w < (slab->count + 63) / 64; w++) {
+      uint8_t *obj = slab->slots + w * 64 * p->size;
+
+      for (uint64_t bits = slab->live[w]; bits; bits >>= 1, obj += p->size) {
+        if (bits & 1) {
+          p->fini(obj);
+        }
+      }
+    }
+  }
+}
+
+FLYAPI void pool_del(pool *p) {
+  if (p) {
+    pool_fini_live(p);
+    arena_del(p->arena);
+    free(p);
+  }
+}
+
+FLYAPI void *pool_alloc(pool *p) {
+  void *ret;
+
+  FLY_BAIL_IF_NULL(p, NULL);
+
+  if (p->free) {
+    ret = p->free;
+    p->free = *(void **) ret;
+  } else {
+    if (p->next == p->end && !pool_add_slab(p)) {
+      return NULL;
+    }
+
+    ret = p->next;
+    p->next += p->size;
+  }
+
+  if (p->fini) {
+    pool_mark(p, (uint8_t *) ret, true);
+  }
+
+  p->live++;
+  fly_status = FLY_OK;
+
+  if (p->init) {
+    p->init(ret);
+  }
+
+  return ret;
+}
+
+FLYAPI void pool_free(pool *p, void *obj) {
+  FLY_BAIL_IF_NULL(p);
+
+  fly_status = FLY_OK;
+
+  if (!obj) {
+    return;
+  }
+
+  if (p->fini) {
+    p->fini(obj);
+    pool_mark(p, (uint8_t *) obj, false);
+  }
+
+  *(void **) obj = p->free;
+  p->free = obj;
+  p->live--;
+}
+
+FLYAPI void pool_reset(pool *p) {
+  FLY_BAIL_IF_NULL(p);
+
+  pool_fini_live(p);
+  arena_clear(p->arena);
+
+  p->free = NULL;
+  p->next = p->end = NULL;
+  p->slabs = NULL;
+  p->live = 0;
+
+  fly_status = FLY_OK;
+}
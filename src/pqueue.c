@@ -0,0 +1,227 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "pqueue.h"
+
+#include "jargon.h"
+
+extern inline pqueue *pqueue_new(int (*comp)(const void *, const void *));
+extern inline size_t pqueue_size(pqueue *q);
+
+__attribute__((const))
+static int comp_address(const void *lp, const void *rp) {
+  uintptr_t left = *(uintptr_t *) lp;
+  uintptr_t right = *(uintptr_t *) rp;
+
+  return (left > right) - (left < right);
+}
+
+FLYAPI pqueue *pqueue_new_of_arity(
+    size_t arity, int (*comp)(const void *, const void *)) {
+  pqueue *ret;
+
+  if (arity < 2) {
+    fly_status = FLY_E_INVALID_ARG;
+    return NULL;
+  }
+
+  if (!(ret = (pqueue *) malloc(sizeof (pqueue)))) {
+    fly_status = FLY_E_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  if (!(ret->heap = (arlist *) list_new_kind(LISTKIND_ARRAY))) {
+    free(ret);
+    return NULL;
+  }
+
+  ret->arity = arity;
+  ret->comp = comp ? comp : &comp_address;
+  ret->moved = NULL;
+
+  fly_status = FLY_OK;
+
+  return ret;
+}
+
+FLYAPI void pqueue_del(pqueue *q) {
+  if (q) {
+    list_del((list *) q->heap);
+    free(q);
+  }
+}
+
+// The number of nodes with children. Written so it can't overflow.
+static inline size_t pqueue_parents(size_t size, size_t arity) {
+  return size > 1 ? (size - 2) / arity + 1 : 0;
+}
+
+static inline void pqueue_place(pqueue *q, size_t i, void *data) {
+  q->heap->items[i] = data;
+
+  if (q->moved) {
+    q->moved(data, i);
+  }
+}
+
+// Both sifts carry the item in hand and shift the others over the hole, so
+// each step is one store instead of a swap.
+static void pqueue_sift_up(pqueue *q, size_t i) {
+  void ** const items = q->heap->items;
+  void *data = items[i];
+  size_t parent;
+
+  while (i) {
+    parent = (i - 1) / q->arity;
+
+    if (q->comp(&data, &items[parent]) >= 0) {
+      break;
+    }
+
+    pqueue_place(q, i, items[parent]);
+    i = parent;
+  }
+
+  pqueue_place(q, i, data);
+}
+
+static void pqueue_sift_down(pqueue *q, size_t i) {
+  void ** const items = q->heap->items;
+  const size_t size = q->heap->size, arity = q->arity;
+  const size_t parents = pqueue_parents(size, arity);
+  void *data = items[i];
+  size_t child, best, end;
+
+  while (i < parents) {
+    best = child = i * arity + 1;
+    end = size - child > arity ? child + arity : size;
+
+    while (++child < end) {
+      if (q->comp(&items[child], &items[best]) < 0) {
+        best = child;
+      }
+    }
+
+    if (q->comp(&items[best], &data) >= 0) {
+      break;
+    }
+
+    pqueue_place(q, i, items[best]);
+    i = best;
+  }
+
+  pqueue_place(q, i, data);
+}
+
+FLYAPI void pqueue_push(pqueue *q, void *data) {
+  FLY_BAIL_IF_NULL(q);
+
+  if (!arlist_ensure_capacity(q->heap, 1)) {
+    return;
+  }
+
+  fly_status = FLY_OK;
+
+  q->heap->items[q->heap->size++] = data;
+  pqueue_sift_up(q, q->heap->size - 1);
+}
+
+FLYAPI void pqueue_push_array(pqueue *q, size_t n, void **items) {
+  size_t i, old_size;
+
+  FLY_BAIL_IF_NULL(q && (items || !n));
+
+  fly_status = FLY_OK;
+
+  if (!n || !arlist_ensure_capacity(q->heap, n)) {
+    return;
+  }
+
+  old_size = q->heap->size;
+  memcpy(q->heap->items + old_size, items, n * sizeof (void *));
+  q->heap->size += n;
+
+  if (n <= old_size) {
+    for (i = old_size; i < q->heap->size; i++) {
+      pqueue_sift_up(q, i);
+    }
+
+    return;
+  }
+
+  // Floyd's heapify never touches the leaves, so report where they landed.
+  if (q->moved) {
+    for (i = old_size; i < q->heap->size; i++) {
+      q->moved(q->heap->items[i], i);
+    }
+  }
+
+  for (i = pqueue_parents(q->heap->size, q->arity); i--;) {
+    pqueue_sift_down(q, i);
+  }
+}
+
+FLYAPI void *pqueue_peek(pqueue *q) {
+  FLY_BAIL_IF_NULL(q, NULL);
+  FLY_BAIL_IF_EMPTY(q->heap->size, NULL);
+
+  fly_status = FLY_OK;
+
+  return q->heap->items[0];
+}
+
+static void *pqueue_remove_at(pqueue *q, size_t index) {
+  void ** const items = q->heap->items;
+  void *ret = items[index], *last = items[--q->heap->size];
+
+  if (index < q->heap->size) {
+    items[index] = last;
+
+    if (index && q->comp(&last, &items[(index - 1) / q->arity]) < 0) {
+      pqueue_sift_up(q, index);
+    } else {
+      pqueue_sift_down(q, index);
+    }
+  }
+
+  if (q->moved) {
+    q->moved(ret, PQUEUE_REMOVED);
+  }
+
+  return ret;
+}
+
+FLYAPI void *pqueue_pop(pqueue *q) {
+  FLY_BAIL_IF_NULL(q, NULL);
+  FLY_BAIL_IF_EMPTY(q->heap->size, NULL);
+
+  fly_status = FLY_OK;
+
+  return pqueue_remove_at(q, 0);
+}
+
+FLYAPI void pqueue_decrease_key(pqueue *q, size_t index) {
+  FLY_BAIL_IF_NULL(q);
+
+  if (index >= q->heap->size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return;
+  }
+
+  fly_status = FLY_OK;
+
+  pqueue_sift_up(q, index);
+}
+
+FLYAPI void *pqueue_remove(pqueue *q, size_t index) {
+  FLY_BAIL_IF_NULL(q, NULL);
+
+  if (index >= q->heap->size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return NULL;
+  }
+
+  fly_status = FLY_OK;
+
+  return pqueue_remove_at(q, index);
+}
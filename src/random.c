@@ -22,3 +22,82 @@ extern inline uint64_t rng64_next(rng64 *rng);
 extern inline uint64_t rng64_next_thunk(void *rng);
 extern inline uint64_t rng64_next_in(rng64 *rng, uint64_t bound);
 extern inline uint64_t rng64_next_in_biased(rng64 *rng, uint64_t bound);
+
+// Spelled out lane by lane, since left as a loop over the lanes array the
+// lanes tend to stay in memory and the chains run no faster than one.
+#define RNG_FILL_LANE(output, j) \
+  out[i + j] = output(lanes[j]); \
+  lanes[j] = lanes[j] * jump_mult + jump_inc;
+
+#define RNG_FILL_STEP(output) \
+  RNG_FILL_LANE(output, 0) \
+  RNG_FILL_LANE(output, 1) \
+  RNG_FILL_LANE(output, 2) \
+  RNG_FILL_LANE(output, 3)
+
+_Static_assert(RNG_FILL_LANES == 4, "RNG_FILL_STEP has a line per lane");
+
+// pcg32 outputs the state it had before stepping, so the lanes hold those.
+FLYAPI void rng32_fill(rng32 *rng, uint32_t *out, size_t n) {
+  const uint64_t mult = PCG_DEFAULT_MULTIPLIER_64, inc = rng->inc;
+  uint64_t lanes[RNG_FILL_LANES], jump_mult = 1, jump_inc = 0;
+  size_t i, j;
+
+  for (j = 0; j < RNG_FILL_LANES; j++) {
+    lanes[j] = j ? lanes[j - 1] * mult + inc : rng->state;
+    jump_inc = jump_inc * mult + inc;
+    jump_mult *= mult;
+  }
+
+  for (i = 0; i + RNG_FILL_LANES <= n; i += RNG_FILL_LANES) {
+    RNG_FILL_STEP(pcg_output_xsh_rr_64_32);
+  }
+
+  for (j = 0; i + j < n; j++) {
+    out[i + j] = pcg_output_xsh_rr_64_32(lanes[j]);
+  }
+
+  rng->state = lanes[j];
+}
+
+#ifdef __SIZEOF_INT128__
+// pcg64 steps first and outputs the new state, so the lanes hold that one,
+// and the last lane used is where rng ends up.
+FLYAPI void rng64_fill(rng64 *rng, uint64_t *out, size_t n) {
+  const pcg128_t mult = PCG_DEFAULT_MULTIPLIER_128, inc = rng->inc;
+  pcg128_t lanes[RNG_FILL_LANES], jump_mult = 1, jump_inc = 0;
+  size_t i, j;
+
+  if (!n) {
+    return;
+  }
+
+  for (j = 0; j < RNG_FILL_LANES; j++) {
+    lanes[j] = (j ? lanes[j - 1] : rng->state) * mult + inc;
+    jump_inc = jump_inc * mult + inc;
+    jump_mult *= mult;
+  }
+
+  for (i = 0; i + RNG_FILL_LANES < n; i += RNG_FILL_LANES) {
+    RNG_FILL_STEP(pcg_output_xsl_rr_128_64);
+  }
+
+  for (j = 0; i + j < n; j++) {
+    out[i + j] = pcg_output_xsl_rr_128_64(lanes[j]);
+  }
+
+  rng->state = lanes[j - 1];
+}
+#endif
+
+#undef RNG_FILL_STEP
+#undef RNG_FILL_LANE
+
+#ifndef __SIZEOF_INT128__
+// Without 128-bit integers each value is two pcg32 draws, left to rng64_next().
+FLYAPI void rng64_fill(rng64 *rng, uint64_t *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = rng64_next(rng);
+  }
+}
+#endif
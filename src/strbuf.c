@@ -0,0 +1,233 @@
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "strbuf.h"
+#include "hash.h"
+
+#include "jargon.h"
+
+extern inline void strbuf_init(strbuf *sb, arena *a);
+extern inline size_t strbuf_size(strbuf *sb);
+
+FLYAPI void strbuf_append(strbuf *sb, const char *s) {
+  strbuf_appendn(sb, s, strlen(s));
+}
+
+FLYAPI void strbuf_appendn(strbuf *sb, const char *s, size_t n) {
+  arena_vec_push_array(&sb->chars, n, s);
+}
+
+// Formats straight into the room the buffer has, and only if that's too
+// short, grows it and formats again.
+FLYAPI void strbuf_appendf(strbuf *sb, const char *format, ...) {
+  arena_vec *v = &sb->chars;
+  size_t room = v->capacity - v->size;
+  va_list args, again;
+  int n;
+
+  va_start(args, format);
+  va_copy(again, args);
+  n = vsnprintf(room ? (char *) v->items + v->size : NULL, room, format, args);
+  va_end(args);
+
+  if (n < 0) {
+    fly_status = FLY_E_INVALID_ARG;
+    goto done;
+  }
+
+  if ((size_t) n >= room) {
+    size_t capacity = v->size + n + 1;
+
+    if (capacity < 2 * v->capacity && v->capacity <= SIZE_MAX / 2) {
+      capacity = 2 * v->capacity;
+    }
+
+    if (!arena_vec_reserve(v, capacity)) {
+      goto done;
+    }
+
+    vsnprintf((char *) v->items + v->size, n + 1, format, again);
+  }
+
+  v->size += n;
+  fly_status = FLY_OK;
+
+done:
+  va_end(again);
+}
+
+FLYAPI char *strbuf_finish(strbuf *sb) {
+  arena_vec *v = &sb->chars;
+  char *ret, *trimmed;
+
+  if (!(ret = (char *) arena_vec_push(v))) {
+    return NULL;
+  }
+
+  *ret = '\0';
+  ret = (char *) v->items;
+
+  if ((trimmed = arena_realloc(v->arena, ret, v->capacity, v->size))) {
+    ret = trimmed;
+  }
+
+  arena_vec_init(v, v->arena, 1, 1);
+  fly_status = FLY_OK;
+
+  return ret;
+}
+
+FLYAPI strtab *strtab_new(void) {
+  strtab *ret;
+
+  if (!(ret = (strtab *) malloc(sizeof (strtab)))) {
+    fly_status = FLY_E_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  if (!(ret->strings = arena_new(0))) {
+    free(ret);
+    return NULL;
+  }
+
+  ret->slots = (struct strtab_entry *) calloc(
+      STRTAB_MIN_CAPACITY, sizeof (struct strtab_entry));
+
+  if (!ret->slots) {
+    arena_del(ret->strings);
+    free(ret);
+    fly_status = FLY_E_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  ret->size = 0;
+  ret->capacity = STRTAB_MIN_CAPACITY;
+  fly_status = FLY_OK;
+
+  return ret;
+}
+
+FLYAPI void strtab_del(strtab *t) {
+  if (t) {
+    arena_del(t->strings);
+    free(t->slots);
+    free(t);
+  }
+}
+
+// The slot holding s, or the empty one it would go in.
+static struct strtab_entry *strtab_find(
+    struct strtab_entry *slots, size_t capacity,
+    const char *s, size_t len, size_t hash) {
+  struct strtab_entry *e;
+
+  for (size_t i = hash & (capacity - 1);; i = (i + 1) & (capacity - 1)) {
+    e = &slots[i];
+
+    if (!e->str || (e->hash == hash && e->len == len
+          && !memcmp(e->str, s, len))) {
+      return e;
+    }
+  }
+}
+
+static bool strtab_grow(strtab *t) {
+  size_t capacity = 2 * t->capacity;
+  struct strtab_entry *slots = (struct strtab_entry *) calloc(
+      capacity, sizeof (struct strtab_entry));
+
+  if (!slots) {
+    fly_status = FLY_E_OUT_OF_MEMORY;
+    return false;
+  }
+
+  for (size_t i = 0; i < t->capacity; i++) {
+    struct strtab_entry *e = &t->slots[i];
+
+    if (e->str) {
+      *strtab_find(slots, capacity, e->str, e->len, e->hash) = *e;
+    }
+  }
+
+  free(t->slots);
+  t->slots = slots;
+  t->capacity = capacity;
+
+  return true;
+}
+
+FLYAPI const char *strtab_intern(strtab *t, const char *s) {
+  FLY_BAIL_IF_NULL(s, NULL);
+
+  return strtab_internn(t, s, strlen(s));
+}
+
+FLYAPI const char *strtab_internn(strtab *t, const char *s, size_t n) {
+  struct strtab_entry *e;
+  size_t hash;
+  char *copy;
+
+  FLY_BAIL_IF_NULL(t, NULL);
+  FLY_BAIL_IF_NULL(s, NULL);
+
+  hash = blind_bounded_hash_string(s, n);
+  e = strtab_find(t->slots, t->capacity, s, n, hash);
+
+  if (e->str) {
+    fly_status = FLY_OK;
+    return e->str;
+  }
+
+  if (n == SIZE_MAX) {
+    fly_status = FLY_E_TOO_BIG;
+    return NULL;
+  }
+
+  if (2 * (t->size + 1) > t->capacity) {
+    if (!strtab_grow(t)) {
+      return NULL;
+    }
+
+    e = strtab_find(t->slots, t->capacity, s, n, hash);
+  }
+
+  if (!(copy = (char *) arena_alloc_aligned(t->strings, n + 1, 1))) {
+    return NULL;
+  }
+
+  memcpy(copy, s, n);
+  copy[n] = '\0';
+
+  e->str = copy;
+  e->len = n;
+  e->hash = hash;
+  t->size++;
+
+  fly_status = FLY_OK;
+
+  return copy;
+}
+
+FLYAPI const char *strtab_lookup(strtab *t, const char *s) {
+  struct strtab_entry *e;
+  size_t len;
+
+  FLY_BAIL_IF_NULL(t, NULL);
+  FLY_BAIL_IF_NULL(s, NULL);
+
+  len = strlen(s);
+  e = strtab_find(
+      t->slots, t->capacity, s, len, blind_bounded_hash_string(s, len));
+
+  if (!e->str) {
+    fly_status = FLY_NOT_FOUND;
+    return NULL;
+  }
+
+  fly_status = FLY_OK;
+
+  return e->str;
+}
@@ -0,0 +1,731 @@
+#include <assert.h>
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wsdeque.h"
+#include "internal/common.h"
+
+#include "jargon.h"
+
+#define WSDEQUE_DEFAULT_CAPACITY 8
+
+// Owner-only operations that need the items in order borrow the arlist
+// implementations, which see the ring as a plain array of pointers.
+static_assert(
+    sizeof (_Atomic(void *)) == sizeof (void *),
+    "atomic pointers must be layout-compatible with plain pointers");
+
+// C++ includers see wsdeque's atomics as plain members.
+static_assert(
+    sizeof (_Atomic(ptrdiff_t)) == sizeof (ptrdiff_t)
+      && alignof (_Atomic(ptrdiff_t)) == alignof (ptrdiff_t)
+      && alignof (_Atomic(void *)) == alignof (void *),
+    "atomic members must be layout-compatible with plain ones");
+
+static void wsdeque_init(wsdeque *l);
+static void wsdeque_del(wsdeque *l);
+static void *_unsafe_wsdeque_get(wsdeque *l, ptrdiff_t i);
+static void _unsafe_wsdeque_push(wsdeque *l, void *data);
+static void _unsafe_wsdeque_unshift(wsdeque *l, void *data);
+static void *_unsafe_wsdeque_pop(wsdeque *l);
+static void *_unsafe_wsdeque_steal(wsdeque *l);
+static void wsdeque_concat(wsdeque * restrict l1, wsdeque * restrict l2);
+static void _unsafe_wsdeque_append_array(wsdeque *l, size_t n, void **items);
+static void _unsafe_wsdeque_foreach(wsdeque *l, int (*)(void *, size_t));
+static void *_unsafe_wsdeque_find_first(wsdeque *l, int (*matcher)(void *));
+static void *_unsafe_wsdeque_discard(wsdeque *l, int (*matcher)(void *));
+static size_t _unsafe_wsdeque_discard_all(
+    wsdeque *l, int (*matcher)(void *), int (*fn)(void *, size_t));
+static void _unsafe_wsdeque_shuffle(wsdeque *l);
+static void _unsafe_wsdeque_sort(
+    wsdeque *l, int (*comp)(const void *, const void *));
+static void _unsafe_wsdeque_sort_stable(
+    wsdeque *l, int (*comp)(const void *, const void *));
+static void *_unsafe_wsdeque_select_nth(
+    wsdeque *l, size_t n, int (*comp)(const void *, const void *));
+static void _unsafe_wsdeque_partial_sort(
+    wsdeque *l, size_t k, int (*comp)(const void *, const void *));
+static size_t _unsafe_wsdeque_index_of(wsdeque *l, void *data);
+static size_t _unsafe_wsdeque_count_of(wsdeque *l, void *data);
+static void _unsafe_wsdeque_pop_many(wsdeque *l, size_t n, void **out);
+static void _unsafe_wsdeque_shift_many(wsdeque *l, size_t n, void **out);
+static void _unsafe_wsdeque_unshift_array(
+    wsdeque *l, size_t n, void **items);
+static void _unsafe_wsdeque_insert(wsdeque *l, size_t i, void *data);
+static void *_unsafe_wsdeque_remove_at(wsdeque *l, size_t i);
+static void _unsafe_wsdeque_reverse(wsdeque *l);
+static void _unsafe_wsdeque_rotate(wsdeque *l, size_t k);
+static void _unsafe_wsdeque_slice(wsdeque *l, size_t from, size_t n, list *dst);
+static void _unsafe_wsdeque_splice(
+    wsdeque *dst, size_t pos, wsdeque *src, size_t from, size_t n);
+static void _unsafe_wsdeque_iter(wsdeque *l, list_iter *it);
+
+FLYAPI listkind *LISTKIND_WORKSTEAL = &(listkind) {
+  sizeof (wsdeque),
+  (void *) &wsdeque_init,
+  (void *) &wsdeque_del,
+  (void *) &_unsafe_wsdeque_get,
+  (void *) &_unsafe_wsdeque_push,
+  (void *) &_unsafe_wsdeque_unshift,
+  (void *) &_unsafe_wsdeque_pop,
+  (void *) &_unsafe_wsdeque_steal,
+  (void *) &wsdeque_concat,
+  (void *) &_unsafe_wsdeque_append_array,
+  (void *) &_unsafe_wsdeque_foreach,
+  (void *) &_unsafe_wsdeque_find_first,
+  (void *) &_unsafe_wsdeque_discard,
+  (void *) &_unsafe_wsdeque_discard_all,
+  (void *) &_unsafe_wsdeque_shuffle,
+  (void *) &_unsafe_wsdeque_sort,
+  (void *) &_unsafe_wsdeque_sort_stable,
+  (void *) &_unsafe_wsdeque_select_nth,
+  (void *) &_unsafe_wsdeque_partial_sort,
+  (void *) &_unsafe_wsdeque_index_of,
+  (void *) &_unsafe_wsdeque_count_of,
+  (void *) &_unsafe_wsdeque_pop_many,
+  (void *) &_unsafe_wsdeque_shift_many,
+  (void *) &_unsafe_wsdeque_unshift_array,
+  (void *) &_unsafe_wsdeque_insert,
+  (void *) &_unsafe_wsdeque_remove_at,
+  (void *) &_unsafe_wsdeque_reverse,
+  (void *) &_unsafe_wsdeque_rotate,
+  (void *) &_unsafe_wsdeque_slice,
+  (void *) &_unsafe_wsdeque_splice,
+  (void *) &_unsafe_wsdeque_iter,
+};
+
+static inline void *ring_get(struct wsdeque_ring *ring, ptrdiff_t i) {
+  return atomic_load_explicit(
+      &ring->items[(size_t) i & ring->mask], memory_order_relaxed);
+}
+
+static inline void ring_put(struct wsdeque_ring *ring, ptrdiff_t i, void *data) {
+  atomic_store_explicit(
+      &ring->items[(size_t) i & ring->mask], data, memory_order_relaxed);
+}
+
+static void wsdeque_init(wsdeque *l) {
+  l->size = 0;
+  atomic_init(&l->ring, NULL);
+  atomic_init(&l->top, 0);
+  atomic_init(&l->bottom, 0);
+}
+
+static void wsdeque_del(wsdeque *l) {
+  struct wsdeque_ring *ring = atomic_load_explicit(
+      &l->ring, memory_order_relaxed);
+
+  while (ring) {
+    struct wsdeque_ring *prev = ring->prev;
+    free(ring);
+    ring = prev;
+  }
+}
+
+// Owner only. Thieves may still be reading from the old ring, so it is kept
+// on the retired chain until the deque is quiescent again.
+static struct wsdeque_ring *wsdeque_grow(
+    wsdeque *l, struct wsdeque_ring *ring,
+    ptrdiff_t top, ptrdiff_t bottom, size_t new_elements) {
+  const size_t used = (size_t) (bottom - top);
+  size_t capacity = ring ? ring->mask + 1 : WSDEQUE_DEFAULT_CAPACITY;
+  struct wsdeque_ring *next;
+
+  if (new_elements > PTRINDEX_MAX - used) {
+    fly_status = FLY_E_TOO_BIG;
+    return NULL;
+  }
+
+  while (capacity - used < new_elements) {
+    if (capacity > PTRINDEX_MAX / 2) {
+      fly_status = FLY_E_TOO_BIG;
+      return NULL;
+    }
+    capacity *= 2;
+  }
+
+  next = (struct wsdeque_ring *) malloc(
+      sizeof (struct wsdeque_ring) + capacity * sizeof (_Atomic(void *)));
+
+  if (!next) {
+    fly_status = FLY_E_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  next->prev = ring;
+  next->mask = capacity - 1;
+
+  for (ptrdiff_t i = top; i < bottom; i++) {
+    ring_put(next, i, ring_get(ring, i));
+  }
+
+  atomic_store_explicit(&l->ring, next, memory_order_release);
+  return next;
+}
+
+static inline struct wsdeque_ring *wsdeque_reserve(
+    wsdeque *l, ptrdiff_t top, ptrdiff_t bottom, size_t new_elements) {
+  struct wsdeque_ring *ring = atomic_load_explicit(
+      &l->ring, memory_order_relaxed);
+
+  if (!ring || new_elements > ring->mask + 1 - (size_t) (bottom - top)) {
+    return wsdeque_grow(l, ring, top, bottom, new_elements);
+  }
+
+  return ring;
+}
+
+static void _unsafe_wsdeque_push(wsdeque *l, void *data) {
+  ptrdiff_t b = atomic_load_explicit(&l->bottom, memory_order_relaxed);
+  ptrdiff_t t = atomic_load_explicit(&l->top, memory_order_acquire);
+  struct wsdeque_ring *ring = wsdeque_reserve(l, t, b, 1);
+
+  if (!ring) {
+    return;
+  }
+
+  ring_put(ring, b, data);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&l->bottom, b + 1, memory_order_relaxed);
+
+  l->size = (size_t) (b + 1 - t);
+}
+
+FLYAPI void wsdeque_push(wsdeque *l, void *data) {
+  FLY_BAIL_IF_NULL(l);
+
+  fly_status = FLY_OK;
+  _unsafe_wsdeque_push(l, data);
+}
+
+static void *_unsafe_wsdeque_pop(wsdeque *l) {
+  ptrdiff_t b = atomic_load_explicit(&l->bottom, memory_order_relaxed) - 1;
+  struct wsdeque_ring *ring = atomic_load_explicit(
+      &l->ring, memory_order_relaxed);
+  ptrdiff_t t;
+  void *ret = NULL;
+
+  atomic_store_explicit(&l->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  t = atomic_load_explicit(&l->top, memory_order_relaxed);
+
+  if (t < b) {
+    l->size = (size_t) (b - t);
+    return ring_get(ring, b);
+  }
+
+  if (t == b) {
+    // Last item: race the thieves for it.
+    ret = ring_get(ring, b);
+
+    if (!atomic_compare_exchange_strong_explicit(
+          &l->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+      ret = NULL;
+      fly_status = FLY_EMPTY;
+    }
+  } else {
+    fly_status = FLY_EMPTY;
+  }
+
+  atomic_store_explicit(&l->bottom, b + 1, memory_order_relaxed);
+  l->size = 0;
+
+  return ret;
+}
+
+FLYAPI void *wsdeque_pop(wsdeque *l) {
+  FLY_BAIL_IF_NULL(l, NULL);
+
+  fly_status = FLY_OK;
+  return _unsafe_wsdeque_pop(l);
+}
+
+static void *_unsafe_wsdeque_steal(wsdeque *l) {
+  ptrdiff_t t, b;
+  void *ret;
+
+  do {
+    t = atomic_load_explicit(&l->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    b = atomic_load_explicit(&l->bottom, memory_order_acquire);
+
+    if (t >= b) {
+      fly_status = FLY_EMPTY;
+      return NULL;
+    }
+
+    ret = ring_get(atomic_load_explicit(&l->ring, memory_order_acquire), t);
+  } while (!atomic_compare_exchange_strong_explicit(
+        &l->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed));
+
+  return ret;
+}
+
+FLYAPI void *wsdeque_steal(wsdeque *l) {
+  FLY_BAIL_IF_NULL(l, NULL);
+
+  fly_status = FLY_OK;
+  return _unsafe_wsdeque_steal(l);
+}
+
+FLYAPI size_t wsdeque_size(wsdeque *l) {
+  FLY_BAIL_IF_NULL(l, 0);
+
+  ptrdiff_t t = atomic_load_explicit(&l->top, memory_order_acquire);
+  ptrdiff_t b = atomic_load_explicit(&l->bottom, memory_order_acquire);
+
+  fly_status = FLY_OK;
+  return b > t ? (size_t) (b - t) : 0;
+}
+
+// Everything below is owner-only and assumes there are no thieves.
+
+static void *_unsafe_wsdeque_get(wsdeque *l, ptrdiff_t i) {
+  if (i < 0) {
+    i += l->size;
+  }
+
+  return ring_get(
+      atomic_load_explicit(&l->ring, memory_order_relaxed),
+      atomic_load_explicit(&l->top, memory_order_relaxed) + i);
+}
+
+static void _unsafe_wsdeque_unshift(wsdeque *l, void *data) {
+  ptrdiff_t t = atomic_load_explicit(&l->top, memory_order_relaxed);
+  ptrdiff_t b = atomic_load_explicit(&l->bottom, memory_order_relaxed);
+  struct wsdeque_ring *ring = wsdeque_reserve(l, t, b, 1);
+
+  if (!ring) {
+    return;
+  }
+
+  ring_put(ring, --t, data);
+  atomic_store_explicit(&l->top, t, memory_order_relaxed);
+
+  l->size = (size_t) (b - t);
+}
+
+static void _unsafe_wsdeque_append_array(wsdeque *l, size_t n, void **items) {
+  ptrdiff_t t = atomic_load_explicit(&l->top, memory_order_relaxed);
+  ptrdiff_t b = atomic_load_explicit(&l->bottom, memory_order_relaxed);
+  struct wsdeque_ring *ring = wsdeque_reserve(l, t, b, n);
+
+  if (!ring) {
+    return;
+  }
+
+  while (n--) {
+    ring_put(ring, b++, *items++);
+  }
+
+  atomic_store_explicit(&l->bottom, b, memory_order_release);
+  l->size = (size_t) (b - t);
+}
+
+static void _unsafe_wsdeque_unshift_array(
+    wsdeque *l, size_t n, void **items) {
+  ptrdiff_t t = atomic_load_explicit(&l->top, memory_order_relaxed);
+  ptrdiff_t b = atomic_load_explicit(&l->bottom, memory_order_relaxed);
+  struct wsdeque_ring *ring = wsdeque_reserve(l, t, b, n);
+
+  if (!ring) {
+    return;
+  }
+
+  items += n;
+
+  while (n--) {
+    ring_put(ring, --t, *--items);
+  }
+
+  atomic_store_explicit(&l->top, t, memory_order_relaxed);
+  l->size = (size_t) (b - t);
+}
+
+// The batch removals are owner-only like everything else but push, pop and
+// steal, so they can move either end without the pop protocol.
+static void _unsafe_wsdeque_pop_many(wsdeque *l, size_t n, void **out) {
+  struct wsdeque_ring *ring = atomic_load_explicit(
+      &l->ring, memory_order_relaxed);
+  ptrdiff_t t = atomic_load_explicit(&l->top, memory_order_relaxed);
+  ptrdiff_t b = atomic_load_explicit(&l->bottom, memory_order_relaxed);
+
+  b -= (ptrdiff_t) n;
+
+  for (ptrdiff_t i = b; n--; i++) {
+    *out++ = ring_get(ring, i);
+  }
+
+  atomic_store_explicit(&l->bottom, b, memory_order_relaxed);
+  l->size = (size_t) (b - t);
+}
+
+static void _unsafe_wsdeque_shift_many(wsdeque *l, size_t n, void **out) {
+  struct wsdeque_ring *ring = atomic_load_explicit(
+      &l->ring, memory_order_relaxed);
+  ptrdiff_t t = atomic_load_explicit(&l->top, memory_order_relaxed);
+  ptrdiff_t b = atomic_load_explicit(&l->bottom, memory_order_relaxed);
+
+  while (n--) {
+    *out++ = ring_get(ring, t++);
+  }
+
+  atomic_store_explicit(&l->top, t, memory_order_relaxed);
+  l->size = (size_t) (b - t);
+}
+
+static void wsdeque_concat(wsdeque * restrict l1, wsdeque * restrict l2) {
+  ptrdiff_t t1 = atomic_load_explicit(&l1->top, memory_order_relaxed);
+  ptrdiff_t b1 = atomic_load_explicit(&l1->bottom, memory_order_relaxed);
+  ptrdiff_t t2 = atomic_load_explicit(&l2->top, memory_order_relaxed);
+  ptrdiff_t b2 = atomic_load_explicit(&l2->bottom, memory_order_relaxed);
+  struct wsdeque_ring *src, *dst;
+
+  if (t2 >= b2) {
+    return;
+  }
+
+  if (!(dst = wsdeque_reserve(l1, t1, b1, (size_t) (b2 - t2)))) {
+    return;
+  }
+
+  src = atomic_load_explicit(&l2->ring, memory_order_relaxed);
+
+  while (t2 < b2) {
+    ring_put(dst, b1++, ring_get(src, t2++));
+  }
+
+  atomic_store_explicit(&l1->bottom, b1, memory_order_release);
+  l1->size = (size_t) (b1 - t1);
+}
+
+static inline void reverse_items(void **left, void **right) {
+  void *temp;
+
+  while (left < --right) {
+    temp = *left;
+    *left++ = *right;
+    *right = temp;
+  }
+}
+
+// Moves the items to the front of the ring so that they can be handed to the
+// arlist implementation as-is, and frees any retired rings along the way.
+static void wsdeque_view(wsdeque *l, arlist *view) {
+  struct wsdeque_ring *ring = atomic_load_explicit(
+      &l->ring, memory_order_relaxed);
+  ptrdiff_t t = atomic_load_explicit(&l->top, memory_order_relaxed);
+  ptrdiff_t b = atomic_load_explicit(&l->bottom, memory_order_relaxed);
+
+  view->kind = LISTKIND_ARRAY;
+  view->size = l->size = b > t ? (size_t) (b - t) : 0;
+  view->rng = l->rng;
+
+  if (!ring) {
+    view->capacity = 0;
+    view->items = NULL;
+    return;
+  }
+
+  for (struct wsdeque_ring *dead; (dead = ring->prev);) {
+    ring->prev = dead->prev;
+    free(dead);
+  }
+
+  void ** const items = (void **) ring->items;
+  const size_t capacity = ring->mask + 1;
+  const size_t offset = (size_t) t & ring->mask;
+
+  if (offset) {
+    // Rotating the whole ring left by `offset` puts the items in order at 0.
+    reverse_items(items, items + offset);
+    reverse_items(items + offset, items + capacity);
+    reverse_items(items, items + capacity);
+  }
+
+  atomic_store_explicit(&l->top, 0, memory_order_relaxed);
+  atomic_store_explicit(&l->bottom, view->size, memory_order_relaxed);
+
+  view->capacity = capacity;
+  view->items = items;
+}
+
+static void wsdeque_unview(wsdeque *l, arlist *view) {
+  l->size = view->size;
+  l->rng = view->rng;
+  atomic_store_explicit(&l->bottom, view->size, memory_order_relaxed);
+}
+
+// The items where they sit, as two arlists: from the top to the end of the
+// ring, then on from its start. Queries that only read go through these
+// rather than wsdeque_view(), which would move every item to look at them.
+static void wsdeque_runs(wsdeque *l, arlist runs[2]) {
+  struct wsdeque_ring *ring = atomic_load_explicit(
+      &l->ring, memory_order_relaxed);
+  ptrdiff_t t = atomic_load_explicit(&l->top, memory_order_relaxed);
+  ptrdiff_t b = atomic_load_explicit(&l->bottom, memory_order_relaxed);
+  const size_t size = b > t ? (size_t) (b - t) : 0;
+
+  for (int r = 0; r < 2; r++) {
+    runs[r].kind = LISTKIND_ARRAY;
+    runs[r].size = runs[r].capacity = 0;
+    runs[r].rng = l->rng;
+    runs[r].items = NULL;
+  }
+
+  if (!ring || !size) {
+    return;
+  }
+
+  void ** const items = (void **) ring->items;
+  const size_t offset = (size_t) t & ring->mask;
+  const size_t tail = ring->mask + 1 - offset;
+  const size_t first = tail < size ? tail : size;
+
+  runs[0].items = items + offset;
+  runs[0].size = runs[0].capacity = first;
+  runs[1].items = items;
+  runs[1].size = runs[1].capacity = size - first;
+}
+
+static void _unsafe_wsdeque_foreach(wsdeque *l, int (*fn)(void *, size_t)) {
+  list_iter it;
+  size_t i = 0;
+
+  _unsafe_wsdeque_iter(l, &it);
+
+  while (list_iter_has_next(&it)) {
+    if (fn(list_iter_next(&it), i++)) {
+      return;
+    }
+  }
+}
+
+static void *_unsafe_wsdeque_find_first(wsdeque *l, int (*matcher)(void *)) {
+  arlist runs[2];
+  void *ret;
+
+  wsdeque_runs(l, runs);
+  ret = LISTKIND_ARRAY->find_first((list *) &runs[0], matcher);
+
+  return fly_status == FLY_OK
+    ? ret : LISTKIND_ARRAY->find_first((list *) &runs[1], matcher);
+}
+
+static void *_unsafe_wsdeque_discard(wsdeque *l, int (*matcher)(void *)) {
+  arlist view;
+  void *ret;
+
+  wsdeque_view(l, &view);
+  ret = LISTKIND_ARRAY->discard((list *) &view, matcher);
+  wsdeque_unview(l, &view);
+
+  return ret;
+}
+
+static size_t _unsafe_wsdeque_discard_all(
+    wsdeque *l, int (*matcher)(void *), int (*fn)(void *, size_t)) {
+  arlist view;
+  size_t ret;
+
+  wsdeque_view(l, &view);
+  ret = LISTKIND_ARRAY->discard_all((list *) &view, matcher, fn);
+  wsdeque_unview(l, &view);
+
+  return ret;
+}
+
+static void _unsafe_wsdeque_shuffle(wsdeque *l) {
+  arlist view;
+
+  wsdeque_view(l, &view);
+
+  if (view.size > 1) {
+    LISTKIND_ARRAY->shuffle((list *) &view);
+    wsdeque_unview(l, &view);
+  }
+}
+
+static void _unsafe_wsdeque_sort(
+    wsdeque *l, int (*comp)(const void *, const void *)) {
+  arlist view;
+
+  wsdeque_view(l, &view);
+
+  if (view.size > 1) {
+    LISTKIND_ARRAY->sort((list *) &view, comp);
+  }
+}
+
+static void _unsafe_wsdeque_sort_stable(
+    wsdeque *l, int (*comp)(const void *, const void *)) {
+  arlist view;
+
+  wsdeque_view(l, &view);
+
+  if (view.size > 1) {
+    LISTKIND_ARRAY->sort_stable((list *) &view, comp);
+  }
+}
+
+static void *_unsafe_wsdeque_select_nth(
+    wsdeque *l, size_t n, int (*comp)(const void *, const void *)) {
+  arlist view;
+
+  wsdeque_view(l, &view);
+
+  // Steals don't update size, so n can be past the items left even though
+  // the caller checked it against size.
+  if (n >= view.size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return NULL;
+  }
+
+  return LISTKIND_ARRAY->select_nth((list *) &view, n, comp);
+}
+
+static void _unsafe_wsdeque_partial_sort(
+    wsdeque *l, size_t k, int (*comp)(const void *, const void *)) {
+  arlist view;
+
+  wsdeque_view(l, &view);
+
+  if (k < view.size) {
+    LISTKIND_ARRAY->partial_sort((list *) &view, k, comp);
+  } else if (view.size > 1) {
+    LISTKIND_ARRAY->sort((list *) &view, comp);
+  }
+}
+
+// Steals don't update size, so it can be more than the items left, and not
+// found is SIZE_MAX rather than the count.
+static size_t _unsafe_wsdeque_index_of(wsdeque *l, void *data) {
+  arlist runs[2];
+  size_t i;
+
+  wsdeque_runs(l, runs);
+  i = LISTKIND_ARRAY->index_of((list *) &runs[0], data);
+
+  if (i == runs[0].size) {
+    i += LISTKIND_ARRAY->index_of((list *) &runs[1], data);
+  }
+
+  return i < runs[0].size + runs[1].size ? i : SIZE_MAX;
+}
+
+static size_t _unsafe_wsdeque_count_of(wsdeque *l, void *data) {
+  arlist runs[2];
+
+  wsdeque_runs(l, runs);
+
+  return LISTKIND_ARRAY->count_of((list *) &runs[0], data)
+    + LISTKIND_ARRAY->count_of((list *) &runs[1], data);
+}
+
+// The view can't grow the ring, so inserts and splices make room before
+// borrowing the arlist code.
+static void _unsafe_wsdeque_insert(wsdeque *l, size_t i, void *data) {
+  arlist view;
+
+  if (!wsdeque_reserve(
+        l, atomic_load_explicit(&l->top, memory_order_relaxed),
+        atomic_load_explicit(&l->bottom, memory_order_relaxed), 1)) {
+    return;
+  }
+
+  wsdeque_view(l, &view);
+
+  if (i > view.size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return;
+  }
+
+  LISTKIND_ARRAY->insert((list *) &view, i, data);
+  wsdeque_unview(l, &view);
+}
+
+static void *_unsafe_wsdeque_remove_at(wsdeque *l, size_t i) {
+  arlist view;
+  void *ret;
+
+  wsdeque_view(l, &view);
+
+  if (i >= view.size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return NULL;
+  }
+
+  ret = LISTKIND_ARRAY->remove_at((list *) &view, i);
+  wsdeque_unview(l, &view);
+
+  return ret;
+}
+
+static void _unsafe_wsdeque_reverse(wsdeque *l) {
+  arlist view;
+
+  wsdeque_view(l, &view);
+
+  if (view.size > 1) {
+    LISTKIND_ARRAY->reverse((list *) &view);
+  }
+}
+
+static void _unsafe_wsdeque_rotate(wsdeque *l, size_t k) {
+  arlist view;
+
+  wsdeque_view(l, &view);
+
+  if (view.size > 1 && (k %= view.size)) {
+    LISTKIND_ARRAY->rotate((list *) &view, k);
+  }
+}
+
+static void _unsafe_wsdeque_slice(
+    wsdeque *l, size_t from, size_t n, list *dst) {
+  arlist view;
+
+  wsdeque_view(l, &view);
+
+  if (from + n > view.size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return;
+  }
+
+  LISTKIND_ARRAY->slice((list *) &view, from, n, dst);
+}
+
+static void _unsafe_wsdeque_splice(
+    wsdeque *dst, size_t pos, wsdeque *src, size_t from, size_t n) {
+  arlist dst_view, src_view;
+
+  if (!wsdeque_reserve(
+        dst, atomic_load_explicit(&dst->top, memory_order_relaxed),
+        atomic_load_explicit(&dst->bottom, memory_order_relaxed), n)) {
+    return;
+  }
+
+  wsdeque_view(dst, &dst_view);
+  wsdeque_view(src, &src_view);
+
+  if (pos > dst_view.size || from + n > src_view.size) {
+    fly_status = FLY_E_OUT_OF_RANGE;
+    return;
+  }
+
+  LISTKIND_ARRAY->splice(
+      (list *) &dst_view, pos, (list *) &src_view, from, n);
+  wsdeque_unview(dst, &dst_view);
+  wsdeque_unview(src, &src_view);
+}
+
+// Reads the two runs of the ring in place, since rotating it into a view
+// would cost a pass over every slot.
+static void _unsafe_wsdeque_iter(wsdeque *l, list_iter *it) {
+  arlist runs[2];
+
+  wsdeque_runs(l, runs);
+  list_iter_init_runs(
+      it, runs[0].items, runs[0].size, runs[1].items, runs[1].size);
+}
@@ -50,7 +50,11 @@ void *__wrap_malloc(size_t size) {
 
   if (playlist) {
     mock = playlist;
-    playlist = mock->next;
+
+    if (!(playlist = mock->next)) {
+      playlist_end = NULL;
+    }
+
     ret = mock->ptr;
     free(mock);
     return ret;
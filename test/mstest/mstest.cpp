@@ -11,6 +11,11 @@ extern "C" {
 #include "test_hash.c"
 #include "test_random.c"
 #include "test_arena.c"
+#include "test_wsdeque.c"
+#include "test_pqueue.c"
+#include "test_gapbuf.c"
+#include "test_pool.c"
+#include "test_strbuf.c"
 }
 
 #undef TEST
@@ -41,6 +46,21 @@ namespace flytools {
 	};
 	TEST_CLASS(random) {
 #include "test_random.c"
+	};
+	TEST_CLASS(wsdeque) {
+#include "test_wsdeque.c"
+	};
+	TEST_CLASS(pqueue) {
+#include "test_pqueue.c"
+	};
+	TEST_CLASS(gapbuf) {
+#include "test_gapbuf.c"
+	};
+	TEST_CLASS(pool) {
+#include "test_pool.c"
+	};
+	TEST_CLASS(strbuf) {
+#include "test_strbuf.c"
 	};
 	TEST_CLASS(arena) {
 #include "test_arena.c"
@@ -1,9 +1,17 @@
 #include <stdalign.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "tests.h"
+#include "mockmem.h"
 
 #include "arena.h"
+#include "arena_shared.h"
+
+// The mstest harness only needs the declarations from C++.
+#if !defined(__STDC_NO_THREADS__) && !defined(__cplusplus)
+#include <threads.h>
+#endif
 
 
 #if !defined(_WINDLL) && !defined(METHODS_ONLY)
@@ -235,6 +243,20 @@ void do_test_arena_alloc_type() {
   assert_ptr_equal((void *) 0x3, o->_3);
   assert_ptr_equal((void *) 0x4, o->_4);
 
+  memset(arena_alloc(a, 10 * sizeof (int)), 0xFF, 10 * sizeof (int));
+  arena_clear(a);
+
+  int *zeros = arena_calloc_type(a, 10, int);
+  assert_non_null(zeros);
+  assert_fly_status(FLY_OK);
+  for (size_t k = 0; k < 10; k++) {
+    assert_int_equal(0, zeros[k]);
+  }
+
+  volatile size_t too_many = SIZE_MAX / 2;
+  assert_null(arena_calloc_type(a, too_many, int));
+  assert_fly_status(FLY_E_TOO_BIG);
+
   arena_del(a);
 }
 
@@ -495,6 +517,726 @@ void do_test_arena_push_then_grow_and_pop() {
 
   arena_del(a);
 }
+
+void do_test_arena_free_top() {
+  arena *a = new_test_arena(0);
+
+  uint8_t *first = arena_alloc(a, 24);
+  uint8_t *second = arena_alloc(a, 40);
+  uint8_t *next = a->next;
+
+  // only the newest allocation can be rolled back
+  arena_free(a, first);
+  assert_fly_status(FLY_OK);
+  assert_ptr_equal(next, a->next);
+
+  arena_free(a, second);
+  assert_ptr_equal(second, a->next);
+  assert_ptr_equal(second, arena_alloc(a, 40));
+
+  // and only once, since the one before it isn't remembered
+  arena_free(a, second);
+  arena_free(a, first);
+  assert_ptr_equal(second, a->next);
+
+  fly_status = FLY_E_TOO_BIG;
+  arena_free(a, NULL);
+  assert_fly_status(FLY_OK);
+
+  arena_del(a);
+}
+
+void assert_no_free_chunks(arena *a) {
+  for (size_t i = 0; i < ARENA_SIZE_CLASSES; i++) {
+    assert_null(a->free_lists[i]);
+  }
+}
+
+void do_test_arena_free_sized() {
+  arena *a = new_test_arena(0);
+  uint8_t *chunk, *next;
+
+  // Each chunk is followed by a one byte allocation so that it isn't the
+  // newest one when it's freed.
+  chunk = arena_alloc(a, 64);
+  arena_alloc(a, 1);
+  arena_free_sized(a, chunk, 64);
+  next = a->next;
+  assert_ptr_equal(chunk, arena_alloc(a, 50));
+  assert_ptr_equal(next, a->next);
+  assert_no_free_chunks(a);
+
+  // too small to be linked into a list
+  chunk = arena_alloc(a, ARENA_SIZE_CLASS - 1);
+  arena_alloc(a, 1);
+  arena_free_sized(a, chunk, ARENA_SIZE_CLASS - 1);
+  assert_no_free_chunks(a);
+
+  // misaligned chunks can't hold a link, so they're left alone, even for
+  // allocations that wouldn't mind
+  chunk = arena_alloc_aligned(a, 32, 1);
+  arena_alloc(a, 1);
+  assert_true((uintptr_t) chunk % alignof (max_align_t));
+  arena_free_sized(a, chunk, 32);
+  assert_fly_status(FLY_OK);
+  assert_no_free_chunks(a);
+  assert_ptr_not_equal(chunk, arena_alloc_aligned(a, 32, 1));
+  assert_ptr_not_equal(chunk, arena_alloc(a, 32));
+
+  // anything past the last class serves the last class
+  chunk = arena_alloc(a, 1000);
+  arena_alloc(a, 1);
+  arena_free_sized(a, chunk, 1000);
+  assert_ptr_not_equal(chunk, arena_alloc(a, 257));
+  assert_ptr_equal(chunk, arena_alloc(a, 256));
+
+  chunk = arena_alloc(a, 64);
+  arena_alloc(a, 1);
+  arena_free_sized(a, chunk, 64);
+  arena_push(a);
+  arena_pop(a);
+  assert_no_free_chunks(a);
+
+  arena_free_sized(a, chunk, 64);
+  arena_clear(a);
+  assert_no_free_chunks(a);
+
+  arena_del(a);
+}
+
+void do_test_arena_free_large() {
+  arena *a = new_test_arena(ARENA_MINIMUM_SIZE);
+  void *outer, *inner;
+
+  // the record goes too, so the arena is as it was
+  outer = arena_alloc(a, 2 * ARENA_MINIMUM_SIZE);
+  assert_int_equal(1, count_large_allocs(a));
+  arena_free(a, outer);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(0, count_large_allocs(a));
+  assert_ptr_equal(a->block->data, a->next);
+
+  outer = arena_alloc(a, 2 * ARENA_MINIMUM_SIZE);
+  arena_push(a);
+  inner = arena_alloc(a, 2 * ARENA_MINIMUM_SIZE);
+  assert_int_equal(2, count_large_allocs(a));
+
+  // The frame remembers the outer record, so it stays, but empty. The inner
+  // one is newer than the frame and can go.
+  arena_free(a, outer);
+  assert_int_equal(2, count_large_allocs(a));
+  assert_null(a->large->prev->data);
+  arena_free(a, inner);
+  assert_int_equal(1, count_large_allocs(a));
+
+  arena_pop(a);
+  assert_int_equal(1, count_large_allocs(a));
+
+  arena_del(a);
+}
+
+void do_test_arena_alloc_large_oom() {
+  arena *a = new_test_arena(ARENA_MINIMUM_SIZE);
+
+  mockmem_queue(NULL);
+  assert_null(arena_alloc(a, 2 * ARENA_MINIMUM_SIZE));
+  assert_null(mockmem_peek());
+  assert_fly_status(FLY_E_OUT_OF_MEMORY);
+  assert_int_equal(0, count_large_allocs(a));
+  assert_ptr_equal(a->block->data, a->next);
+
+  arena_del(a);
+}
+
+void fill_arena_bytes(uint8_t *data, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    data[i] = (uint8_t) (i * 7 + 1);
+  }
+}
+
+void assert_arena_bytes(uint8_t *data, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    assert_int_equal((uint8_t) (i * 7 + 1), data[i]);
+  }
+}
+
+void do_test_arena_realloc() {
+  arena *a = new_test_arena(ARENA_MINIMUM_SIZE);
+  uint8_t *buf, *grown, *other;
+
+  assert_non_null(buf = arena_realloc(a, NULL, 0, 16));
+  assert_ptr_equal(a->block->data, buf);
+  fill_arena_bytes(buf, 16);
+
+  // the newest allocation grows and shrinks where it is
+  fly_status = FLY_E_TOO_BIG;
+  assert_ptr_equal(buf, arena_realloc(a, buf, 16, 100));
+  assert_fly_status(FLY_OK);
+  assert_ptr_equal(buf + 100, a->next);
+  assert_ptr_equal(buf, arena_realloc(a, buf, 100, 40));
+  assert_ptr_equal(buf + 40, a->next);
+
+  // once something else is newer, growing copies and recycles the old one
+  other = arena_alloc(a, 8);
+  assert_non_null(grown = arena_realloc(a, buf, 40, 64));
+  assert_ptr_not_equal(buf, grown);
+  assert_arena_bytes(grown, 16);
+  assert_ptr_equal(buf, a->free_lists[40 / ARENA_SIZE_CLASS - 1]);
+
+  // but shrinking doesn't need to
+  assert_ptr_equal(other, arena_realloc(a, other, 8, 4));
+
+  // Growing past the end of the block moves it into a large allocation,
+  // which can then be resized by realloc().
+  buf = grown;
+  assert_non_null(grown = arena_realloc(a, buf, 64, ARENA_MINIMUM_SIZE));
+  assert_int_equal(1, count_large_allocs(a));
+  assert_ptr_equal(a->large->data, grown);
+  assert_arena_bytes(grown, 16);
+
+  assert_non_null(grown = arena_realloc(
+        a, grown, ARENA_MINIMUM_SIZE, 4 * ARENA_MINIMUM_SIZE));
+  assert_int_equal(1, count_large_allocs(a));
+  assert_ptr_equal(a->large->data, grown);
+  assert_arena_bytes(grown, 16);
+
+  // realloc() doesn't know about alignments past max_align_t, but the arena
+  // keeps them anyway
+  buf = (uint8_t *) arena_alloc_aligned(a, 2 * ARENA_MINIMUM_SIZE, 4096);
+  assert_int_equal(0, (uintptr_t) buf % 4096);
+  fill_arena_bytes(buf, 2 * ARENA_MINIMUM_SIZE);
+
+  for (size_t size = 4 * ARENA_MINIMUM_SIZE; size < ARENA_DEFAULT_SIZE;
+       size *= 2) {
+    assert_non_null(buf = (uint8_t *) arena_realloc(a, buf, size / 2, size));
+    assert_int_equal(0, (uintptr_t) buf % 4096);
+    assert_arena_bytes(buf, 2 * ARENA_MINIMUM_SIZE);
+  }
+
+  assert_non_null(
+      buf = (uint8_t *) arena_realloc(a, buf, ARENA_DEFAULT_SIZE / 2, 100));
+  assert_int_equal(0, (uintptr_t) buf % 4096);
+  assert_arena_bytes(buf, 100);
+
+  arena_del(a);
+}
+
+size_t count_spare_blocks(struct arena_spares *spares) {
+  size_t ret = 0;
+
+  for (struct arena_block *ab = spares->blocks; ab; ab = ab->prev) {
+    ++ret;
+  }
+
+  return ret;
+}
+
+// Grows a minimum-sized arena into two more blocks inside a frame, pops it,
+// and returns how many bytes of blocks the frame went through. Filling each
+// block to the brim makes the next byte start a new block.
+size_t test_arena__grow_twice_in_frame(arena *a) {
+  arena_push(a);
+
+  for (int k = 0; k < 2; k++) {
+    assert_non_null(arena_alloc_aligned(a, a->end - a->next, 1));
+    assert_non_null(arena_alloc(a, 1));
+    assert_null(a->large);
+  }
+
+  assert_int_equal(3, count_arena_blocks(a));
+  arena_pop(a);
+  assert_int_equal(1, count_arena_blocks(a));
+
+  return 6 * ARENA_MINIMUM_SIZE;
+}
+
+void do_test_arena_spare_blocks() {
+  arena *a = new_test_arena(ARENA_MINIMUM_SIZE);
+  size_t used;
+
+  assert_int_equal(ARENA_DEFAULT_SPARE_LIMIT, a->spares.limit);
+
+  used = test_arena__grow_twice_in_frame(a);
+  assert_int_equal(2, count_spare_blocks(&a->spares));
+  assert_int_equal(used, a->spares.size);
+
+  // the second time round, malloc isn't called at all
+  mockmem_queue(NULL);
+  test_arena__grow_twice_in_frame(a);
+  assert_non_null(mockmem_peek());
+  assert_null(malloc(1));
+  assert_int_equal(used, a->spares.size);
+
+  // Lowering the limit frees what no longer fits, and a block that would
+  // go over it is freed instead of kept.
+  arena_set_spare_limit(a, 2 * ARENA_MINIMUM_SIZE);
+  assert_int_equal(1, count_spare_blocks(&a->spares));
+  assert_int_equal(2 * ARENA_MINIMUM_SIZE, a->spares.size);
+
+  test_arena__grow_twice_in_frame(a);
+  assert_int_equal(1, count_spare_blocks(&a->spares));
+
+  arena_set_spare_limit(a, 0);
+  assert_null(a->spares.blocks);
+  assert_int_equal(0, a->spares.size);
+
+  arena_del(a);
+}
+
+void do_test_arena_global_spare_blocks() {
+  arena *a = new_test_arena(ARENA_MINIMUM_SIZE);
+  size_t used = test_arena__grow_twice_in_frame(a);
+
+  arena_set_global_spare_limit(used);
+  arena_del(a);
+
+  // the next arena picks up where the last one left off
+  a = new_test_arena(ARENA_MINIMUM_SIZE);
+  mockmem_queue(NULL);
+  test_arena__grow_twice_in_frame(a);
+  assert_non_null(mockmem_peek());
+  assert_null(malloc(1));
+  arena_del(a);
+
+  arena_set_global_spare_limit(0);
+}
+
+#ifndef __STDC_NO_THREADS__
+static int get_arena_local(void *arg) {
+  arena *a = arena_local();
+
+  *(arena **) arg = a;
+
+  // left for the thread's exit to clean up
+  return a && arena_alloc(a, 2 * ARENA_DEFAULT_SIZE) ? 0 : 1;
+}
+#endif
+
+void do_test_arena_local() {
+  arena *a = arena_local();
+
+  assert_non_null(a);
+  assert_fly_status(FLY_OK);
+  assert_ptr_equal(a, arena_local());
+
+  arena_push(a);
+  assert_non_null(arena_alloc(a, 100));
+  arena_pop(a);
+  assert_ptr_equal(a->block->data, a->next);
+
+#ifndef __STDC_NO_THREADS__
+  thrd_t thread;
+  arena *other = NULL;
+  int result = -1;
+
+  assert_int_equal(
+      thrd_success, thrd_create(&thread, &get_arena_local, &other));
+  assert_int_equal(thrd_success, thrd_join(thread, &result));
+  assert_int_equal(0, result);
+  assert_non_null(other);
+  assert_ptr_not_equal(a, other);
+#endif
+
+  arena_local_del();
+  arena_local_del();
+  assert_non_null(a = arena_local());
+  arena_local_del();
+}
+
+#ifdef ARENA_HAS_SHARED
+#define ARENA_SHARED_THREADS 4
+#define ARENA_SHARED_ALLOCS 5000
+
+struct arena_shared_worker {
+  arena_shared *a;
+  uint8_t id;
+  uint8_t *allocs[ARENA_SHARED_ALLOCS];
+};
+
+static size_t arena_shared_test_size(size_t k) {
+  // mostly small, with the odd one big enough for a block of its own
+  return k % 997 == 0 ? ARENA_MINIMUM_SIZE : k % 61 + 1;
+}
+
+static int fill_arena_shared(void *arg) {
+  struct arena_shared_worker *worker = (struct arena_shared_worker *) arg;
+  uint8_t *data;
+
+  for (size_t k = 0; k < ARENA_SHARED_ALLOCS; k++) {
+    size_t size = arena_shared_test_size(k);
+
+    if (!(data = arena_shared_alloc(worker->a, size))) {
+      return 1;
+    }
+
+    memset(data, worker->id, size);
+    worker->allocs[k] = data;
+  }
+
+  return 0;
+}
+
+void do_test_arena_shared() {
+  arena_shared *a = arena_shared_new(ARENA_MINIMUM_SIZE);
+  struct arena_shared_worker *workers =
+    calloc(ARENA_SHARED_THREADS, sizeof (struct arena_shared_worker));
+  thrd_t threads[ARENA_SHARED_THREADS];
+  uint8_t *data;
+  int result;
+
+  assert_non_null(a);
+  assert_fly_status(FLY_OK);
+
+  data = arena_shared_alloc_aligned(a, 3, 64);
+  assert_non_null(data);
+  assert_int_equal(0, (uintptr_t) data % 64);
+  assert_int_equal(0, (uintptr_t) arena_shared_alloc(a, 1) % ARENA_SIZE_CLASS);
+
+  // volatile, or the compiler rejects the size before the arena can
+  volatile size_t too_big = SIZE_MAX - 1;
+  assert_null(arena_shared_alloc(a, too_big));
+  assert_fly_status(FLY_E_TOO_BIG);
+
+  for (size_t i = 0; i < ARENA_SHARED_THREADS; i++) {
+    workers[i].a = a;
+    workers[i].id = (uint8_t) (i + 1);
+    assert_int_equal(thrd_success,
+        thrd_create(threads + i, &fill_arena_shared, workers + i));
+  }
+
+  for (size_t i = 0; i < ARENA_SHARED_THREADS; i++) {
+    assert_int_equal(thrd_success, thrd_join(threads[i], &result));
+    assert_int_equal(0, result);
+  }
+
+  // Every byte still holds what its own thread wrote, so no two allocations
+  // overlapped.
+  for (size_t i = 0; i < ARENA_SHARED_THREADS; i++) {
+    for (size_t k = 0; k < ARENA_SHARED_ALLOCS; k++) {
+      data = workers[i].allocs[k];
+
+      assert_int_equal(0, (uintptr_t) data % ARENA_SIZE_CLASS);
+
+      for (size_t j = 0; j < arena_shared_test_size(k); j++) {
+        assert_int_equal(workers[i].id, data[j]);
+      }
+    }
+  }
+
+  struct arena_shared_block *block = atomic_load(&a->block);
+
+  assert_non_null(block->prev);
+  arena_shared_clear(a);
+  assert_fly_status(FLY_OK);
+  assert_ptr_equal(block, atomic_load(&a->block));
+  assert_null(block->prev);
+  assert_ptr_equal(block->data, arena_shared_alloc(a, 1));
+
+  free(workers);
+  arena_shared_del(a);
+}
+#undef ARENA_SHARED_THREADS
+#undef ARENA_SHARED_ALLOCS
+#else
+void do_test_arena_shared() {
+}
+#endif
+
+void do_test_arena_vec() {
+  arena *a = new_test_arena(0);
+  arena_vec v, w;
+  uint32_t more[] = { 7, 8, 9 };
+  void *items;
+
+  arena_vec_init_type(&v, a, uint32_t);
+  assert_null(v.items);
+  assert_int_equal(0, v.capacity);
+
+  // nothing else is allocated, so it only ever grows in place
+  *arena_vec_push_type(&v, uint32_t) = 0;
+  items = v.items;
+  assert_int_equal(ARENA_VEC_MIN_CAPACITY, v.capacity);
+
+  for (uint32_t k = 1; k < 1024; k++) {
+    *arena_vec_push_type(&v, uint32_t) = k;
+    assert_fly_status(FLY_OK);
+  }
+  assert_ptr_equal(items, v.items);
+  assert_int_equal(1024, v.size);
+  assert_int_equal(1024, v.capacity);
+
+  // until something else is
+  arena_alloc(a, 1);
+  assert_non_null(arena_vec_push_array(&v, 3, more));
+  assert_ptr_not_equal(items, v.items);
+  assert_int_equal(2048, v.capacity);
+
+  for (uint32_t k = 0; k < 1024; k++) {
+    assert_int_equal(k, arena_vec_at(&v, uint32_t, k));
+  }
+  assert_int_equal(9, arena_vec_at(&v, uint32_t, 1026));
+
+  assert_false(arena_vec_reserve(&v, SIZE_MAX / 2));
+  assert_fly_status(FLY_E_TOO_BIG);
+  assert_null(arena_vec_push_array(&v, SIZE_MAX, NULL));
+  assert_fly_status(FLY_E_TOO_BIG);
+  assert_int_equal(1027, v.size);
+  assert_int_equal(2048, v.capacity);
+
+  // moving keeps the alignment, even past max_align_t
+  uint8_t *top = a->next;
+  arena_push(a);
+
+  arena_vec_init(&w, a, 8, 64);
+  for (uintptr_t k = 0; k < 100; k++) {
+    *(uintptr_t *) arena_vec_push(&w) = k;
+    assert_int_equal(0, (uintptr_t) w.items % 64);
+    arena_alloc(a, 1);
+  }
+
+  for (uintptr_t k = 0; k < 100; k++) {
+    assert_int_equal(k, arena_vec_at(&w, uintptr_t, k));
+  }
+
+  arena_pop(a);
+  assert_ptr_equal(top, a->next);
+
+  // and once it's too big for the block
+  arena_vec_init(&w, a, 32, 256);
+  for (uintptr_t k = 0; k < 3000; k++) {
+    *(uintptr_t *) arena_vec_push(&w) = k;
+    assert_int_equal(0, (uintptr_t) w.items % 256);
+  }
+  assert_true(w.capacity * 32 > ARENA_DEFAULT_SIZE);
+  assert_ptr_equal(a->large->data, w.items);
+
+  for (uintptr_t k = 0; k < 3000; k++) {
+    assert_int_equal(k, *(uintptr_t *) ((uint8_t *) w.items + 32 * k));
+  }
+
+  arena_del(a);
+}
+
+static char arena_deferred_calls[16];
+static size_t arena_deferred_count;
+
+static void record_arena_deferred(void *arg) {
+  arena_deferred_calls[arena_deferred_count++] = (char) (uintptr_t) arg;
+  arena_deferred_calls[arena_deferred_count] = '\0';
+}
+
+static void check_arena_deferred_arg(void *arg) {
+  assert_int_equal(0xC105ED, *(uint32_t *) arg);
+  record_arena_deferred((void *) 'x');
+}
+
+#define DEFER_CALL(a, c) \
+  arena_defer((a), &record_arena_deferred, (void *) (uintptr_t) (c))
+
+#ifdef ARENA_HAS_SCOPE_CLEANUP
+static void *alloc_in_arena_scope(arena *a) {
+  ARENA_SCOPE(a) {
+    DEFER_CALL(a, 'r');
+    return arena_alloc(a, 100);
+  }
+  return NULL;
+}
+#endif
+
+void do_test_arena_defer() {
+  arena *a = new_test_arena(0);
+  uint32_t *arg;
+  uint8_t *top;
+
+  arena_deferred_count = 0;
+  arena_deferred_calls[0] = '\0';
+
+  DEFER_CALL(a, 'a');
+  arena_push(a);
+  DEFER_CALL(a, 'b');
+  DEFER_CALL(a, 'c');
+  arena_push(a);
+  DEFER_CALL(a, 'd');
+  assert_fly_status(FLY_OK);
+
+  arena_pop(a);
+  assert_string_equal("d", arena_deferred_calls);
+
+  // b and c now go with the arena's base, after a later frame's e
+  arena_commit(a);
+  arena_push(a);
+  DEFER_CALL(a, 'e');
+  arena_pop(a);
+  assert_string_equal("de", arena_deferred_calls);
+
+  arena_pop(a);
+  assert_fly_status(FLY_EMPTY);
+  assert_string_equal("de", arena_deferred_calls);
+
+  arena_clear(a);
+  assert_string_equal("decba", arena_deferred_calls);
+  assert_null(a->deferred);
+
+  // calls come before the frame's memory goes
+  top = a->next;
+  ARENA_SCOPE(a) {
+    arg = arena_alloc_type(a, uint32_t);
+    *arg = 0xC105ED;
+    arena_defer(a, &check_arena_deferred_arg, arg);
+    DEFER_CALL(a, 'f');
+    assert_int_equal(1, count_arena_frames(a));
+  }
+  assert_ptr_equal(top, a->next);
+  assert_int_equal(0, count_arena_frames(a));
+  assert_string_equal("decbafx", arena_deferred_calls);
+
+  DEFER_CALL(a, 'g');
+  arena_del(a);
+  assert_string_equal("decbafxg", arena_deferred_calls);
+
+#ifdef ARENA_HAS_SCOPE_CLEANUP
+  // leaving a scope early pops its frame all the same
+  a = new_test_arena(0);
+  arena_deferred_count = 0;
+  top = a->next;
+
+  ARENA_SCOPE(a) {
+    DEFER_CALL(a, 'b');
+    arena_alloc(a, 100);
+    break;
+  }
+  assert_ptr_equal(top, a->next);
+  assert_int_equal(0, count_arena_frames(a));
+  assert_string_equal("b", arena_deferred_calls);
+
+  assert_non_null(alloc_in_arena_scope(a));
+  assert_ptr_equal(top, a->next);
+  assert_int_equal(0, count_arena_frames(a));
+  assert_string_equal("br", arena_deferred_calls);
+
+  arena_del(a);
+#endif
+}
+#undef DEFER_CALL
+
+void do_test_arena_stats() {
+  arena *a = new_test_arena(0);
+  struct arena_stats s;
+  uint8_t *p;
+  size_t used;
+
+  fly_status = FLY_E_NULL_PTR;
+  arena_stats(a, &s);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(0, s.used);
+  assert_int_equal(ARENA_DEFAULT_SIZE, s.reserved);
+  assert_int_equal(1, s.blocks);
+  assert_int_equal(0, s.large_allocs);
+  assert_int_equal(0, s.frames);
+
+  arena_alloc(a, 100);
+  p = (uint8_t *) arena_alloc_aligned(a, 1, 64);
+  used = p + 1 - a->block->data;
+  arena_stats(a, &s);
+  assert_int_equal(used, s.used);
+#ifdef ARENA_STATS
+  assert_int_equal(p - (a->block->data + 100), s.padding);
+  assert_int_equal(used, s.peak);
+#endif
+
+  arena_push(a);
+  arena_alloc(a, 2 * ARENA_DEFAULT_SIZE);
+  arena_stats(a, &s);
+  assert_int_equal(1, s.frames);
+  assert_int_equal(1, s.large_allocs);
+#ifdef ARENA_STATS
+  assert_int_equal(2 * ARENA_DEFAULT_SIZE, s.large_bytes);
+  assert_int_equal(3 * ARENA_DEFAULT_SIZE, s.reserved);
+  assert_true(s.used > 2 * ARENA_DEFAULT_SIZE);
+#endif
+
+  // popping gives back the used bytes, but not the peak
+  arena_pop(a);
+  arena_stats(a, &s);
+  assert_int_equal(0, s.frames);
+  assert_int_equal(0, s.large_allocs);
+  assert_int_equal(used, s.used);
+#ifdef ARENA_STATS
+  assert_true(s.peak > 2 * ARENA_DEFAULT_SIZE);
+#endif
+
+  // what's left of a block counts as used once the arena moves on
+  arena_alloc_aligned(a, a->end - a->next, 1);
+  arena_alloc(a, 1);
+  arena_stats(a, &s);
+  assert_int_equal(2, s.blocks);
+  assert_int_equal(ARENA_DEFAULT_SIZE + 1, s.used);
+  assert_int_equal(3 * ARENA_DEFAULT_SIZE, s.reserved);
+
+  // and a cleared arena's spare blocks are still reserved
+  arena_clear(a);
+  arena_stats(a, &s);
+  assert_int_equal(1, s.blocks);
+  assert_int_equal(0, s.used);
+  assert_int_equal(3 * ARENA_DEFAULT_SIZE, s.reserved);
+
+  arena_del(a);
+}
+
+#ifdef ARENA_HAS_MMAP
+void do_test_arena_mapped() {
+  const size_t mb = 1024 * 1024;
+  arena *a = arena_new_mapped(64 * mb);
+  uint8_t *p, *q;
+
+  assert_non_null(a);
+  assert_fly_status(FLY_OK);
+  assert_true((size_t) (a->reserved - (uint8_t *) a) >= 64 * mb);
+  assert_true(a->end - a->block->data < 2 * ARENA_DEFAULT_SIZE);
+
+  // the block commits pages as it goes, instead of growing
+  p = (uint8_t *) arena_alloc(a, 10 * mb);
+  assert_non_null(p);
+  assert_ptr_equal(a->block->data, p);
+  memset(p, 1, 10 * mb);
+  assert_true(a->end <= p + 10 * mb + ARENA_HUGE_PAGE_SIZE);
+  assert_int_equal(1, count_arena_blocks(a));
+  assert_int_equal(0, count_large_allocs(a));
+
+  arena_push(a);
+  q = (uint8_t *) arena_alloc(a, 20 * mb);
+  assert_non_null(q);
+  memset(q, 2, 20 * mb);
+  assert_true(a->end >= q + 20 * mb);
+
+  // and hands back all but a block's worth above the top on pop
+  arena_pop(a);
+  assert_true(a->end - a->next < 2 * ARENA_DEFAULT_SIZE);
+  assert_int_equal(1, p[10 * mb - 1]);
+
+  q = (uint8_t *) arena_alloc(a, 20 * mb);
+  assert_non_null(q);
+  memset(q, 3, 20 * mb);
+
+  // past the reservation, it grows like any other arena
+  assert_non_null(arena_alloc(a, 40 * mb));
+  assert_int_equal(1, count_arena_blocks(a));
+  assert_int_equal(1, count_large_allocs(a));
+
+  arena_clear(a);
+  assert_int_equal(0, count_large_allocs(a));
+  assert_true(a->end - a->block->data < 2 * ARENA_DEFAULT_SIZE);
+
+  arena_del(a);
+
+  a = new_test_arena(0);
+  assert_null(a->reserved);
+  arena_del(a);
+}
+#else
+void do_test_arena_mapped() {
+}
+#endif
 #endif
 
 TESTCALL(test_arena_new_default, do_test_arena_new(0))
@@ -513,6 +1255,20 @@ TESTCALL(test_arena_push_and_pop_large_init,
 TESTCALL(test_arena_push_then_grow_and_pop,
          do_test_arena_push_then_grow_and_pop())
 
+TESTCALL(test_arena_free_top, do_test_arena_free_top())
+TESTCALL(test_arena_free_sized, do_test_arena_free_sized())
+TESTCALL(test_arena_free_large, do_test_arena_free_large())
+TESTCALL(test_arena_alloc_large_oom, do_test_arena_alloc_large_oom())
+TESTCALL(test_arena_realloc, do_test_arena_realloc())
+TESTCALL(test_arena_spare_blocks, do_test_arena_spare_blocks())
+TESTCALL(test_arena_global_spare_blocks, do_test_arena_global_spare_blocks())
+TESTCALL(test_arena_local, do_test_arena_local())
+TESTCALL(test_arena_shared, do_test_arena_shared())
+TESTCALL(test_arena_mapped, do_test_arena_mapped())
+TESTCALL(test_arena_stats, do_test_arena_stats())
+TESTCALL(test_arena_vec, do_test_arena_vec())
+TESTCALL(test_arena_defer, do_test_arena_defer())
+
 #ifndef _WINDLL
 #ifndef METHODS_ONLY
 #define METHODS_ONLY
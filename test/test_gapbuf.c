@@ -0,0 +1,287 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "tests.h"
+
+#include "gapbuf.h"
+
+#if !defined(_WINDLL) && !defined(METHODS_ONLY)
+int gapbuf_setup(void **state) {
+  (void) state;
+
+  return 0;
+}
+
+int gapbuf_teardown(void **state) {
+  (void) state;
+
+  return 0;
+}
+#endif
+
+#ifndef METHODS_ONLY
+gapbuf *new_test_gapbuf() {
+  gapbuf *l = (gapbuf *) list_new_kind(LISTKIND_GAP);
+
+  assert_non_null(l);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(0, l->size);
+  assert_int_equal(0, l->gap);
+
+  return l;
+}
+
+void assert_gapbuf_items(gapbuf *l, uintptr_t *expected, size_t n) {
+  assert_int_equal(n, l->size);
+
+  for (size_t k = 0; k < n; k++) {
+    assert_int_equal(expected[k], (uintptr_t) list_get((list *) l, k));
+  }
+}
+
+static int comp_gapbuf_descending(const void *lp, const void *rp) {
+  uintptr_t left = *(uintptr_t *) lp;
+  uintptr_t right = *(uintptr_t *) rp;
+
+  return (left < right) - (left > right);
+}
+
+static int is_gapbuf_even(void *data) {
+  return !((uintptr_t) data % 2);
+}
+
+// Types "abcdef", backs up over two characters, moves the cursor and types
+// some more, the way an editor would.
+void do_test_gapbuf_editing() {
+  gapbuf *l = new_test_gapbuf();
+  list *as_list = (list *) l;
+
+  for (uintptr_t c = 'a'; c <= 'f'; c++) {
+    list_insert(as_list, l->size, (void *) c);
+  }
+  assert_int_equal(6, l->gap);
+
+  assert_int_equal('f', (uintptr_t) list_remove_at(as_list, 5));
+  assert_int_equal('e', (uintptr_t) list_remove_at(as_list, 4));
+  assert_int_equal(4, l->gap);
+
+  list_insert(as_list, 1, (void *) 'x');
+  list_insert(as_list, 2, (void *) 'y');
+  assert_int_equal(3, l->gap);
+
+  // deleting forwards from the cursor leaves the gap where it is
+  assert_int_equal('b', (uintptr_t) list_remove_at(as_list, 3));
+  assert_int_equal(3, l->gap);
+
+  uintptr_t expected[] = { 'a', 'x', 'y', 'c', 'd' };
+  assert_gapbuf_items(l, expected, 5);
+  assert_int_equal('d', (uintptr_t) list_get(as_list, -1));
+
+  list_del(as_list);
+}
+
+void do_test_gapbuf_model() {
+  const size_t len = 1000;
+  uintptr_t model[1000];
+  size_t size = 0, cursor = 0, i;
+  gapbuf *l = new_test_gapbuf();
+
+  // Edits cluster around a cursor that occasionally jumps, so the buffer
+  // grows while the gap is in the middle.
+  for (uintptr_t k = 1; k <= len; k++) {
+    if (k % 50 == 0) {
+      cursor = (k * 7919) % (size + 1);
+    }
+
+    if (k % 4 == 3 && cursor) {
+      i = --cursor;
+      assert_int_equal(model[i], (uintptr_t) list_remove_at((list *) l, i));
+      memmove(model + i, model + i + 1, (--size - i) * sizeof (uintptr_t));
+    } else {
+      i = cursor++;
+      list_insert((list *) l, i, (void *) k);
+      assert_fly_status(FLY_OK);
+      memmove(model + i + 1, model + i, (size++ - i) * sizeof (uintptr_t));
+      model[i] = k;
+    }
+
+    assert_int_equal(cursor, l->gap);
+  }
+
+  assert_gapbuf_items(l, model, size);
+
+  list_push((list *) l, (void *) 2000);
+  list_unshift((list *) l, (void *) 2001);
+  assert_int_equal(2000, (uintptr_t) list_pop((list *) l));
+  assert_int_equal(2001, (uintptr_t) list_shift((list *) l));
+  assert_gapbuf_items(l, model, size);
+
+  list_del((list *) l);
+}
+
+void do_test_gapbuf_list_api() {
+  gapbuf *l = new_test_gapbuf();
+  list *as_list = (list *) l;
+  void *out[10];
+  void *more[] = { (void *) 11, (void *) 12 };
+
+  for (uintptr_t k = 1; k <= 10; k++) {
+    list_push(as_list, (void *) k);
+  }
+
+  // Everything below starts with the gap in the middle.
+  list_insert(as_list, 5, (void *) 13);
+  assert_int_equal(13, (uintptr_t) list_remove_at(as_list, 5));
+  assert_int_equal(5, l->gap);
+
+  assert_int_equal(4, list_index_of(as_list, (void *) 5));
+  assert_int_equal(1, list_count_of(as_list, (void *) 7));
+  assert_int_equal(10, l->gap);
+
+  list_insert(as_list, 3, (void *) 4);
+  assert_int_equal(6, list_discard_all(as_list, &is_gapbuf_even, NULL));
+  assert_int_equal(5, l->size);
+
+  uintptr_t odd[] = { 1, 3, 5, 7, 9 };
+  assert_gapbuf_items(l, odd, 5);
+
+  list_insert(as_list, 2, (void *) 2);
+  list_sort(as_list, &comp_gapbuf_descending);
+  uintptr_t sorted[] = { 9, 7, 5, 3, 2, 1 };
+  assert_gapbuf_items(l, sorted, 6);
+
+  list_insert(as_list, 1, (void *) 8);
+  list_append_array(as_list, 2, more);
+  uintptr_t appended[] = { 9, 8, 7, 5, 3, 2, 1, 11, 12 };
+  assert_gapbuf_items(l, appended, 9);
+
+  list_insert(as_list, 4, (void *) 4);
+  assert_int_equal(3, list_shift_many(as_list, 3, out));
+  assert_int_equal(2, list_pop_many(as_list, 2, out + 3));
+  uintptr_t trimmed[] = { 5, 4, 3, 2, 1 };
+  assert_gapbuf_items(l, trimmed, 5);
+
+  list_insert(as_list, 2, (void *) 6);
+  list_unshift_array(as_list, 5, out);
+  uintptr_t restored[] = { 9, 8, 7, 11, 12, 5, 4, 6, 3, 2, 1 };
+  assert_gapbuf_items(l, restored, 11);
+
+  gapbuf *other = new_test_gapbuf();
+  list_push((list *) other, (void *) 20);
+  list_push((list *) other, (void *) 22);
+  list_insert((list *) other, 1, (void *) 21);
+  list_insert(as_list, 0, (void *) 10);
+  list_concat(as_list, (list *) other);
+  assert_int_equal(15, l->size);
+  assert_int_equal(10, (uintptr_t) list_get(as_list, 0));
+  assert_int_equal(20, (uintptr_t) list_get(as_list, -3));
+  assert_int_equal(21, (uintptr_t) list_get(as_list, -2));
+  assert_int_equal(22, (uintptr_t) list_get(as_list, -1));
+  assert_int_equal(3, other->size);
+
+  list_del((list *) other);
+  list_del(as_list);
+}
+
+void do_test_gapbuf_ranges() {
+  gapbuf *l = new_test_gapbuf(), *other = new_test_gapbuf();
+  list *as_list = (list *) l, *slice;
+
+  for (uintptr_t k = 1; k <= 8; k++) {
+    list_push(as_list, (void *) k);
+    list_push((list *) other, (void *) (k + 10));
+  }
+
+  // a slice across the gap leaves the gap where it was
+  list_insert(as_list, 4, (void *) 9);
+  assert_int_equal(5, l->gap);
+  slice = list_slice(as_list, 2, 7);
+  assert_non_null(slice);
+  assert_int_equal(5, l->gap);
+
+  uintptr_t sliced[] = { 3, 4, 9, 5, 6 };
+  assert_gapbuf_items((gapbuf *) slice, sliced, 5);
+  list_del(slice);
+
+  // the splice leaves both gaps at the edit
+  list_insert((list *) other, 6, (void *) 19);
+  list_splice(as_list, 1, (list *) other, 2, 5);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(4, l->gap);
+  assert_int_equal(2, other->gap);
+
+  uintptr_t spliced[] = { 1, 13, 14, 15, 2, 3, 4, 9, 5, 6, 7, 8 };
+  assert_gapbuf_items(l, spliced, 12);
+
+  uintptr_t rest[] = { 11, 12, 16, 19, 17, 18 };
+  assert_gapbuf_items(other, rest, 6);
+
+  list_rotate(as_list, 3);
+  list_reverse(as_list);
+  uintptr_t turned[] = { 14, 13, 1, 8, 7, 6, 5, 9, 4, 3, 2, 15 };
+  assert_gapbuf_items(l, turned, 12);
+
+  list_del((list *) other);
+  list_del(as_list);
+}
+
+void do_test_gapbuf_iter() {
+  gapbuf *l = new_test_gapbuf();
+  list_iter it;
+  void *item;
+  uintptr_t n = 0;
+
+  it = list_iter_of((list *) l);
+  assert_false(list_iter_has_next(&it));
+
+  for (uintptr_t k = 1; k <= 9; k++) {
+    list_push((list *) l, (void *) k);
+  }
+
+  // the cursor steps over the gap without closing it
+  list_insert((list *) l, 4, (void *) 10);
+  assert_int_equal(5, l->gap);
+
+  uintptr_t expected[] = { 1, 2, 3, 4, 10, 5, 6, 7, 8, 9 };
+  LIST_FOR_EACH(l, item) {
+    assert_int_equal(expected[n++], (uintptr_t) item);
+  }
+  assert_int_equal(10, n);
+  assert_int_equal(5, l->gap);
+
+  // and with the gap at the front, the only run is the one after it
+  list_insert((list *) l, 0, (void *) 11);
+  list_remove_at((list *) l, 0);
+  assert_int_equal(0, l->gap);
+
+  it = list_iter_of((list *) l);
+  for (n = 0; list_iter_has_next(&it); n++) {
+    assert_int_equal(expected[n], (uintptr_t) list_iter_next(&it));
+  }
+  assert_int_equal(10, n);
+
+  list_del((list *) l);
+}
+#endif
+
+TESTCALL(test_gapbuf_editing, do_test_gapbuf_editing())
+TESTCALL(test_gapbuf_model, do_test_gapbuf_model())
+TESTCALL(test_gapbuf_list_api, do_test_gapbuf_list_api())
+TESTCALL(test_gapbuf_ranges, do_test_gapbuf_ranges())
+TESTCALL(test_gapbuf_iter, do_test_gapbuf_iter())
+
+#ifndef _WINDLL
+#ifndef METHODS_ONLY
+#define METHODS_ONLY
+#undef TEST
+#define TEST(name, def) cmocka_unit_test(name),
+int main(void) {
+  const struct CMUnitTest tests[] = {
+#include "test_gapbuf.c"
+  };
+
+  return cmocka_run_group_tests_name(
+      "flytools gapbuf", tests, gapbuf_setup, gapbuf_teardown);
+}
+#endif  // METHODS_ONLY
+#endif
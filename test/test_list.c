@@ -2684,6 +2684,1636 @@ TESTCALL(test_dllist_sort_direct_descending,
 TESTCALL(test_sllist_sort_direct_descending,
     do_test_list_sort(LISTKIND_SLINK, (void *) &sllist_sort, &comp_descending))
 
+TESTCALL(test_arlist_sort_stable_ascending,
+    do_test_list_sort(LISTKIND_ARRAY, &list_sort_stable, NULL))
+TESTCALL(test_deque_sort_stable_ascending,
+    do_test_list_sort(LISTKIND_DEQUE, &list_sort_stable, NULL))
+TESTCALL(test_dllist_sort_stable_ascending,
+    do_test_list_sort(LISTKIND_DLINK, &list_sort_stable, NULL))
+TESTCALL(test_sllist_sort_stable_ascending,
+    do_test_list_sort(LISTKIND_SLINK, &list_sort_stable, NULL))
+
+TESTCALL(test_arlist_sort_stable_descending,
+    do_test_list_sort(LISTKIND_ARRAY, (void *) &arlist_sort_stable,
+        &comp_descending))
+TESTCALL(test_deque_sort_stable_descending,
+    do_test_list_sort(LISTKIND_DEQUE, (void *) &deque_sort_stable,
+        &comp_descending))
+TESTCALL(test_dllist_sort_stable_descending,
+    do_test_list_sort(LISTKIND_DLINK, &list_sort_stable, &comp_descending))
+TESTCALL(test_sllist_sort_stable_descending,
+    do_test_list_sort(LISTKIND_SLINK, &list_sort_stable, &comp_descending))
+
+#ifndef METHODS_ONLY
+#define STABLE_KEY_SHIFT 20
+
+int comp_stable_key(const void *lp, const void *rp) {
+  uintptr_t left = *(uintptr_t *) lp >> STABLE_KEY_SHIFT;
+  uintptr_t right = *(uintptr_t *) rp >> STABLE_KEY_SHIFT;
+
+  return (left > right) - (left < right);
+}
+
+void do_test_list_sort_stable_order(listkind *kind) {
+  size_t lens[] = { 2, 31, 32, 33, 100, 1000, 5003 };
+  size_t keys[] = { 1, 3, 50, 5003 };
+  uintptr_t data, prev, key, seq;
+
+  for (size_t i = 0; i < sizeof (lens) / sizeof (lens[0]); i++) {
+    for (size_t j = 0; j < sizeof (keys) / sizeof (keys[0]); j++) {
+      for (size_t descending = 0; descending <= 1; descending++) {
+        list *l = list_new_kind(kind);
+        assert_non_null(l);
+
+        if (kind == LISTKIND_DEQUE) {
+          // start near the end of the buffer so the items wrap around
+          list_push(l, NULL);
+          list_pop(l);
+          ((deque *) l)->start = ((deque *) l)->capacity - 3;
+          ((deque *) l)->end = ((deque *) l)->start;
+        }
+
+        // the low bits record the original position
+        for (seq = 0; seq < lens[i]; seq++) {
+          key = descending
+            ? (lens[i] - seq) / (lens[i] / keys[j] + 1)
+            : (seq * 7919) % keys[j];
+          list_push(l, (void *) (key << STABLE_KEY_SHIFT | seq));
+        }
+
+        fly_status = FLY_E_TOO_BIG;
+        list_sort_stable(l, &comp_stable_key);
+        assert_fly_status(FLY_OK);
+        assert_int_equal(lens[i], l->size);
+
+        prev = (uintptr_t) list_shift(l);
+
+        while (l->size) {
+          data = (uintptr_t) list_shift(l);
+          assert_true(prev >> STABLE_KEY_SHIFT <= data >> STABLE_KEY_SHIFT);
+
+          if (prev >> STABLE_KEY_SHIFT == data >> STABLE_KEY_SHIFT) {
+            assert_true(prev < data);
+          }
+
+          prev = data;
+        }
+
+        list_del(l);
+      }
+    }
+  }
+}
+
+#undef STABLE_KEY_SHIFT
+#endif
+
+TESTCALL(test_arlist_sort_stable_order,
+    do_test_list_sort_stable_order(LISTKIND_ARRAY))
+TESTCALL(test_deque_sort_stable_order,
+    do_test_list_sort_stable_order(LISTKIND_DEQUE))
+TESTCALL(test_dllist_sort_stable_order,
+    do_test_list_sort_stable_order(LISTKIND_DLINK))
+TESTCALL(test_sllist_sort_stable_order,
+    do_test_list_sort_stable_order(LISTKIND_SLINK))
+
+#ifndef METHODS_ONLY
+#define PARALLEL_SORT_LEN 200000
+
+int comp_descending_mod(const void *lp, const void *rp) {
+  uintptr_t left = *(uintptr_t *) lp % 1000;
+  uintptr_t right = *(uintptr_t *) rp % 1000;
+
+  return (left < right) - (left > right);
+}
+
+void fill_parallel_sort_list(list *l) {
+  for (uintptr_t k = 0; k < PARALLEL_SORT_LEN; k++) {
+    list_push(l, (void *) ((k * 7919) % PARALLEL_SORT_LEN + 1));
+  }
+  assert_int_equal(PARALLEL_SORT_LEN, l->size);
+}
+
+// list_get is linear on linked kinds and list_shift is linear on arlist
+void *next_parallel_sort_item(list *l, size_t i) {
+  return l->kind == LISTKIND_ARRAY ? list_get(l, i) : list_shift(l);
+}
+
+void do_test_list_sort_parallel(listkind *kind, size_t nthreads) {
+  uintptr_t k, data, prev = UINTPTR_MAX, sum = 0;
+
+  list *l = list_new_kind(kind);
+  assert_non_null(l);
+
+  fly_status = FLY_E_TOO_BIG;
+  list_sort_parallel(NULL, NULL, nthreads);
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  fly_status = FLY_E_TOO_BIG;
+  list_sort_parallel(l, NULL, nthreads);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(0, l->size);
+
+  if (kind == LISTKIND_DEQUE) {
+    // start partway in so the items wrap around the end of the buffer
+    list_push(l, NULL);
+    list_pop(l);
+    ((deque *) l)->start = ((deque *) l)->end = ((deque *) l)->capacity - 1;
+  }
+
+  fill_parallel_sort_list(l);
+
+  fly_status = FLY_E_TOO_BIG;
+  list_sort_parallel(l, NULL, nthreads);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(PARALLEL_SORT_LEN, l->size);
+
+  for (k = 1; k <= PARALLEL_SORT_LEN; k++) {
+    assert_int_equal(k, (uintptr_t) next_parallel_sort_item(l, k - 1));
+  }
+
+  while (l->size) {
+    list_pop(l);
+  }
+
+  // lots of equal keys
+  fill_parallel_sort_list(l);
+  list_sort_parallel(l, &comp_descending_mod, nthreads);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(PARALLEL_SORT_LEN, l->size);
+
+  for (k = 1; k <= PARALLEL_SORT_LEN; k++) {
+    data = (uintptr_t) next_parallel_sort_item(l, k - 1);
+    assert_true(prev == UINTPTR_MAX || prev % 1000 >= data % 1000);
+    prev = data;
+    sum += data;
+  }
+  assert_int_equal((uintptr_t) PARALLEL_SORT_LEN * (PARALLEL_SORT_LEN + 1) / 2,
+      sum);
+
+  list_del(l);
+}
+
+#undef PARALLEL_SORT_LEN
+#endif
+
+TESTCALL(test_arlist_sort_parallel_1,
+    do_test_list_sort_parallel(LISTKIND_ARRAY, 1))
+TESTCALL(test_arlist_sort_parallel_3,
+    do_test_list_sort_parallel(LISTKIND_ARRAY, 3))
+TESTCALL(test_arlist_sort_parallel_8,
+    do_test_list_sort_parallel(LISTKIND_ARRAY, 8))
+TESTCALL(test_deque_sort_parallel_4,
+    do_test_list_sort_parallel(LISTKIND_DEQUE, 4))
+TESTCALL(test_deque_sort_parallel_5,
+    do_test_list_sort_parallel(LISTKIND_DEQUE, 5))
+TESTCALL(test_dllist_sort_parallel,
+    do_test_list_sort_parallel(LISTKIND_DLINK, 4))
+TESTCALL(test_sllist_sort_parallel,
+    do_test_list_sort_parallel(LISTKIND_SLINK, 4))
+
+#ifndef METHODS_ONLY
+#define INTROSORT_NAME introsort_int
+#define INTROSORT_TYPE int
+#define INTROSORT_LESS(a, b) ((a) < (b))
+#include "introsort.h"
+
+#define INPUT_MODE_RANDOM 0
+#define INPUT_MODE_ASCENDING 1
+#define INPUT_MODE_DESCENDING 2
+#define INPUT_MODE_ORGAN_PIPE 3
+#define INPUT_MODE_FEW_KEYS 4
+#define INPUT_MODE_HIGH_BITS 5
+#define INPUT_MODE_COUNT 6
+
+uintptr_t make_large_sort_item(size_t mode, size_t k, size_t len) {
+  switch (mode) {
+    case INPUT_MODE_RANDOM:
+      return (k * 7919) % len + 1;
+    case INPUT_MODE_ASCENDING:
+      return k + 1;
+    case INPUT_MODE_DESCENDING:
+      return len - k;
+    case INPUT_MODE_ORGAN_PIPE:
+      return k < len / 2 ? k + 1 : len - k;
+    case INPUT_MODE_FEW_KEYS:
+      return k % 7 + 1;
+    default:
+      // only the top bytes differ, so the radix sort skips the low ones
+      return ((uintptr_t) (k * 7919) % len + 1)
+        << (sizeof (uintptr_t) * 8 - 16);
+  }
+}
+
+void do_test_introsort_template() {
+  int items[3000];
+
+  for (size_t mode = 0; mode < INPUT_MODE_COUNT; mode++) {
+    for (size_t len = 0; len <= 3000; len += len < 40 ? 1 : 997) {
+      for (size_t k = 0; k < len; k++) {
+        items[k] = (int) (make_large_sort_item(mode, k, len) % 100003) - 500;
+      }
+
+      introsort_int(items, len);
+
+      for (size_t k = 1; k < len; k++) {
+        assert_true(items[k - 1] <= items[k]);
+      }
+    }
+  }
+}
+
+void do_test_list_sort_large(
+    listkind *kind, int (*comp)(const void *, const void *)) {
+  uintptr_t data, prev, sum, sorted_sum;
+  size_t lens[] = { 17, 255, 256, 1000, 4099 };
+
+  for (size_t mode = 0; mode < INPUT_MODE_COUNT; mode++) {
+    for (size_t i = 0; i < sizeof (lens) / sizeof (lens[0]); i++) {
+      list *l = list_new_kind(kind);
+      assert_non_null(l);
+
+      sum = sorted_sum = 0;
+
+      for (size_t k = 0; k < lens[i]; k++) {
+        data = make_large_sort_item(mode, k, lens[i]);
+        sum += data;
+
+        // alternate ends so deque items wrap around the buffer
+        if (k % 2) {
+          list_unshift(l, (void *) data);
+        } else {
+          list_push(l, (void *) data);
+        }
+      }
+
+      fly_status = FLY_E_TOO_BIG;
+      list_sort(l, comp);
+      assert_fly_status(FLY_OK);
+      assert_int_equal(lens[i], l->size);
+
+      prev = (uintptr_t) list_get(l, 0);
+
+      for (size_t k = 0; k < lens[i]; k++) {
+        data = (uintptr_t) list_get(l, k);
+
+        if (comp) {
+          assert_true(prev >= data);
+        } else {
+          assert_true(prev <= data);
+        }
+
+        sorted_sum += data;
+        prev = data;
+      }
+
+      assert_int_equal(sum, sorted_sum);
+
+      list_del(l);
+    }
+  }
+}
+
+void do_test_introselect_template() {
+  int items[3000], sorted[3000];
+  size_t nths[4];
+
+  for (size_t mode = 0; mode < INPUT_MODE_COUNT; mode++) {
+    for (size_t len = 1; len <= 3000; len += len < 40 ? 1 : 997) {
+      nths[0] = 0;
+      nths[1] = len / 3;
+      nths[2] = len / 2;
+      nths[3] = len - 1;
+
+      for (size_t i = 0; i < 4; i++) {
+        for (size_t k = 0; k < len; k++) {
+          items[k] = sorted[k] =
+            (int) (make_large_sort_item(mode, k, len) % 100003) - 500;
+        }
+
+        introsort_int(sorted, len);
+        introsort_int_select(items, len, nths[i]);
+
+        assert_int_equal(sorted[nths[i]], items[nths[i]]);
+
+        for (size_t k = 0; k < len; k++) {
+          if (k < nths[i]) {
+            assert_true(items[k] <= items[nths[i]]);
+          } else {
+            assert_true(items[k] >= items[nths[i]]);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Fills l and a sorted arlist copy of it for checking selections against.
+list *fill_select_list(
+    list *l, size_t mode, size_t len,
+    int (*comp)(const void *, const void *)) {
+  list *sorted = list_new_kind(LISTKIND_ARRAY);
+  uintptr_t data;
+
+  assert_non_null(sorted);
+
+  for (size_t k = 0; k < len; k++) {
+    data = make_large_sort_item(mode, k, len);
+
+    // alternate ends so deque items wrap around the buffer
+    if (k % 2) {
+      list_unshift(l, (void *) data);
+    } else {
+      list_push(l, (void *) data);
+    }
+
+    list_push(sorted, (void *) data);
+  }
+
+  list_sort(sorted, comp);
+
+  return sorted;
+}
+
+int comp_ascending(const void *lp, const void *rp) {
+  uintptr_t left = *(uintptr_t *) lp;
+  uintptr_t right = *(uintptr_t *) rp;
+
+  return (left > right) - (left < right);
+}
+
+// Checks that l still holds the same items as sorted, that the first prefix
+// of them match it exactly and that the rest are on the right side of pivot.
+void assert_selected(
+    list *l, list *sorted, size_t prefix, size_t pivot,
+    int (*comp)(const void *, const void *)) {
+  uintptr_t data, sum = 0, sorted_sum = 0;
+  size_t k = 0;
+  void *item;
+
+  comp = comp ? comp : &comp_ascending;
+  assert_int_equal(sorted->size, l->size);
+
+  void *nth = list_get(sorted, pivot);
+
+  // shifting keeps this linear on the linked kinds
+  while (l->size) {
+    item = list_shift(l);
+    data = (uintptr_t) item;
+
+    if (k < prefix) {
+      assert_int_equal((uintptr_t) list_get(sorted, k), data);
+    } else if (k < pivot) {
+      assert_true(comp(&item, &nth) <= 0);
+    } else {
+      assert_true(comp(&item, &nth) >= 0);
+    }
+
+    sum += data;
+    sorted_sum += (uintptr_t) list_get(sorted, k++);
+  }
+
+  assert_int_equal(sorted_sum, sum);
+}
+
+void do_test_list_select_nth(
+    listkind *kind, int (*comp)(const void *, const void *)) {
+  size_t lens[] = { 1, 2, 17, 1000 };
+  size_t nths[4];
+  list *l, *sorted;
+  void *data;
+
+  l = list_new_kind(kind);
+  assert_non_null(l);
+
+  fly_status = FLY_OK;
+  assert_null(list_select_nth(NULL, 0, comp));
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_null(list_select_nth(l, 0, comp));
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+
+  for (size_t mode = 0; mode < INPUT_MODE_COUNT; mode++) {
+    for (size_t i = 0; i < sizeof (lens) / sizeof (lens[0]); i++) {
+      nths[0] = 0;
+      nths[1] = lens[i] / 3;
+      nths[2] = lens[i] / 2;
+      nths[3] = lens[i] - 1;
+
+      for (size_t j = 0; j < 4; j++) {
+        sorted = fill_select_list(l, mode, lens[i], comp);
+
+        fly_status = FLY_E_TOO_BIG;
+        data = list_select_nth(l, nths[j], comp);
+        assert_fly_status(FLY_OK);
+        assert_ptr_equal(list_get(sorted, nths[j]), data);
+        assert_ptr_equal(data, list_get(l, nths[j]));
+
+        assert_null(list_select_nth(l, lens[i], comp));
+        assert_fly_status(FLY_E_OUT_OF_RANGE);
+
+        assert_selected(l, sorted, 0, nths[j], comp);
+        list_del(sorted);
+      }
+    }
+  }
+
+  list_del(l);
+}
+
+void do_test_list_partial_sort(
+    listkind *kind, int (*comp)(const void *, const void *)) {
+  size_t lens[] = { 1, 2, 17, 1000 };
+  size_t ks[6], k;
+  list *l, *sorted;
+
+  l = list_new_kind(kind);
+  assert_non_null(l);
+
+  fly_status = FLY_E_TOO_BIG;
+  list_partial_sort(l, 3, comp);
+  assert_fly_status(FLY_OK);
+  list_partial_sort(NULL, 3, comp);
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  for (size_t mode = 0; mode < INPUT_MODE_COUNT; mode++) {
+    for (size_t i = 0; i < sizeof (lens) / sizeof (lens[0]); i++) {
+      ks[0] = 0;
+      ks[1] = 1;
+      ks[2] = 10;
+      ks[3] = lens[i] / 2;
+      ks[4] = lens[i] - 1;
+      ks[5] = lens[i] + 5;
+
+      for (size_t j = 0; j < 6; j++) {
+        sorted = fill_select_list(l, mode, lens[i], comp);
+
+        fly_status = FLY_E_TOO_BIG;
+        list_partial_sort(l, ks[j], comp);
+        assert_fly_status(FLY_OK);
+
+        k = ks[j] < lens[i] ? ks[j] : lens[i];
+        assert_selected(l, sorted, k, k ? k - 1 : 0, comp);
+        list_del(sorted);
+      }
+    }
+  }
+
+  list_del(l);
+}
+
+static list *top_k_inner;
+
+// Runs a top k of its own on every comparison, which list_top_k has to
+// survive.
+static int comp_top_k_nested(const void *a, const void *b) {
+  void *out[2];
+
+  assert_int_equal(2, list_top_k(top_k_inner, 2, NULL, out));
+  assert_int_equal(1, (uintptr_t) out[0]);
+  assert_int_equal(2, (uintptr_t) out[1]);
+
+  return (*(uintptr_t *) a > *(uintptr_t *) b)
+    - (*(uintptr_t *) a < *(uintptr_t *) b);
+}
+
+void do_test_list_top_k(
+    listkind *kind, int (*comp)(const void *, const void *)) {
+  size_t lens[] = { 1, 17, 1000 };
+  size_t ks[] = { 1, 5, 16, 17, 999, 2000 };
+  void *out[2000];
+  list *l, *sorted;
+
+  l = list_new_kind(kind);
+  assert_non_null(l);
+
+  fly_status = FLY_E_TOO_BIG;
+  assert_int_equal(0, list_top_k(l, 3, comp, out));
+  assert_fly_status(FLY_OK);
+  assert_int_equal(0, list_top_k(NULL, 3, comp, out));
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_int_equal(0, list_top_k(l, 3, comp, NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_int_equal(0, list_top_k(l, 0, comp, NULL));
+  assert_fly_status(FLY_OK);
+
+  for (size_t mode = 0; mode < INPUT_MODE_COUNT; mode++) {
+    for (size_t i = 0; i < sizeof (lens) / sizeof (lens[0]); i++) {
+      sorted = fill_select_list(l, mode, lens[i], comp);
+
+      for (size_t j = 0; j < sizeof (ks) / sizeof (ks[0]); j++) {
+        size_t expected = ks[j] < lens[i] ? ks[j] : lens[i];
+
+        fly_status = FLY_E_TOO_BIG;
+        assert_int_equal(expected, list_top_k(l, ks[j], comp, out));
+        assert_fly_status(FLY_OK);
+
+        for (size_t k = 0; k < expected; k++) {
+          assert_ptr_equal(list_get(sorted, k), out[k]);
+        }
+      }
+
+      // the list itself is left alone; newest items come off first
+      for (size_t k = lens[i]; k--;) {
+        uintptr_t data = make_large_sort_item(mode, k, lens[i]);
+
+        if (k % 2) {
+          assert_int_equal(data, (uintptr_t) list_shift(l));
+        } else {
+          assert_int_equal(data, (uintptr_t) list_pop(l));
+        }
+      }
+
+      assert_int_equal(0, l->size);
+      list_del(sorted);
+    }
+  }
+
+  // nothing is kept between calls, so they can nest
+  top_k_inner = list_new_kind(kind);
+  for (uintptr_t k = 1; k <= 20; k++) {
+    list_push(l, (void *) (100 - k));
+    list_push(top_k_inner, (void *) (21 - k));
+  }
+  assert_int_equal(3, list_top_k(l, 3, &comp_top_k_nested, out));
+  assert_int_equal(80, (uintptr_t) out[0]);
+  assert_int_equal(81, (uintptr_t) out[1]);
+  assert_int_equal(82, (uintptr_t) out[2]);
+  list_del(top_k_inner);
+
+  list_del(l);
+}
+
+#undef INPUT_MODE_RANDOM
+#undef INPUT_MODE_ASCENDING
+#undef INPUT_MODE_DESCENDING
+#undef INPUT_MODE_ORGAN_PIPE
+#undef INPUT_MODE_FEW_KEYS
+#undef INPUT_MODE_HIGH_BITS
+#undef INPUT_MODE_COUNT
+#endif
+
+TESTCALL(test_introsort_template, do_test_introsort_template())
+TESTCALL(test_arlist_sort_large_ascending,
+    do_test_list_sort_large(LISTKIND_ARRAY, NULL))
+TESTCALL(test_deque_sort_large_ascending,
+    do_test_list_sort_large(LISTKIND_DEQUE, NULL))
+TESTCALL(test_arlist_sort_large_descending,
+    do_test_list_sort_large(LISTKIND_ARRAY, &comp_descending))
+TESTCALL(test_deque_sort_large_descending,
+    do_test_list_sort_large(LISTKIND_DEQUE, &comp_descending))
+TESTCALL(test_introselect_template, do_test_introselect_template())
+TESTCALL(test_arlist_select_nth_ascending,
+    do_test_list_select_nth(LISTKIND_ARRAY, NULL))
+TESTCALL(test_arlist_select_nth_descending,
+    do_test_list_select_nth(LISTKIND_ARRAY, &comp_descending))
+TESTCALL(test_deque_select_nth_ascending,
+    do_test_list_select_nth(LISTKIND_DEQUE, NULL))
+TESTCALL(test_deque_select_nth_descending,
+    do_test_list_select_nth(LISTKIND_DEQUE, &comp_descending))
+TESTCALL(test_dllist_select_nth_ascending,
+    do_test_list_select_nth(LISTKIND_DLINK, NULL))
+TESTCALL(test_dllist_select_nth_descending,
+    do_test_list_select_nth(LISTKIND_DLINK, &comp_descending))
+TESTCALL(test_sllist_select_nth_ascending,
+    do_test_list_select_nth(LISTKIND_SLINK, NULL))
+TESTCALL(test_sllist_select_nth_descending,
+    do_test_list_select_nth(LISTKIND_SLINK, &comp_descending))
+TESTCALL(test_arlist_partial_sort_ascending,
+    do_test_list_partial_sort(LISTKIND_ARRAY, NULL))
+TESTCALL(test_arlist_partial_sort_descending,
+    do_test_list_partial_sort(LISTKIND_ARRAY, &comp_descending))
+TESTCALL(test_deque_partial_sort_ascending,
+    do_test_list_partial_sort(LISTKIND_DEQUE, NULL))
+TESTCALL(test_deque_partial_sort_descending,
+    do_test_list_partial_sort(LISTKIND_DEQUE, &comp_descending))
+TESTCALL(test_dllist_partial_sort_ascending,
+    do_test_list_partial_sort(LISTKIND_DLINK, NULL))
+TESTCALL(test_dllist_partial_sort_descending,
+    do_test_list_partial_sort(LISTKIND_DLINK, &comp_descending))
+TESTCALL(test_sllist_partial_sort_ascending,
+    do_test_list_partial_sort(LISTKIND_SLINK, NULL))
+TESTCALL(test_sllist_partial_sort_descending,
+    do_test_list_partial_sort(LISTKIND_SLINK, &comp_descending))
+TESTCALL(test_arlist_top_k_ascending,
+    do_test_list_top_k(LISTKIND_ARRAY, NULL))
+TESTCALL(test_arlist_top_k_descending,
+    do_test_list_top_k(LISTKIND_ARRAY, &comp_descending))
+TESTCALL(test_deque_top_k_ascending,
+    do_test_list_top_k(LISTKIND_DEQUE, NULL))
+TESTCALL(test_deque_top_k_descending,
+    do_test_list_top_k(LISTKIND_DEQUE, &comp_descending))
+TESTCALL(test_dllist_top_k_ascending,
+    do_test_list_top_k(LISTKIND_DLINK, NULL))
+TESTCALL(test_dllist_top_k_descending,
+    do_test_list_top_k(LISTKIND_DLINK, &comp_descending))
+TESTCALL(test_sllist_top_k_ascending,
+    do_test_list_top_k(LISTKIND_SLINK, NULL))
+TESTCALL(test_sllist_top_k_descending,
+    do_test_list_top_k(LISTKIND_SLINK, &comp_descending))
+
+#ifndef METHODS_ONLY
+#define SEARCH_KEY_SHIFT 16
+
+int comp_search_key(const void *lp, const void *rp) {
+  uintptr_t left = *(uintptr_t *) lp >> SEARCH_KEY_SHIFT;
+  uintptr_t right = *(uintptr_t *) rp >> SEARCH_KEY_SHIFT;
+
+  return (left > right) - (left < right);
+}
+
+void do_test_arlist_search(int (*comp)(const void *, const void *)) {
+  size_t lens[] = { 0, 1, 2, 3, 4, 7, 8, 9, 100, 1023, 1024, 5000 };
+  size_t lower, upper;
+  uintptr_t key, data;
+  arlist *l;
+
+  fly_status = FLY_OK;
+  arlist_lower_bound(NULL, NULL, comp);
+  assert_fly_status(FLY_E_NULL_PTR);
+  arlist_upper_bound(NULL, NULL, comp);
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_null(arlist_bsearch(NULL, NULL, comp));
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  for (size_t i = 0; i < sizeof (lens) / sizeof (lens[0]); i++) {
+    l = (arlist *) list_new_kind(LISTKIND_ARRAY);
+    assert_non_null(l);
+
+    // every other even number, three times over
+    for (size_t k = 0; k < lens[i]; k++) {
+      data = comp ? (lens[i] - 1 - k) / 3 * 4 + 2 : k / 3 * 4 + 2;
+      arlist_push(l, (void *) data);
+    }
+
+    for (key = 0; key <= lens[i] / 3 * 4 + 8; key++) {
+      lower = upper = 0;
+
+      for (size_t k = 0; k < lens[i]; k++) {
+        data = (uintptr_t) l->items[k];
+
+        if (comp ? data > key : data < key) {
+          lower = upper = k + 1;
+        } else if (data == key) {
+          upper = k + 1;
+        }
+      }
+
+      fly_status = FLY_E_TOO_BIG;
+      assert_int_equal(lower, arlist_lower_bound(l, (void *) key, comp));
+      assert_fly_status(FLY_OK);
+      assert_int_equal(upper, arlist_upper_bound(l, (void *) key, comp));
+      assert_fly_status(FLY_OK);
+
+      data = (uintptr_t) arlist_bsearch(l, (void *) key, comp);
+
+      if (lower == upper) {
+        assert_int_equal(0, data);
+        assert_fly_status(FLY_NOT_FOUND);
+      } else {
+        assert_int_equal(key, data);
+        assert_fly_status(FLY_OK);
+      }
+    }
+
+    list_del((list *) l);
+  }
+}
+
+void do_test_arlist_insert_sorted() {
+  const size_t len = 3000, keys = 101;
+  uintptr_t data, prev;
+  size_t i;
+  arlist *l = (arlist *) list_new_kind(LISTKIND_ARRAY);
+
+  assert_non_null(l);
+
+  assert_int_equal(SIZE_MAX, arlist_insert_sorted(NULL, NULL, NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  // The low bits count up, so equal keys must stay in insertion order.
+  for (size_t k = 0; k < len; k++) {
+    data = (k * 7919) % keys << SEARCH_KEY_SHIFT | k;
+
+    fly_status = FLY_E_TOO_BIG;
+    i = arlist_insert_sorted(l, (void *) data, &comp_search_key);
+    assert_fly_status(FLY_OK);
+    assert_int_equal(k + 1, l->size);
+    assert_int_equal(data, (uintptr_t) l->items[i]);
+    assert_int_equal(i + 1,
+        arlist_upper_bound(l, (void *) data, &comp_search_key));
+  }
+
+  prev = (uintptr_t) l->items[0];
+
+  for (size_t k = 1; k < len; k++) {
+    data = (uintptr_t) l->items[k];
+    assert_true(prev < data);
+    prev = data;
+  }
+
+  list_del((list *) l);
+
+  // Without a comparator, items are kept in address order.
+  l = (arlist *) list_new_kind(LISTKIND_ARRAY);
+  assert_non_null(l);
+
+  for (size_t k = 0; k < len; k++) {
+    arlist_insert_sorted(l, (void *) ((k * 7919) % len), NULL);
+  }
+
+  for (size_t k = 0; k < len; k++) {
+    assert_int_equal(k, (uintptr_t) l->items[k]);
+  }
+
+  list_del((list *) l);
+}
+
+#undef SEARCH_KEY_SHIFT
+#endif
+
+TESTCALL(test_arlist_search_ascending, do_test_arlist_search(NULL))
+TESTCALL(test_arlist_search_descending,
+    do_test_arlist_search(&comp_descending))
+TESTCALL(test_arlist_insert_sorted, do_test_arlist_insert_sorted())
+
+#ifndef METHODS_ONLY
+// Sizes on either side of the four and eight item vector steps.
+#define INDEX_OF_SIZES { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 100, 1001 }
+
+void fill_index_of_list(list *l, size_t size, size_t distinct) {
+  for (size_t k = 0; k < size; k++) {
+    // alternate ends so deque items wrap around the buffer
+    if (k % 2) {
+      list_unshift(l, (void *) (k % distinct + 1));
+    } else {
+      list_push(l, (void *) (k % distinct + 1));
+    }
+  }
+}
+
+void do_test_list_index_of(listkind *kind) {
+  size_t sizes[] = INDEX_OF_SIZES;
+  list *l;
+
+  fly_status = FLY_OK;
+  assert_int_equal(SIZE_MAX, list_index_of(NULL, NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_false(list_contains(NULL, NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    l = list_new_kind(kind);
+    assert_non_null(l);
+    fill_index_of_list(l, sizes[i], SIZE_MAX);
+
+    for (size_t k = 0; k < sizes[i]; k++) {
+      void *data = list_get(l, k);
+
+      fly_status = FLY_E_TOO_BIG;
+      assert_int_equal(k, list_index_of(l, data));
+      assert_fly_status(FLY_OK);
+
+      fly_status = FLY_E_TOO_BIG;
+      assert_true(list_contains(l, data));
+      assert_fly_status(FLY_OK);
+    }
+
+    assert_int_equal(SIZE_MAX, list_index_of(l, (void *) (sizes[i] + 1)));
+    assert_fly_status(FLY_NOT_FOUND);
+    assert_false(list_contains(l, NULL));
+    assert_fly_status(FLY_OK);
+
+    // the first of several equal items wins
+    list_push(l, list_get(l, 0));
+    assert_int_equal(0, list_index_of(l, list_get(l, -1)));
+
+    list_del(l);
+  }
+}
+
+void do_test_list_count_of(listkind *kind) {
+  size_t sizes[] = INDEX_OF_SIZES;
+  size_t distinct[] = { 1, 3, 5 };
+  list *l;
+
+  fly_status = FLY_OK;
+  assert_int_equal(0, list_count_of(NULL, NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    for (size_t j = 0; j < sizeof (distinct) / sizeof (distinct[0]); j++) {
+      size_t total = 0, expected;
+
+      l = list_new_kind(kind);
+      assert_non_null(l);
+      fill_index_of_list(l, sizes[i], distinct[j]);
+
+      for (uintptr_t data = 1; data <= distinct[j]; data++) {
+        expected = sizes[i] / distinct[j] + (sizes[i] % distinct[j] >= data);
+
+        fly_status = FLY_E_TOO_BIG;
+        assert_int_equal(expected, list_count_of(l, (void *) data));
+        assert_fly_status(FLY_OK);
+
+        total += expected;
+      }
+
+      assert_int_equal(sizes[i], total);
+      assert_int_equal(0, list_count_of(l, NULL));
+
+      list_del(l);
+    }
+  }
+}
+
+#undef INDEX_OF_SIZES
+#endif
+
+TESTCALL(test_arlist_index_of, do_test_list_index_of(LISTKIND_ARRAY))
+TESTCALL(test_deque_index_of, do_test_list_index_of(LISTKIND_DEQUE))
+TESTCALL(test_dllist_index_of, do_test_list_index_of(LISTKIND_DLINK))
+TESTCALL(test_sllist_index_of, do_test_list_index_of(LISTKIND_SLINK))
+TESTCALL(test_arlist_count_of, do_test_list_count_of(LISTKIND_ARRAY))
+TESTCALL(test_deque_count_of, do_test_list_count_of(LISTKIND_DEQUE))
+TESTCALL(test_dllist_count_of, do_test_list_count_of(LISTKIND_DLINK))
+TESTCALL(test_sllist_count_of, do_test_list_count_of(LISTKIND_SLINK))
+
+#ifndef METHODS_ONLY
+void assert_list_items(list *l, uintptr_t *expected, size_t n) {
+  assert_int_equal(n, l->size);
+
+  for (size_t k = 0; k < n; k++) {
+    assert_int_equal(expected[k], (uintptr_t) list_get(l, k));
+  }
+}
+
+void do_test_list_batch(listkind *kind) {
+  size_t sizes[] = { 1, 2, 5, 16, 17, 100 };
+  uintptr_t expected[100];
+  void *out[100];
+  size_t n, m;
+  list *l = list_new_kind(kind);
+
+  assert_non_null(l);
+
+  fly_status = FLY_OK;
+  assert_int_equal(0, list_pop_many(NULL, 1, out));
+  assert_fly_status(FLY_E_NULL_PTR);
+  fly_status = FLY_OK;
+  assert_int_equal(0, list_shift_many(l, 1, NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_int_equal(0, list_drain_into_array(NULL, out));
+  assert_fly_status(FLY_E_NULL_PTR);
+  list_unshift_array(l, 1, NULL);
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  assert_int_equal(0, list_pop_many(l, 1, out));
+  assert_fly_status(FLY_EMPTY);
+  assert_int_equal(0, list_shift_many(l, 1, out));
+  assert_fly_status(FLY_EMPTY);
+  assert_int_equal(0, list_drain_into_array(l, NULL));
+  assert_fly_status(FLY_OK);
+  list_unshift_array(l, 0, out);
+  assert_fly_status(FLY_OK);
+  list_push(l, (void *) 1);
+  list_unshift_array(l, PTRINDEX_MAX, out);
+  assert_fly_status(FLY_E_TOO_BIG);
+  assert_int_equal(1, l->size);
+
+  list_del(l);
+
+  for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    l = list_new_kind(kind);
+    assert_non_null(l);
+
+    // alternate ends so deque items wrap around the buffer
+    for (size_t k = 0; k < sizes[i]; k++) {
+      if (k % 2) {
+        list_unshift(l, (void *) (k + 1));
+      } else {
+        list_push(l, (void *) (k + 1));
+      }
+    }
+
+    for (size_t k = 0; k < sizes[i]; k++) {
+      expected[k] = (uintptr_t) list_get(l, k);
+    }
+
+    n = sizes[i] / 3 + 1;
+    fly_status = FLY_E_TOO_BIG;
+    assert_int_equal(n, list_pop_many(l, n, out));
+    assert_fly_status(FLY_OK);
+
+    for (size_t k = 0; k < n; k++) {
+      assert_int_equal(expected[sizes[i] - n + k], (uintptr_t) out[k]);
+    }
+    assert_list_items(l, expected, sizes[i] - n);
+
+    m = n < l->size ? n : l->size;
+
+    if (m) {
+      assert_int_equal(m, list_shift_many(l, n, out));
+      assert_fly_status(FLY_OK);
+
+      for (size_t k = 0; k < m; k++) {
+        assert_int_equal(expected[k], (uintptr_t) out[k]);
+      }
+      assert_list_items(l, expected + m, sizes[i] - n - m);
+    }
+
+    list_unshift_array(l, m, out);
+    assert_fly_status(FLY_OK);
+    assert_list_items(l, expected, sizes[i] - n);
+
+    // taking more than there is takes everything
+    m = l->size;
+    if (m) {
+      assert_int_equal(m, list_pop_many(l, SIZE_MAX, out));
+      assert_list_items(l, expected, 0);
+    }
+
+    list_unshift_array(l, m, out);
+    list_push(l, (void *) expected[m]);
+    list_unshift(l, (void *) 0);
+
+    fly_status = FLY_E_TOO_BIG;
+    assert_int_equal(m + 2, list_drain_into_array(l, out));
+    assert_fly_status(FLY_OK);
+    assert_int_equal(0, l->size);
+    assert_int_equal(0, (uintptr_t) out[0]);
+
+    for (size_t k = 0; k <= m; k++) {
+      assert_int_equal(expected[k], (uintptr_t) out[k + 1]);
+    }
+
+    // the list is still usable at both ends once it has been emptied
+    list_push(l, (void *) 1);
+    list_unshift(l, (void *) 2);
+    assert_int_equal(1, (uintptr_t) list_get(l, -1));
+    assert_int_equal(2, (uintptr_t) list_get(l, 0));
+
+    list_del(l);
+  }
+}
+
+void do_test_list_unshift_array_oom(listkind *kind) {
+  void *items[] = { (void *) 1, (void *) 2, (void *) 3 };
+  list *l = list_new_kind(kind);
+
+  assert_non_null(l);
+  list_push(l, (void *) 4);
+
+  for (int fail_at = 0; fail_at < 3; fail_at++) {
+    for (int k = 0; k < fail_at; k++) {
+      mockmem_queue(malloc(sizeof (struct dllistnode)));
+    }
+    mockmem_queue(NULL);
+
+    fly_status = FLY_OK;
+    list_unshift_array(l, 3, items);
+    assert_fly_status(FLY_E_OUT_OF_MEMORY);
+    assert_null(mockmem_peek());
+    assert_int_equal(1, l->size);
+    assert_int_equal(4, (uintptr_t) list_get(l, 0));
+  }
+
+  list_unshift_array(l, 3, items);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(4, l->size);
+  assert_int_equal(1, (uintptr_t) list_get(l, 0));
+  assert_int_equal(4, (uintptr_t) list_get(l, -1));
+
+  list_del(l);
+}
+#endif
+
+TESTCALL(test_arlist_batch, do_test_list_batch(LISTKIND_ARRAY))
+TESTCALL(test_deque_batch, do_test_list_batch(LISTKIND_DEQUE))
+TESTCALL(test_dllist_batch, do_test_list_batch(LISTKIND_DLINK))
+TESTCALL(test_sllist_batch, do_test_list_batch(LISTKIND_SLINK))
+TESTCALL(test_dllist_unshift_array_oom,
+         do_test_list_unshift_array_oom(LISTKIND_DLINK))
+TESTCALL(test_sllist_unshift_array_oom,
+         do_test_list_unshift_array_oom(LISTKIND_SLINK))
+
+#ifndef METHODS_ONLY
+void do_test_list_insert_remove(listkind *kind) {
+  const size_t len = 200;
+  uintptr_t model[200];
+  size_t size = 0, i;
+  list *l = list_new_kind(kind);
+
+  assert_non_null(l);
+
+  list_insert(NULL, 0, NULL);
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_null(list_remove_at(NULL, 0));
+  assert_fly_status(FLY_E_NULL_PTR);
+  list_insert(l, 1, NULL);
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+  list_insert(l, -1, NULL);
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+  assert_null(list_remove_at(l, 0));
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+
+  // Wander around the list, mirroring every edit in a plain array.
+  for (uintptr_t k = 1; k <= len; k++) {
+    i = (k * 7919) % (size + 1);
+
+    fly_status = FLY_E_TOO_BIG;
+    list_insert(l, i, (void *) k);
+    assert_fly_status(FLY_OK);
+
+    memmove(model + i + 1, model + i, (size - i) * sizeof (uintptr_t));
+    model[i] = k;
+    assert_int_equal(++size, l->size);
+
+    if (k % 3 == 0) {
+      i = (k * 104729) % size;
+
+      fly_status = FLY_E_TOO_BIG;
+      assert_int_equal(model[i], (uintptr_t) list_remove_at(l, i));
+      assert_fly_status(FLY_OK);
+
+      memmove(model + i, model + i + 1, (--size - i) * sizeof (uintptr_t));
+      assert_int_equal(size, l->size);
+    }
+  }
+
+  for (i = 0; i < size; i++) {
+    assert_int_equal(model[i], (uintptr_t) list_get(l, i));
+  }
+
+  // negative indices count from the end, and the size itself appends
+  list_insert(l, -1, (void *) 1000);
+  assert_int_equal(1000, (uintptr_t) list_get(l, -2));
+  assert_int_equal(model[size - 1], (uintptr_t) list_get(l, -1));
+  assert_int_equal(1000, (uintptr_t) list_remove_at(l, -2));
+
+  list_insert(l, size, (void *) 1001);
+  assert_int_equal(1001, (uintptr_t) list_get(l, -1));
+  list_insert(l, size + 2, (void *) 1002);
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+  assert_int_equal(1001, (uintptr_t) list_remove_at(l, -1));
+  assert_null(list_remove_at(l, size));
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+
+  // the ends are still intact for the plain operations
+  list_push(l, (void *) 1003);
+  list_unshift(l, (void *) 1004);
+  assert_int_equal(1003, (uintptr_t) list_pop(l));
+  assert_int_equal(1004, (uintptr_t) list_shift(l));
+
+  while (size) {
+    assert_int_equal(model[--size], (uintptr_t) list_remove_at(l, -1));
+  }
+
+  assert_int_equal(0, l->size);
+  list_insert(l, 0, (void *) 1);
+  list_push(l, (void *) 2);
+  assert_int_equal(1, (uintptr_t) list_get(l, 0));
+  assert_int_equal(2, (uintptr_t) list_get(l, -1));
+
+  list_del(l);
+}
+#endif
+
+TESTCALL(test_arlist_insert_remove, do_test_list_insert_remove(LISTKIND_ARRAY))
+TESTCALL(test_deque_insert_remove, do_test_list_insert_remove(LISTKIND_DEQUE))
+TESTCALL(test_dllist_insert_remove, do_test_list_insert_remove(LISTKIND_DLINK))
+TESTCALL(test_sllist_insert_remove, do_test_list_insert_remove(LISTKIND_SLINK))
+
+#ifndef METHODS_ONLY
+// Alternates ends so that deques wrap around their buffers.
+list *new_wrapped_test_list(listkind *kind, size_t size, uintptr_t base) {
+  list *l = list_new_kind(kind);
+
+  assert_non_null(l);
+
+  for (size_t k = 0; k < size; k++) {
+    if (k % 2) {
+      list_unshift(l, (void *) (base + k));
+    } else {
+      list_push(l, (void *) (base + k));
+    }
+  }
+
+  return l;
+}
+
+void copy_list_items(list *l, uintptr_t *out) {
+  for (size_t k = 0; k < l->size; k++) {
+    out[k] = (uintptr_t) list_get(l, k);
+  }
+}
+
+void do_test_list_reverse_rotate(listkind *kind) {
+  size_t sizes[] = { 0, 1, 2, 3, 8, 9, 17 };
+  uintptr_t model[17], rotated[17];
+  list *l;
+
+  list_reverse(NULL);
+  assert_fly_status(FLY_E_NULL_PTR);
+  list_rotate(NULL, 1);
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    const size_t size = sizes[i];
+    ptrdiff_t shifts[] = {
+      PTRDIFF_MIN, -(ptrdiff_t) size - 1, -2, -1, 0, 1, 2,
+      (ptrdiff_t) size, (ptrdiff_t) size + 3, PTRDIFF_MAX };
+
+    l = new_wrapped_test_list(kind, size, 1);
+    copy_list_items(l, model);
+
+    fly_status = FLY_E_TOO_BIG;
+    list_reverse(l);
+    assert_fly_status(FLY_OK);
+
+    for (size_t k = 0; k < size; k++) {
+      assert_int_equal(model[size - 1 - k], (uintptr_t) list_get(l, k));
+    }
+
+    list_reverse(l);
+    assert_list_items(l, model, size);
+
+    for (size_t j = 0; j < sizeof (shifts) / sizeof (shifts[0]); j++) {
+      size_t left = 0;
+
+      if (size) {
+        // the same arithmetic, done the slow way
+        left = shifts[j] < 0
+          ? (size - (size_t) (-(shifts[j] + 1) % (ptrdiff_t) size) - 1) % size
+          : (size_t) shifts[j] % size;
+      }
+
+      for (size_t k = 0; k < size; k++) {
+        rotated[k] = model[(k + left) % size];
+      }
+
+      fly_status = FLY_E_TOO_BIG;
+      list_rotate(l, shifts[j]);
+      assert_fly_status(FLY_OK);
+      assert_list_items(l, rotated, size);
+
+      list_rotate(l, -(ptrdiff_t) left);
+      assert_list_items(l, model, size);
+    }
+
+    // the ends are still intact for the plain operations
+    list_rotate(l, 1);
+    list_push(l, (void *) 100);
+    list_unshift(l, (void *) 101);
+    assert_int_equal(100, (uintptr_t) list_pop(l));
+    assert_int_equal(101, (uintptr_t) list_shift(l));
+
+    list_del(l);
+  }
+}
+
+void do_test_list_slice(listkind *kind) {
+  ptrdiff_t ranges[][2] = {
+    { 0, 20 }, { 3, 7 }, { -5, -1 }, { 5, 5 }, { 18, 20 }, { 0, -19 } };
+  uintptr_t model[20];
+  list *l = new_wrapped_test_list(kind, 20, 1), *slice;
+
+  copy_list_items(l, model);
+
+  assert_null(list_slice(NULL, 0, 0));
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_null(list_slice(l, 5, 3));
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+  assert_null(list_slice(l, 0, 21));
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+  assert_null(list_slice(l, -21, 0));
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+
+  for (size_t i = 0; i < sizeof (ranges) / sizeof (ranges[0]); i++) {
+    size_t from = ranges[i][0] < 0 ? ranges[i][0] + 20 : ranges[i][0];
+    size_t to = ranges[i][1] < 0 ? ranges[i][1] + 20 : ranges[i][1];
+
+    fly_status = FLY_E_TOO_BIG;
+    slice = list_slice(l, ranges[i][0], ranges[i][1]);
+    assert_non_null(slice);
+    assert_fly_status(FLY_OK);
+    assert_ptr_equal(kind, slice->kind);
+    assert_list_items(slice, model + from, to - from);
+
+    list_del(slice);
+  }
+
+  assert_list_items(l, model, 20);
+  list_del(l);
+}
+
+void do_test_list_splice(listkind *kind, listkind *other_kind) {
+  list *dst = new_wrapped_test_list(kind, 5, 101);
+  list *src = new_wrapped_test_list(other_kind, 10, 1);
+  uintptr_t dst_model[20], src_model[10], expected[20];
+
+  copy_list_items(dst, dst_model);
+  copy_list_items(src, src_model);
+
+  list_splice(NULL, 0, src, 0, 1);
+  assert_fly_status(FLY_E_NULL_PTR);
+  list_splice(src, 0, src, 0, 1);
+  assert_fly_status(FLY_E_INVALID_ARG);
+  list_splice(dst, 6, src, 0, 1);
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+  list_splice(dst, 0, src, 3, 11);
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+  list_splice(dst, 0, src, 3, 3);
+  assert_fly_status(FLY_OK);
+
+  // into the middle, from the middle
+  fly_status = FLY_E_TOO_BIG;
+  list_splice(dst, 2, src, 3, 7);
+  assert_fly_status(FLY_OK);
+
+  memcpy(expected, dst_model, 2 * sizeof (uintptr_t));
+  memcpy(expected + 2, src_model + 3, 4 * sizeof (uintptr_t));
+  memcpy(expected + 6, dst_model + 2, 3 * sizeof (uintptr_t));
+  assert_list_items(dst, expected, 9);
+
+  memcpy(src_model + 3, src_model + 7, 3 * sizeof (uintptr_t));
+  assert_list_items(src, src_model, 6);
+
+  // the tail of src onto the end of dst, then the head of src to the front
+  list_splice(dst, 9, src, -2, 6);
+  expected[9] = src_model[4];
+  expected[10] = src_model[5];
+  assert_list_items(dst, expected, 11);
+  assert_list_items(src, src_model, 4);
+
+  list_splice(dst, 0, src, 0, 4);
+  memmove(expected + 4, expected, 11 * sizeof (uintptr_t));
+  memcpy(expected, src_model, 4 * sizeof (uintptr_t));
+  assert_list_items(dst, expected, 15);
+  assert_int_equal(0, src->size);
+
+  // both ends of both lists still work
+  list_push(src, (void *) 200);
+  list_unshift(src, (void *) 201);
+  assert_int_equal(200, (uintptr_t) list_get(src, -1));
+  assert_int_equal(201, (uintptr_t) list_get(src, 0));
+
+  list_splice(src, 1, dst, 0, 15);
+  assert_int_equal(0, dst->size);
+  assert_int_equal(17, src->size);
+  assert_int_equal(200, (uintptr_t) list_pop(src));
+  assert_int_equal(201, (uintptr_t) list_shift(src));
+  assert_list_items(src, expected, 15);
+
+  list_push(dst, (void *) 202);
+  assert_int_equal(202, (uintptr_t) list_get(dst, 0));
+
+  list_del(dst);
+  list_del(src);
+}
+
+void do_test_array_views() {
+  arlist *l = (arlist *) new_wrapped_test_list(LISTKIND_ARRAY, 10, 1);
+  deque *d = (deque *) new_wrapped_test_list(LISTKIND_DEQUE, 10, 1);
+  arlist view;
+  deque dview;
+  uintptr_t model[10];
+
+  view = arlist_view(l, 2, 7);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(5, view.size);
+  assert_ptr_equal(l->items + 2, view.items);
+  assert_ptr_equal(l->items[4], list_get((list *) &view, 2));
+
+  // sorting the view sorts that part of the list
+  list_sort((list *) &view, NULL);
+  for (size_t k = 1; k < 5; k++) {
+    assert_true(l->items[k + 1] < l->items[k + 2]);
+  }
+
+  view = arlist_view(l, 7, 11);
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+  assert_int_equal(0, view.size);
+
+  // the deque's items wrap, so they're lined up for the view, in order
+  assert_true(d->start + d->size > d->capacity);
+  copy_list_items((list *) d, model);
+
+  dview = deque_view(d, 1, 9);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(8, dview.size);
+  assert_ptr_equal(d->items, dview.items);
+  assert_true(dview.start + dview.size <= dview.capacity);
+  assert_list_items((list *) d, model, 10);
+
+  for (size_t k = 0; k < 8; k++) {
+    assert_ptr_equal(list_get((list *) d, k + 1), list_get((list *) &dview, k));
+  }
+
+  dview = deque_view(d, 4, 4);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(0, dview.size);
+
+  dview = deque_view(NULL, 0, 0);
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  list_del((list *) l);
+  list_del((list *) d);
+
+  // sorting a view of a full deque that wraps leaves the rest of it alone
+  for (int stable = 0; stable < 2; stable++) {
+    uintptr_t front[] = { 0, 0, 0, 0, 0, 0, 106, 107 };
+    uintptr_t back[] = { 50, 49, 48, 47, 46, 45 };
+    uintptr_t sorted[] = { 106, 48, 49, 50, 107, 47, 46, 45 };
+
+    d = (deque *) list_new_kind(LISTKIND_DEQUE);
+    for (size_t k = 0; k < 8; k++) {
+      list_push((list *) d, (void *) front[k]);
+    }
+    for (size_t k = 0; k < 6; k++) {
+      list_shift((list *) d);
+      list_push((list *) d, (void *) back[k]);
+    }
+    assert_int_equal(8, d->capacity);
+    assert_int_equal(6, d->start);
+
+    dview = deque_view(d, 1, 5);
+    if (stable) {
+      list_sort_stable((list *) &dview, NULL);
+    } else {
+      list_sort((list *) &dview, NULL);
+    }
+    assert_fly_status(FLY_OK);
+    assert_list_items((list *) d, sorted, 8);
+
+    list_del((list *) d);
+  }
+}
+#endif
+
+TESTCALL(test_arlist_reverse_rotate,
+         do_test_list_reverse_rotate(LISTKIND_ARRAY))
+TESTCALL(test_deque_reverse_rotate,
+         do_test_list_reverse_rotate(LISTKIND_DEQUE))
+TESTCALL(test_dllist_reverse_rotate,
+         do_test_list_reverse_rotate(LISTKIND_DLINK))
+TESTCALL(test_sllist_reverse_rotate,
+         do_test_list_reverse_rotate(LISTKIND_SLINK))
+TESTCALL(test_arlist_slice, do_test_list_slice(LISTKIND_ARRAY))
+TESTCALL(test_deque_slice, do_test_list_slice(LISTKIND_DEQUE))
+TESTCALL(test_dllist_slice, do_test_list_slice(LISTKIND_DLINK))
+TESTCALL(test_sllist_slice, do_test_list_slice(LISTKIND_SLINK))
+TESTCALL(test_arlist_splice,
+         do_test_list_splice(LISTKIND_ARRAY, LISTKIND_ARRAY))
+TESTCALL(test_deque_splice,
+         do_test_list_splice(LISTKIND_DEQUE, LISTKIND_DEQUE))
+TESTCALL(test_dllist_splice,
+         do_test_list_splice(LISTKIND_DLINK, LISTKIND_DLINK))
+TESTCALL(test_sllist_splice,
+         do_test_list_splice(LISTKIND_SLINK, LISTKIND_SLINK))
+TESTCALL(test_list_splice_mixed_kinds,
+         do_test_list_splice(LISTKIND_DEQUE, LISTKIND_SLINK))
+TESTCALL(test_array_views, do_test_array_views())
+
+#ifndef METHODS_ONLY
+// Batch operations can grow a deque that wraps without being full.
+void do_test_deque_grow_wrapped() {
+  void *more[] = { (void *) 11, (void *) 12, (void *) 13, (void *) 14 };
+  uintptr_t model[13];
+
+  for (int front = 0; front <= 1; front++) {
+    list *l = new_wrapped_test_list(LISTKIND_DEQUE, 5, 1);
+    deque *d = (deque *) l;
+
+    assert_int_equal(8, d->capacity);
+    assert_true(d->start > d->end);
+
+    copy_list_items(l, model + 4 * front);
+    memcpy(model + 5 * !front, more, 4 * sizeof (void *));
+
+    if (front) {
+      list_unshift_array(l, 4, more);
+    } else {
+      list_append_array(l, 4, more);
+    }
+
+    assert_fly_status(FLY_OK);
+    assert_true(d->capacity > 8);
+    assert_list_items(l, model, 9);
+
+    list_del(l);
+  }
+}
+#endif
+
+TESTCALL(test_deque_grow_wrapped, do_test_deque_grow_wrapped())
+
+#ifndef METHODS_ONLY
+void do_test_list_iter(listkind *kind) {
+  size_t sizes[] = { 0, 1, 2, 5, 16, 17 };
+  uintptr_t model[17];
+  list_iter it;
+  void *item;
+  size_t n;
+
+  it = list_iter_of(NULL);
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_false(list_iter_has_next(&it));
+
+  for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    list *l = new_wrapped_test_list(kind, sizes[i], 1);
+
+    copy_list_items(l, model);
+
+    fly_status = FLY_E_TOO_BIG;
+    it = list_iter_of(l);
+    assert_fly_status(FLY_OK);
+
+    for (n = 0; list_iter_has_next(&it); n++) {
+      assert_int_equal(model[n], (uintptr_t) list_iter_peek(&it));
+      assert_int_equal(model[n], (uintptr_t) list_iter_next(&it));
+    }
+    assert_int_equal(sizes[i], n);
+
+    n = 0;
+    LIST_FOR_EACH(l, item) {
+      assert_int_equal(model[n++], (uintptr_t) item);
+    }
+    assert_int_equal(sizes[i], n);
+
+    // break leaves the loop at once, even partway through a run
+    n = 0;
+    LIST_FOR_EACH(l, item) {
+      if ((uintptr_t) item == model[sizes[i] / 2]) {
+        break;
+      }
+      n++;
+    }
+    assert_int_equal(sizes[i] / 2, n);
+
+    list_del(l);
+  }
+}
+
+// Sums the items at even positions and stops at the first multiple of 11,
+// which exercises continue and break along with the plain walk.
+#define SUM_UNTIL_ELEVEN(FOR_EACH, l, item, visited, sum)  \
+  visited = sum = 0;  \
+  FOR_EACH(l, item) {  \
+    if ((uintptr_t) item % 11 == 0) {  \
+      break;  \
+    }  \
+    if (visited++ % 2) {  \
+      continue;  \
+    }  \
+    sum += (uintptr_t) item;  \
+  }
+
+void do_test_list_for_each_macros() {
+  listkind *kinds[] = {
+    LISTKIND_ARRAY, LISTKIND_DEQUE, LISTKIND_DLINK, LISTKIND_SLINK
+  };
+  uintptr_t model[11], expected_sum, sum;
+  size_t stop, visited;
+  void *item;
+
+  for (size_t i = 0; i < sizeof (kinds) / sizeof (kinds[0]); i++) {
+    list *empty = list_new_kind(kinds[i]);
+    list *l = new_wrapped_test_list(kinds[i], 11, 1);
+
+    copy_list_items(l, model);
+    expected_sum = 0;
+
+    for (stop = 0; model[stop] % 11; stop++) {
+      expected_sum += stop % 2 ? 0 : model[stop];
+    }
+
+    if (kinds[i] == LISTKIND_ARRAY) {
+      SUM_UNTIL_ELEVEN(ARLIST_FOR_EACH, (arlist *) empty, item, visited, sum)
+      assert_int_equal(0, visited);
+      SUM_UNTIL_ELEVEN(ARLIST_FOR_EACH, (arlist *) l, item, visited, sum)
+    } else if (kinds[i] == LISTKIND_DEQUE) {
+      assert_true(((deque *) l)->start > ((deque *) l)->end);
+      SUM_UNTIL_ELEVEN(DEQUE_FOR_EACH, (deque *) empty, item, visited, sum)
+      assert_int_equal(0, visited);
+      SUM_UNTIL_ELEVEN(DEQUE_FOR_EACH, (deque *) l, item, visited, sum)
+    } else if (kinds[i] == LISTKIND_DLINK) {
+      SUM_UNTIL_ELEVEN(DLLIST_FOR_EACH, (dllist *) empty, item, visited, sum)
+      assert_int_equal(0, visited);
+      SUM_UNTIL_ELEVEN(DLLIST_FOR_EACH, (dllist *) l, item, visited, sum)
+    } else {
+      SUM_UNTIL_ELEVEN(SLLIST_FOR_EACH, (sllist *) empty, item, visited, sum)
+      assert_int_equal(0, visited);
+      SUM_UNTIL_ELEVEN(SLLIST_FOR_EACH, (sllist *) l, item, visited, sum)
+    }
+
+    assert_int_equal(stop, visited);
+    assert_int_equal(expected_sum, sum);
+
+    list_del(empty);
+    list_del(l);
+  }
+
+  // A deque emptied after wrapping still has its buffer, and one that ends
+  // flush with the end of the buffer has a single run.
+  deque *d = (deque *) new_wrapped_test_list(LISTKIND_DEQUE, 7, 1);
+
+  while (d->size) {
+    deque_pop(d);
+  }
+
+  visited = 0;
+  DEQUE_FOR_EACH(d, item) {
+    visited++;
+  }
+  assert_int_equal(0, visited);
+
+  for (uintptr_t k = 1; k <= 3; k++) {
+    deque_push(d, (void *) k);
+  }
+
+  assert_int_equal(5, d->start);
+  assert_int_equal(0, d->end);
+  visited = 0;
+  DEQUE_FOR_EACH(d, item) {
+    assert_int_equal(++visited, (uintptr_t) item);
+  }
+  assert_int_equal(3, visited);
+
+  list_del((list *) d);
+}
+#undef SUM_UNTIL_ELEVEN
+#endif
+
+TESTCALL(test_arlist_iter, do_test_list_iter(LISTKIND_ARRAY))
+TESTCALL(test_deque_iter, do_test_list_iter(LISTKIND_DEQUE))
+TESTCALL(test_dllist_iter, do_test_list_iter(LISTKIND_DLINK))
+TESTCALL(test_sllist_iter, do_test_list_iter(LISTKIND_SLINK))
+TESTCALL(test_list_for_each_macros, do_test_list_for_each_macros())
+
+#ifndef METHODS_ONLY
+#ifdef FLY_LIST_GENERIC
+// The typed paths have to report the same statuses as the listkind path,
+// which sets FLY_OK on success.
+#define ASSERT_SAME_AS_LISTKIND(T, l)  \
+  do {  \
+    fly_status = FLY_E_TOO_BIG;  \
+    list_push((T *) l, (void *) 2);  \
+    assert_fly_status(FLY_OK);  \
+    fly_status = FLY_E_TOO_BIG;  \
+    list_unshift((T *) l, (void *) 1);  \
+    assert_fly_status(FLY_OK);  \
+    list_push((T *) l, (void *) 3);  \
+    assert_int_equal(3, (uintptr_t) list_get((T *) l, -1));  \
+    assert_null(list_get((T *) l, 3));  \
+    assert_fly_status(FLY_E_OUT_OF_RANGE);  \
+    fly_status = FLY_E_TOO_BIG;  \
+    assert_int_equal(1, (uintptr_t) list_shift((T *) l));  \
+    assert_fly_status(FLY_OK);  \
+    fly_status = FLY_E_TOO_BIG;  \
+    assert_int_equal(3, (uintptr_t) list_pop((T *) l));  \
+    assert_fly_status(FLY_OK);  \
+    assert_int_equal(2, (uintptr_t) list_pop((T *) l));  \
+    assert_null(list_pop((T *) l));  \
+    assert_fly_status(FLY_EMPTY);  \
+    assert_null(list_shift((T *) NULL));  \
+    assert_fly_status(FLY_E_NULL_PTR);  \
+  } while (0)
+
+void do_test_list_generic_dispatch() {
+  list *l;
+
+  assert_ptr_equal(&arlist_push, FLY_LIST_GENERIC((arlist *) NULL, push));
+  assert_ptr_equal(&deque_get, FLY_LIST_GENERIC((deque *) NULL, get));
+  assert_ptr_equal(&dllist_pop, FLY_LIST_GENERIC((dllist *) NULL, pop));
+  assert_ptr_equal(&sllist_shift, FLY_LIST_GENERIC((sllist *) NULL, shift));
+  assert_ptr_equal(&list_unshift, FLY_LIST_GENERIC((list *) NULL, unshift));
+
+  l = list_new_kind(LISTKIND_ARRAY);
+  ASSERT_SAME_AS_LISTKIND(arlist, l);
+  list_del(l);
+
+  l = list_new_kind(LISTKIND_DEQUE);
+  ASSERT_SAME_AS_LISTKIND(deque, l);
+  list_del(l);
+
+  l = list_new_kind(LISTKIND_DLINK);
+  ASSERT_SAME_AS_LISTKIND(dllist, l);
+  list_del(l);
+
+  l = list_new_kind(LISTKIND_SLINK);
+  ASSERT_SAME_AS_LISTKIND(sllist, l);
+  ASSERT_SAME_AS_LISTKIND(list, l);
+  list_del(l);
+}
+#undef ASSERT_SAME_AS_LISTKIND
+#else
+void do_test_list_generic_dispatch() {
+}
+#endif
+#endif
+
+TESTCALL(test_list_generic_dispatch, do_test_list_generic_dispatch())
+
 #ifndef METHODS_ONLY
 void do_test_list_e_null_ptr() {
   list *l = list_new();
@@ -0,0 +1,195 @@
+#include <stdalign.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "tests.h"
+#include "mockmem.h"
+
+#include "pool.h"
+
+#if !defined(_WINDLL) && !defined(METHODS_ONLY)
+int pool_setup(void **state) {
+  (void) state;
+
+  return 0;
+}
+
+int pool_teardown(void **state) {
+  (void) state;
+
+  return 0;
+}
+#endif
+
+#ifndef METHODS_ONLY
+struct pool_test_obj {
+  uint64_t magic;
+  uint8_t payload[20];
+};
+
+#define POOL_TEST_MAGIC 0x5ca1ab1e
+static size_t pool_test_inits, pool_test_finis;
+
+static void init_pool_test_obj(void *obj) {
+  ((struct pool_test_obj *) obj)->magic = POOL_TEST_MAGIC;
+  pool_test_inits++;
+}
+
+static void fini_pool_test_obj(void *obj) {
+  assert_int_equal(POOL_TEST_MAGIC, ((struct pool_test_obj *) obj)->magic);
+  ((struct pool_test_obj *) obj)->magic = 0;
+  pool_test_finis++;
+}
+
+pool *new_test_pool(void (*init)(void *), void (*fini)(void *)) {
+  pool *p = pool_new_with_callbacks(
+      sizeof (struct pool_test_obj), alignof (struct pool_test_obj),
+      init, fini);
+
+  assert_non_null(p);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(0, p->live);
+  assert_int_equal(0, p->size % p->align);
+
+  return p;
+}
+
+void do_test_pool_new() {
+  pool *p;
+
+  fly_status = FLY_OK;
+  assert_null(pool_new(8, 3));
+  assert_fly_status(FLY_E_INVALID_ARG);
+  assert_null(pool_new(8, 0));
+  assert_fly_status(FLY_E_INVALID_ARG);
+  assert_null(pool_new(SIZE_MAX - 1, 64));
+  assert_fly_status(FLY_E_TOO_BIG);
+
+  // every slot has room for the free list's link
+  p = pool_new(1, 1);
+  assert_non_null(p);
+  assert_int_equal(sizeof (void *), p->size);
+  assert_int_equal(alignof (void *), p->align);
+  pool_del(p);
+
+  // slabs soon outgrow the arena's blocks, and the alignment has to hold
+  // there too
+  p = pool_new(40, 64);
+  assert_int_equal(64, p->size);
+  for (size_t k = 0; k < 5000; k++) {
+    assert_int_equal(0, (uintptr_t) pool_alloc(p) % 64);
+  }
+  assert_non_null(p->arena->large);
+  pool_del(p);
+
+  mockmem_queue(NULL);
+  fly_status = FLY_OK;
+  assert_null(pool_new_type(struct pool_test_obj));
+  assert_null(mockmem_peek());
+  assert_fly_status(FLY_E_OUT_OF_MEMORY);
+
+  assert_null(pool_alloc(NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+  pool_free(NULL, NULL);
+  assert_fly_status(FLY_E_NULL_PTR);
+  pool_reset(NULL);
+  assert_fly_status(FLY_E_NULL_PTR);
+  pool_del(NULL);
+}
+
+void do_test_pool_alloc_free() {
+  pool *p = new_test_pool(NULL, NULL);
+  struct pool_test_obj *objs[200];
+
+  for (size_t k = 0; k < 200; k++) {
+    objs[k] = pool_alloc_type(p, struct pool_test_obj);
+    assert_non_null(objs[k]);
+    assert_fly_status(FLY_OK);
+    memset(objs[k], (int) k, sizeof (struct pool_test_obj));
+  }
+  assert_int_equal(200, p->live);
+
+  // slabs double, so 200 objects take 32 + 64 + 128
+  assert_int_equal(128, p->slabs->count);
+  assert_null(p->slabs->prev->prev->prev);
+
+  for (size_t k = 0; k < 200; k++) {
+    assert_int_equal((uint8_t) k, objs[k]->payload[19]);
+  }
+
+  // freed objects come back last in, first out
+  for (size_t k = 0; k < 200; k += 3) {
+    pool_free(p, objs[k]);
+    assert_fly_status(FLY_OK);
+  }
+  assert_int_equal(133, p->live);
+
+  for (size_t k = 0; k < 200; k += 3) {
+    assert_ptr_equal(objs[198 - k], pool_alloc(p));
+  }
+  assert_int_equal(200, p->live);
+  assert_int_equal(128, p->slabs->count);
+
+  pool_free(p, NULL);
+  assert_fly_status(FLY_OK);
+
+  pool_reset(p);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(0, p->live);
+  assert_null(p->free);
+  assert_non_null(pool_alloc(p));
+  assert_int_equal(POOL_FIRST_SLAB, p->slabs->count);
+
+  pool_del(p);
+}
+
+void do_test_pool_callbacks() {
+  pool *p = new_test_pool(&init_pool_test_obj, &fini_pool_test_obj);
+  struct pool_test_obj *objs[100];
+
+  pool_test_inits = pool_test_finis = 0;
+
+  for (size_t k = 0; k < 100; k++) {
+    objs[k] = pool_alloc_type(p, struct pool_test_obj);
+    assert_int_equal(POOL_TEST_MAGIC, objs[k]->magic);
+  }
+  assert_int_equal(100, pool_test_inits);
+
+  for (size_t k = 0; k < 100; k += 4) {
+    pool_free(p, objs[k]);
+  }
+  assert_int_equal(25, pool_test_finis);
+
+  // the freed ones are skipped, since fini would catch them twice
+  pool_reset(p);
+  assert_int_equal(100, pool_test_finis);
+
+  for (size_t k = 0; k < 10; k++) {
+    pool_alloc(p);
+  }
+  assert_int_equal(110, pool_test_inits);
+
+  pool_del(p);
+  assert_int_equal(110, pool_test_finis);
+}
+#endif
+
+TESTCALL(test_pool_new, do_test_pool_new())
+TESTCALL(test_pool_alloc_free, do_test_pool_alloc_free())
+TESTCALL(test_pool_callbacks, do_test_pool_callbacks())
+
+#ifndef _WINDLL
+#ifndef METHODS_ONLY
+#define METHODS_ONLY
+#undef TEST
+#define TEST(name, def) cmocka_unit_test(name),
+int main(void) {
+  const struct CMUnitTest tests[] = {
+#include "test_pool.c"
+  };
+
+  return cmocka_run_group_tests_name(
+      "flytools pool", tests, pool_setup, pool_teardown);
+}
+#endif  // METHODS_ONLY
+#endif
@@ -0,0 +1,305 @@
+#include <stdint.h>
+
+#include "tests.h"
+#include "mockmem.h"
+
+#include "pqueue.h"
+
+#if !defined(_WINDLL) && !defined(METHODS_ONLY)
+int pqueue_setup(void **state) {
+  (void) state;
+
+  return 0;
+}
+
+int pqueue_teardown(void **state) {
+  (void) state;
+
+  return 0;
+}
+#endif
+
+#ifndef METHODS_ONLY
+pqueue *new_test_pqueue(
+    size_t arity, int (*comp)(const void *, const void *)) {
+  pqueue *q = pqueue_new_of_arity(arity, comp);
+
+  assert_non_null(q);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(arity, q->arity);
+  assert_int_equal(0, pqueue_size(q));
+  assert_null(q->moved);
+
+  return q;
+}
+
+uintptr_t scrambled_key(size_t k, size_t len) {
+  return (k * 7919) % len + 1;
+}
+
+void do_test_pqueue_new() {
+  pqueue *q = pqueue_new(NULL);
+
+  assert_non_null(q);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(PQUEUE_DEFAULT_ARITY, q->arity);
+  pqueue_del(q);
+
+  for (size_t arity = 0; arity < 2; arity++) {
+    fly_status = FLY_OK;
+    assert_null(pqueue_new_of_arity(arity, NULL));
+    assert_fly_status(FLY_E_INVALID_ARG);
+  }
+
+  pqueue_del(NULL);
+}
+
+void do_test_pqueue_empty() {
+  pqueue *q = new_test_pqueue(PQUEUE_DEFAULT_ARITY, NULL);
+
+  assert_null(pqueue_peek(q));
+  assert_fly_status(FLY_EMPTY);
+  assert_null(pqueue_pop(q));
+  assert_fly_status(FLY_EMPTY);
+
+  pqueue_decrease_key(q, 0);
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+  assert_null(pqueue_remove(q, 0));
+  assert_fly_status(FLY_E_OUT_OF_RANGE);
+
+  pqueue_push_array(q, 0, NULL);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(0, pqueue_size(q));
+
+  pqueue_push(NULL, (void *) 1);
+  assert_fly_status(FLY_E_NULL_PTR);
+  pqueue_push_array(q, 1, NULL);
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_null(pqueue_pop(NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_null(pqueue_peek(NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_int_equal(0, pqueue_size(NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  pqueue_del(q);
+}
+
+static int comp_pqueue_descending(const void *lp, const void *rp) {
+  uintptr_t left = *(uintptr_t *) lp;
+  uintptr_t right = *(uintptr_t *) rp;
+
+  return (left < right) - (left > right);
+}
+
+void do_test_pqueue_push_pop(
+    size_t arity, int (*comp)(const void *, const void *)) {
+  const size_t len = 1000;
+  pqueue *q = new_test_pqueue(arity, comp);
+  uintptr_t expected;
+
+  for (size_t k = 0; k < len; k++) {
+    pqueue_push(q, (void *) scrambled_key(k, len));
+    assert_fly_status(FLY_OK);
+    assert_int_equal(k + 1, pqueue_size(q));
+  }
+
+  for (size_t k = 0; k < len; k++) {
+    expected = comp ? len - k : k + 1;
+
+    assert_int_equal(expected, (uintptr_t) pqueue_peek(q));
+    assert_int_equal(expected, (uintptr_t) pqueue_pop(q));
+    assert_fly_status(FLY_OK);
+    assert_int_equal(len - k - 1, pqueue_size(q));
+  }
+
+  assert_null(pqueue_pop(q));
+  assert_fly_status(FLY_EMPTY);
+
+  pqueue_del(q);
+}
+
+void do_test_pqueue_push_array(size_t arity) {
+  size_t sizes[] = { 1, 2, 5, 100, 997 };
+  void *items[997];
+  pqueue *q;
+
+  for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    for (size_t k = 0; k < sizes[i]; k++) {
+      items[k] = (void *) scrambled_key(k, sizes[i]);
+    }
+
+    // heapify into an empty queue, then a small batch into a big one
+    q = new_test_pqueue(arity, NULL);
+    pqueue_push_array(q, sizes[i], items);
+    assert_fly_status(FLY_OK);
+    assert_int_equal(sizes[i], pqueue_size(q));
+
+    pqueue_push_array(q, sizes[i] / 3, items);
+    assert_fly_status(FLY_OK);
+
+    // nothing to push, whether or not there's an array to push it from
+    pqueue_push_array(q, 0, NULL);
+    assert_fly_status(FLY_OK);
+    pqueue_push_array(q, 0, items);
+    assert_fly_status(FLY_OK);
+    assert_int_equal(1, (uintptr_t) pqueue_peek(q));
+
+    size_t total = sizes[i] + sizes[i] / 3;
+    uintptr_t prev = 0, data;
+
+    assert_int_equal(total, pqueue_size(q));
+
+    for (size_t k = 0; k < total; k++) {
+      data = (uintptr_t) pqueue_pop(q);
+      assert_true(prev <= data);
+      prev = data;
+    }
+
+    assert_int_equal(sizes[i], prev);
+    assert_int_equal(0, pqueue_size(q));
+
+    pqueue_del(q);
+  }
+}
+
+struct pqueue_timer {
+  uintptr_t deadline;
+  size_t index;
+};
+
+static int comp_timer(const void *lp, const void *rp) {
+  struct pqueue_timer *left = *(struct pqueue_timer **) lp;
+  struct pqueue_timer *right = *(struct pqueue_timer **) rp;
+
+  return (left->deadline > right->deadline)
+    - (left->deadline < right->deadline);
+}
+
+static void track_timer(void *data, size_t index) {
+  ((struct pqueue_timer *) data)->index = index;
+}
+
+void assert_timer_handles(pqueue *q, struct pqueue_timer *timers, size_t n) {
+  size_t live = 0;
+
+  for (size_t k = 0; k < n; k++) {
+    if (timers[k].index != PQUEUE_REMOVED) {
+      assert_ptr_equal(&timers[k], q->heap->items[timers[k].index]);
+      live++;
+    }
+  }
+
+  assert_int_equal(live, pqueue_size(q));
+}
+
+void do_test_pqueue_handles(size_t arity) {
+  struct pqueue_timer timers[300];
+  void *batch[200];
+  const size_t n = sizeof (timers) / sizeof (timers[0]);
+  pqueue *q = new_test_pqueue(arity, &comp_timer);
+  struct pqueue_timer *timer, *prev;
+
+  q->moved = &track_timer;
+
+  for (size_t k = 0; k < n; k++) {
+    timers[k].deadline = scrambled_key(k, n) * 10;
+    timers[k].index = PQUEUE_REMOVED;
+  }
+
+  for (size_t k = 0; k < 200; k++) {
+    batch[k] = &timers[k];
+  }
+
+  pqueue_push_array(q, 200, batch);
+  assert_timer_handles(q, timers, n);
+
+  for (size_t k = 200; k < n; k++) {
+    pqueue_push(q, &timers[k]);
+  }
+  assert_timer_handles(q, timers, n);
+
+  // Move every fifth timer earlier, to just before an existing deadline.
+  for (size_t k = 0; k < n; k += 5) {
+    timers[k].deadline = timers[k].deadline / 3 - 1;
+    pqueue_decrease_key(q, timers[k].index);
+    assert_fly_status(FLY_OK);
+  }
+  assert_timer_handles(q, timers, n);
+
+  // Cancel every seventh.
+  for (size_t k = 3; k < n; k += 7) {
+    assert_ptr_equal(&timers[k], pqueue_remove(q, timers[k].index));
+    assert_fly_status(FLY_OK);
+    assert_int_equal(PQUEUE_REMOVED, timers[k].index);
+  }
+  assert_timer_handles(q, timers, n);
+
+  for (prev = NULL; pqueue_size(q); prev = timer) {
+    timer = (struct pqueue_timer *) pqueue_pop(q);
+    assert_int_equal(PQUEUE_REMOVED, timer->index);
+
+    if (prev) {
+      assert_true(prev->deadline <= timer->deadline);
+    }
+
+    assert_timer_handles(q, timers, n);
+  }
+
+  pqueue_del(q);
+}
+
+void do_test_pqueue_oom() {
+  pqueue *q;
+
+  mockmem_queue(NULL);
+  fly_status = FLY_OK;
+  assert_null(pqueue_new(NULL));
+  assert_null(mockmem_peek());
+  assert_fly_status(FLY_E_OUT_OF_MEMORY);
+
+  // the queue itself allocates, but its arlist doesn't
+  mockmem_queue(malloc(sizeof (pqueue)));
+  mockmem_queue(NULL);
+  fly_status = FLY_OK;
+  assert_null(pqueue_new(NULL));
+  assert_null(mockmem_peek());
+  assert_fly_status(FLY_E_OUT_OF_MEMORY);
+
+  q = new_test_pqueue(PQUEUE_DEFAULT_ARITY, NULL);
+  pqueue_push(q, (void *) 1);
+  assert_int_equal(1, pqueue_size(q));
+  pqueue_del(q);
+}
+#endif
+
+TESTCALL(test_pqueue_new, do_test_pqueue_new())
+TESTCALL(test_pqueue_empty, do_test_pqueue_empty())
+TESTCALL(test_pqueue_push_pop_2, do_test_pqueue_push_pop(2, NULL))
+TESTCALL(test_pqueue_push_pop_3, do_test_pqueue_push_pop(3, NULL))
+TESTCALL(test_pqueue_push_pop_4, do_test_pqueue_push_pop(4, NULL))
+TESTCALL(test_pqueue_push_pop_8_descending,
+         do_test_pqueue_push_pop(8, &comp_pqueue_descending))
+TESTCALL(test_pqueue_push_array_2, do_test_pqueue_push_array(2))
+TESTCALL(test_pqueue_push_array_4, do_test_pqueue_push_array(4))
+TESTCALL(test_pqueue_push_array_7, do_test_pqueue_push_array(7))
+TESTCALL(test_pqueue_handles_2, do_test_pqueue_handles(2))
+TESTCALL(test_pqueue_handles_4, do_test_pqueue_handles(4))
+TESTCALL(test_pqueue_handles_5, do_test_pqueue_handles(5))
+TESTCALL(test_pqueue_oom, do_test_pqueue_oom())
+
+#ifndef _WINDLL
+#ifndef METHODS_ONLY
+#define METHODS_ONLY
+#undef TEST
+#define TEST(name, def) cmocka_unit_test(name),
+int main(void) {
+  const struct CMUnitTest tests[] = {
+#include "test_pqueue.c"
+  };
+
+  return cmocka_run_group_tests_name(
+      "flytools pqueue", tests, pqueue_setup, pqueue_teardown);
+}
+#endif  // METHODS_ONLY
+#endif
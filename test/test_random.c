@@ -422,10 +422,55 @@ void do_test_rng64_idempotency() {
   assert_int_not_equal(left, right);
   assert_rng64_not_equal(before, after, INC_UNCHANGED);
 }
+
+// Sizes on either side of every multiple of the lane count, so each possible
+// tail gets a turn.
+static const size_t rng_fill_sizes[] = {
+  0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 1000, 1001, 1002, 1003
+};
+
+void do_test_rng32_fill() {
+  uint32_t out[1003];
+  rng32 fill, serial;
+
+  rng32_set_seed(&fill, rng_seed32_make(304, 206));
+  rng32_set_seed(&serial, rng_seed32_make(304, 206));
+
+  for (size_t k = 0; k < sizeof (rng_fill_sizes) / sizeof (size_t); k++) {
+    rng_fill(&fill, out, rng_fill_sizes[k]);
+
+    for (size_t i = 0; i < rng_fill_sizes[k]; i++) {
+      assert_int_equal(rng32_next(&serial), out[i]);
+    }
+
+    assert_rng32_equal(serial, fill);
+  }
+}
+
+void do_test_rng64_fill() {
+  uint64_t out[1003];
+  rng64 fill, serial;
+  union rng_seed64 seed = rng_seed64_make64(519, 26, 550, 13);
+
+  rng64_set_seed(&fill, seed);
+  rng64_set_seed(&serial, seed);
+
+  for (size_t k = 0; k < sizeof (rng_fill_sizes) / sizeof (size_t); k++) {
+    rng_fill(&fill, out, rng_fill_sizes[k]);
+
+    for (size_t i = 0; i < rng_fill_sizes[k]; i++) {
+      assert_int_equal(rng64_next(&serial), out[i]);
+    }
+
+    assert_rng64_equal(serial, fill);
+  }
+}
 #endif
 
 TESTCALL(test_rng32_idempotency, do_test_rng32_idempotency())
 TESTCALL(test_rng64_idempotency, do_test_rng64_idempotency())
+TESTCALL(test_rng32_fill, do_test_rng32_fill())
+TESTCALL(test_rng64_fill, do_test_rng64_fill())
 
 #if __STDC_VERSION__ >= 201112L || defined(_MSC_VER)
 #ifndef METHODS_ONLY
@@ -0,0 +1,190 @@
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tests.h"
+#include "mockmem.h"
+
+#include "strbuf.h"
+#include "dict.h"
+
+#if !defined(_WINDLL) && !defined(METHODS_ONLY)
+int strbuf_setup(void **state) {
+  (void) state;
+
+  return 0;
+}
+
+int strbuf_teardown(void **state) {
+  (void) state;
+
+  return 0;
+}
+#endif
+
+#ifndef METHODS_ONLY
+void do_test_strbuf_build() {
+  arena *a = arena_new(0);
+  strbuf sb;
+  char *s, *t;
+  void *items;
+
+  strbuf_init(&sb, a);
+  strbuf_append(&sb, "hello");
+  assert_fly_status(FLY_OK);
+  items = sb.chars.items;
+
+  // nothing else comes from the arena, so it never moves
+  for (int k = 0; k < 100; k++) {
+    strbuf_appendf(&sb, ", %d", k);
+    assert_fly_status(FLY_OK);
+  }
+  assert_ptr_equal(items, sb.chars.items);
+
+  strbuf_appendn(&sb, "!!!", 1);
+  s = strbuf_finish(&sb);
+  assert_fly_status(FLY_OK);
+  assert_ptr_equal(items, s);
+  assert_int_equal(0, strbuf_size(&sb));
+  assert_int_equal(strlen(s) + 1, a->next - (uint8_t *) s);
+  assert_int_equal(0, strncmp("hello, 0, 1, 2", s, 14));
+  assert_int_equal(0, strcmp(", 98, 99!", s + strlen(s) - 9));
+
+  // the next string starts right after the last one
+  strbuf_appendf(&sb, "%s-%05u", "id", 42u);
+  t = strbuf_finish(&sb);
+  assert_string_equal("id-00042", t);
+  assert_ptr_equal(s + strlen(s) + 1, t);
+
+  // and an interrupted one moves once, keeping what it has
+  strbuf_append(&sb, "moved");
+  items = sb.chars.items;
+  arena_alloc(a, 1);
+  strbuf_appendf(&sb, " %64s", "far");
+  assert_ptr_not_equal(items, sb.chars.items);
+  t = strbuf_finish(&sb);
+  assert_int_equal(5 + 1 + 64, strlen(t));
+  assert_int_equal(0, strncmp("moved ", t, 6));
+  assert_string_equal("far", t + strlen(t) - 3);
+
+  // strings aren't max-aligned, so the ones that move leave nothing on the
+  // arena's free lists that can't hold a link
+  arena_alloc_aligned(a, 1, 1);
+  strbuf_append(&sb, "odd, and long enough to be filed");
+  items = sb.chars.items;
+  assert_true((uintptr_t) items % alignof (max_align_t));
+  for (int k = 0; k < 8; k++) {
+    arena_alloc(a, 1);
+    strbuf_appendf(&sb, "%*d", 16 << k, k);
+    assert_fly_status(FLY_OK);
+  }
+  assert_ptr_not_equal(items, sb.chars.items);
+  for (size_t i = 0; i < ARENA_SIZE_CLASSES; i++) {
+    for (void *chunk = a->free_lists[i]; chunk; chunk = *(void **) chunk) {
+      assert_int_equal(0, (uintptr_t) chunk % alignof (max_align_t));
+    }
+  }
+  t = strbuf_finish(&sb);
+  assert_int_equal(0, strncmp("odd, and long", t, 13));
+  assert_string_equal("7", t + strlen(t) - 1);
+  assert_non_null(arena_alloc(a, 32));
+
+  assert_string_equal("", strbuf_finish(&sb));
+
+  arena_del(a);
+}
+
+void do_test_strtab_intern() {
+  strtab *t = strtab_new();
+  char buf[32];
+  const char *interned[1000];
+  dict *d = dict_new();
+
+  assert_non_null(t);
+  assert_fly_status(FLY_OK);
+
+  for (int k = 0; k < 1000; k++) {
+    snprintf(buf, sizeof (buf), "key-%d", k);
+    interned[k] = strtab_intern(t, buf);
+    assert_fly_status(FLY_OK);
+    assert_ptr_not_equal(buf, interned[k]);
+    assert_string_equal(buf, interned[k]);
+  }
+
+  for (int k = 0; k < 40; k++) {
+    dict_set(d, (void *) interned[k], (void *) (uintptr_t) (k + 1));
+  }
+  assert_int_equal(1000, t->size);
+  assert_true(t->capacity >= 2000);
+
+  // the table grew along the way, but none of the strings moved
+  for (int k = 0; k < 1000; k++) {
+    snprintf(buf, sizeof (buf), "key-%d", k);
+    assert_ptr_equal(interned[k], strtab_intern(t, buf));
+    assert_ptr_equal(interned[k], strtab_lookup(t, buf));
+  }
+
+  // so a lookup by contents can go by address instead
+  for (int k = 0; k < 40; k++) {
+    snprintf(buf, sizeof (buf), "key-%d", k);
+    assert_int_equal(
+        k + 1, (uintptr_t) dict_get(d, (void *) strtab_intern(t, buf)));
+  }
+  assert_int_equal(1000, t->size);
+
+  assert_null(strtab_lookup(t, "key-1000"));
+  assert_fly_status(FLY_NOT_FOUND);
+
+  // counted strings don't need a terminator, and get one in the table
+  assert_ptr_equal(interned[12], strtab_internn(t, "key-123", 6));
+  assert_string_equal("key-", strtab_internn(t, "key-123", 4));
+  assert_int_equal(1001, t->size);
+
+  assert_null(strtab_intern(NULL, "x"));
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_null(strtab_intern(t, NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  dict_del(d);
+  strtab_del(t);
+  strtab_del(NULL);
+}
+
+void do_test_strtab_oom() {
+  mockmem_queue(NULL);
+  fly_status = FLY_OK;
+  assert_null(strtab_new());
+  assert_null(mockmem_peek());
+  assert_fly_status(FLY_E_OUT_OF_MEMORY);
+
+  // the table itself, but not its arena
+  mockmem_queue(malloc(sizeof (strtab)));
+  mockmem_queue(NULL);
+  fly_status = FLY_OK;
+  assert_null(strtab_new());
+  assert_null(mockmem_peek());
+  assert_fly_status(FLY_E_OUT_OF_MEMORY);
+}
+#endif
+
+TESTCALL(test_strbuf_build, do_test_strbuf_build())
+TESTCALL(test_strtab_intern, do_test_strtab_intern())
+TESTCALL(test_strtab_oom, do_test_strtab_oom())
+
+#ifndef _WINDLL
+#ifndef METHODS_ONLY
+#define METHODS_ONLY
+#undef TEST
+#define TEST(name, def) cmocka_unit_test(name),
+int main(void) {
+  const struct CMUnitTest tests[] = {
+#include "test_strbuf.c"
+  };
+
+  return cmocka_run_group_tests_name(
+      "flytools strbuf", tests, strbuf_setup, strbuf_teardown);
+}
+#endif  // METHODS_ONLY
+#endif
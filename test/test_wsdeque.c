@@ -0,0 +1,418 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "tests.h"
+
+#include "wsdeque.h"
+
+// The mstest harness only needs the declarations from C++.
+#ifndef __cplusplus
+#include <stdatomic.h>
+
+#ifndef __STDC_NO_THREADS__
+#include <threads.h>
+#endif
+#endif
+
+#if !defined(_WINDLL) && !defined(METHODS_ONLY)
+int wsdeque_setup(void **state) {
+  (void) state;
+
+  return 0;
+}
+
+int wsdeque_teardown(void **state) {
+  (void) state;
+
+  return 0;
+}
+#endif
+
+#ifndef METHODS_ONLY
+wsdeque *new_test_wsdeque() {
+  wsdeque *l = (wsdeque *) list_new_kind(LISTKIND_WORKSTEAL);
+
+  assert_non_null(l);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(0, l->size);
+  assert_int_equal(0, wsdeque_size(l));
+
+  return l;
+}
+
+void do_test_wsdeque_owner_and_thief_ends() {
+  wsdeque *l = new_test_wsdeque();
+
+  fly_status = FLY_OK;
+  assert_null(wsdeque_pop(l));
+  assert_fly_status(FLY_EMPTY);
+
+  fly_status = FLY_OK;
+  assert_null(wsdeque_steal(l));
+  assert_fly_status(FLY_EMPTY);
+
+  for (uintptr_t i = 1; i <= 100; i++) {
+    wsdeque_push(l, (void *) i);
+    assert_fly_status(FLY_OK);
+    assert_int_equal(i, l->size);
+  }
+
+  assert_int_equal(100, wsdeque_size(l));
+
+  // The owner works LIFO at the bottom, thieves FIFO at the top.
+  assert_int_equal(100, (uintptr_t) wsdeque_pop(l));
+  assert_fly_status(FLY_OK);
+  assert_int_equal(1, (uintptr_t) wsdeque_steal(l));
+  assert_fly_status(FLY_OK);
+  assert_int_equal(2, (uintptr_t) list_shift((list *) l));
+  assert_int_equal(99, (uintptr_t) list_pop((list *) l));
+  assert_int_equal(96, wsdeque_size(l));
+
+  for (uintptr_t i = 98; i >= 51; i--) {
+    assert_int_equal(i, (uintptr_t) wsdeque_pop(l));
+  }
+  for (uintptr_t i = 3; i <= 50; i++) {
+    assert_int_equal(i, (uintptr_t) wsdeque_steal(l));
+  }
+
+  assert_int_equal(0, wsdeque_size(l));
+  assert_null(wsdeque_pop(l));
+  assert_fly_status(FLY_EMPTY);
+  assert_null(wsdeque_steal(l));
+  assert_fly_status(FLY_EMPTY);
+
+  assert_null(wsdeque_pop(NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+  assert_null(wsdeque_steal(NULL));
+  assert_fly_status(FLY_E_NULL_PTR);
+
+  list_del((list *) l);
+}
+
+static int comp_wsdeque_descending(const void *lp, const void *rp) {
+  uintptr_t left = *(uintptr_t *) lp;
+  uintptr_t right = *(uintptr_t *) rp;
+
+  return (left < right) - (left > right);
+}
+
+static size_t wsdeque_foreach_sum = 0;
+
+static int sum_wsdeque_items(void *data, size_t i) {
+  wsdeque_foreach_sum += (uintptr_t) data * (i + 1);
+  return 0;
+}
+
+static int is_multiple_of_three(void *data) {
+  return (uintptr_t) data % 3 == 0;
+}
+
+void do_test_wsdeque_list_api() {
+  list *l = (list *) new_test_wsdeque();
+  void *more[] = { (void *) 11, (void *) 12 };
+
+  // Wrap the ring by stealing from the top and refilling both ends.
+  for (uintptr_t i = 1; i <= 6; i++) {
+    list_push(l, (void *) i);
+  }
+  assert_int_equal(1, (uintptr_t) wsdeque_steal((wsdeque *) l));
+  assert_int_equal(2, (uintptr_t) wsdeque_steal((wsdeque *) l));
+
+  list_push(l, (void *) 7);
+  list_push(l, (void *) 8);
+  list_unshift(l, (void *) 9);
+  list_unshift(l, (void *) 10);
+  list_append_array(l, 2, more);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(10, l->size);
+
+  uintptr_t expected[] = { 10, 9, 3, 4, 5, 6, 7, 8, 11, 12 };
+
+  for (size_t i = 0; i < 10; i++) {
+    assert_int_equal(expected[i], (uintptr_t) list_get(l, i));
+  }
+  assert_int_equal(12, (uintptr_t) list_get(l, -1));
+
+  wsdeque_foreach_sum = 0;
+  list_foreach(l, &sum_wsdeque_items);
+  size_t sum = 0;
+  for (size_t i = 0; i < 10; i++) {
+    sum += expected[i] * (i + 1);
+  }
+  assert_int_equal(sum, wsdeque_foreach_sum);
+
+  list_sort(l, &comp_wsdeque_descending);
+  assert_fly_status(FLY_OK);
+
+  for (uintptr_t i = 0; i < 10; i++) {
+    assert_int_equal(12 - i, (uintptr_t) list_get(l, i));
+  }
+
+  list_sort_stable(l, NULL);
+  assert_fly_status(FLY_OK);
+
+  for (uintptr_t i = 0; i < 10; i++) {
+    assert_int_equal(i + 3, (uintptr_t) list_get(l, i));
+  }
+
+  assert_int_equal(8, (uintptr_t) list_select_nth(
+        l, 4, &comp_wsdeque_descending));
+  assert_fly_status(FLY_OK);
+  assert_int_equal(8, (uintptr_t) list_get(l, 4));
+
+  list_partial_sort(l, 3, &comp_wsdeque_descending);
+  assert_fly_status(FLY_OK);
+
+  for (uintptr_t i = 0; i < 3; i++) {
+    assert_int_equal(12 - i, (uintptr_t) list_get(l, i));
+  }
+
+  list_sort(l, &comp_wsdeque_descending);
+
+  assert_int_equal(4, list_discard_all(l, &is_multiple_of_three, NULL));
+  assert_int_equal(6, l->size);
+  assert_int_equal(6, wsdeque_size((wsdeque *) l));
+  assert_int_equal(11, (uintptr_t) list_get(l, 0));
+  assert_int_equal(4, (uintptr_t) list_get(l, -1));
+
+  // Owner operations still work after the ring has been rearranged.
+  assert_int_equal(4, (uintptr_t) list_pop(l));
+  assert_int_equal(11, (uintptr_t) wsdeque_steal((wsdeque *) l));
+  wsdeque_push((wsdeque *) l, (void *) 13);
+  assert_int_equal(13, (uintptr_t) list_get(l, -1));
+
+  list *other = (list *) new_test_wsdeque();
+  list_push(other, (void *) 14);
+  list_concat(l, other);
+  assert_int_equal(6, l->size);
+  assert_int_equal(14, (uintptr_t) list_get(l, -1));
+  assert_int_equal(1, other->size);
+
+  list_del(other);
+
+  // The batch calls move both ends of a ring that has wrapped.
+  void *before[6], *out[6];
+
+  for (size_t i = 0; i < 6; i++) {
+    before[i] = list_get(l, i);
+  }
+
+  assert_int_equal(2, list_shift_many(l, 2, out));
+  assert_int_equal(3, list_pop_many(l, 3, out + 2));
+  assert_fly_status(FLY_OK);
+  assert_int_equal(1, wsdeque_size((wsdeque *) l));
+  assert_memory_equal(before, out, 2 * sizeof (void *));
+  assert_memory_equal(before + 3, out + 2, 3 * sizeof (void *));
+
+  list_unshift_array(l, 5, out);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(6, list_drain_into_array(l, out));
+  assert_int_equal(0, wsdeque_size((wsdeque *) l));
+  assert_memory_equal(before, out, 2 * sizeof (void *));
+  assert_memory_equal(before + 3, out + 2, 3 * sizeof (void *));
+  assert_ptr_equal(before[2], out[5]);
+
+  list_unshift_array(l, 6, out);
+  list_insert(l, 3, (void *) 15);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(7, wsdeque_size((wsdeque *) l));
+  assert_int_equal(15, (uintptr_t) list_get(l, 3));
+  assert_ptr_equal(out[3], list_get(l, 4));
+  assert_ptr_equal(out[2], list_remove_at(l, 2));
+  assert_int_equal(15, (uintptr_t) list_get(l, 2));
+  assert_int_equal(6, wsdeque_size((wsdeque *) l));
+
+  for (size_t i = 0; i < 6; i++) {
+    before[i] = list_get(l, i);
+  }
+
+  list_reverse(l);
+  list_rotate(l, 2);
+  assert_ptr_equal(before[3], list_get(l, 0));
+  assert_ptr_equal(before[4], list_get(l, -1));
+  list_rotate(l, -2);
+  list_reverse(l);
+
+  list *slice = list_slice(l, 1, 4);
+  assert_non_null(slice);
+  assert_ptr_equal(LISTKIND_WORKSTEAL, slice->kind);
+  assert_int_equal(3, slice->size);
+  assert_ptr_equal(before[3], list_get(slice, 2));
+
+  list_splice(l, 2, slice, 0, 3);
+  assert_fly_status(FLY_OK);
+  assert_int_equal(9, wsdeque_size((wsdeque *) l));
+  assert_int_equal(0, wsdeque_size((wsdeque *) slice));
+  assert_ptr_equal(before[1], list_get(l, 2));
+  assert_ptr_equal(before[2], list_get(l, 5));
+  list_del(slice);
+
+  list_del(l);
+}
+
+// Thieves leave the top partway round the ring, so later pushes wrap and the
+// cursor has two runs to read.
+void do_test_wsdeque_iter() {
+  wsdeque *l = new_test_wsdeque();
+  list_iter it;
+  void *item;
+  uintptr_t next = 1;
+  size_t n = 0;
+
+  for (uintptr_t k = 1; k <= 4; k++) {
+    wsdeque_push(l, (void *) k);
+  }
+  for (int k = 0; k < 3; k++) {
+    wsdeque_steal(l);
+  }
+
+  const size_t capacity = l->ring->mask + 1;
+
+  for (uintptr_t k = 5; wsdeque_size(l) < capacity - 1; k++) {
+    wsdeque_push(l, (void *) k);
+  }
+  assert_int_equal(capacity, l->ring->mask + 1);
+
+  it = list_iter_of((list *) l);
+  assert_fly_status(FLY_OK);
+  while (list_iter_has_next(&it)) {
+    assert_int_equal(4 + n++, (uintptr_t) list_iter_next(&it));
+  }
+  assert_int_equal(capacity - 1, n);
+
+  // reading doesn't move the items, so the thieves' end is where it was
+  assert_int_equal(3, atomic_load(&l->top));
+
+  LIST_FOR_EACH(l, item) {
+    assert_int_equal(3 + next++, (uintptr_t) item);
+  }
+  assert_int_equal(capacity, next);
+
+  // nor do the queries, which read both runs where they are
+  const uintptr_t last = capacity + 2;
+  size_t sum = 0;
+
+  assert_int_equal(0, list_index_of((list *) l, (void *) 4));
+  assert_int_equal(capacity - 2, list_index_of((list *) l, (void *) last));
+  assert_int_equal(SIZE_MAX, list_index_of((list *) l, (void *) 3));
+  assert_fly_status(FLY_NOT_FOUND);
+  assert_int_equal(1, list_count_of((list *) l, (void *) last));
+  assert_int_equal(0, list_count_of((list *) l, (void *) 1));
+  assert_int_equal(
+      6, (uintptr_t) list_find_first((list *) l, &is_multiple_of_three));
+  assert_fly_status(FLY_OK);
+
+  for (uintptr_t k = 4; k <= last; k++) {
+    sum += k * (k - 3);
+  }
+  wsdeque_foreach_sum = 0;
+  list_foreach((list *) l, &sum_wsdeque_items);
+  assert_int_equal(sum, wsdeque_foreach_sum);
+  assert_int_equal(3, atomic_load(&l->top));
+
+  list_del((list *) l);
+}
+
+#ifndef __STDC_NO_THREADS__
+#define WSDEQUE_STRESS_ITEMS 200000
+#define WSDEQUE_STRESS_THIEVES 3
+
+struct wsdeque_stress {
+  wsdeque *l;
+  atomic_bool done;
+  atomic_size_t taken;
+  atomic_uint_fast64_t sum;
+};
+
+static int wsdeque_thief(void *arg) {
+  struct wsdeque_stress *stress = (struct wsdeque_stress *) arg;
+  size_t taken = 0;
+  uint_fast64_t sum = 0;
+  void *data;
+
+  while (!atomic_load(&stress->done) || wsdeque_size(stress->l)) {
+    if ((data = wsdeque_steal(stress->l))) {
+      sum += (uintptr_t) data;
+      taken++;
+    }
+  }
+
+  atomic_fetch_add(&stress->taken, taken);
+  atomic_fetch_add(&stress->sum, sum);
+  return 0;
+}
+
+void do_test_wsdeque_concurrent_steal() {
+  struct wsdeque_stress stress;
+  thrd_t thieves[WSDEQUE_STRESS_THIEVES];
+  size_t taken = 0;
+  uint_fast64_t sum = 0;
+  void *data;
+
+  stress.l = new_test_wsdeque();
+  atomic_init(&stress.done, false);
+  atomic_init(&stress.taken, 0);
+  atomic_init(&stress.sum, 0);
+
+  for (int i = 0; i < WSDEQUE_STRESS_THIEVES; i++) {
+    assert_int_equal(
+        thrd_success, thrd_create(&thieves[i], &wsdeque_thief, &stress));
+  }
+
+  for (uintptr_t i = 1; i <= WSDEQUE_STRESS_ITEMS; i++) {
+    wsdeque_push(stress.l, (void *) i);
+
+    if (i % 3 == 0 && (data = wsdeque_pop(stress.l))) {
+      sum += (uintptr_t) data;
+      taken++;
+    }
+  }
+
+  while ((data = wsdeque_pop(stress.l))) {
+    sum += (uintptr_t) data;
+    taken++;
+  }
+
+  atomic_store(&stress.done, true);
+
+  for (int i = 0; i < WSDEQUE_STRESS_THIEVES; i++) {
+    thrd_join(thieves[i], NULL);
+  }
+
+  // Every item must have been taken exactly once.
+  assert_int_equal(WSDEQUE_STRESS_ITEMS, taken + atomic_load(&stress.taken));
+  assert_int_equal(
+      (uint_fast64_t) WSDEQUE_STRESS_ITEMS * (WSDEQUE_STRESS_ITEMS + 1) / 2,
+      sum + atomic_load(&stress.sum));
+
+  list_del((list *) stress.l);
+}
+
+#undef WSDEQUE_STRESS_ITEMS
+#undef WSDEQUE_STRESS_THIEVES
+#endif  // __STDC_NO_THREADS__
+#endif
+
+TESTCALL(test_wsdeque_owner_and_thief_ends,
+         do_test_wsdeque_owner_and_thief_ends())
+TESTCALL(test_wsdeque_list_api, do_test_wsdeque_list_api())
+TESTCALL(test_wsdeque_iter, do_test_wsdeque_iter())
+#ifndef __STDC_NO_THREADS__
+TESTCALL(test_wsdeque_concurrent_steal, do_test_wsdeque_concurrent_steal())
+#endif
+
+#ifndef _WINDLL
+#ifndef METHODS_ONLY
+#define METHODS_ONLY
+#undef TEST
+#define TEST(name, def) cmocka_unit_test(name),
+int main(void) {
+  const struct CMUnitTest tests[] = {
+#include "test_wsdeque.c"
+  };
+
+  return cmocka_run_group_tests_name(
+      "flytools wsdeque", tests, wsdeque_setup, wsdeque_teardown);
+}
+#endif  // METHODS_ONLY
+#endif